@@ -28,7 +28,7 @@ struct lib_counter_config {
 	enum lib_counter_config_sync sync;
 	enum {
 		COUNTER_ARITHMETIC_MODULAR,
-		COUNTER_ARITHMETIC_SATURATE,	/* TODO */
+		COUNTER_ARITHMETIC_SATURATE,
 	} arithmetic;
 	enum {
 		COUNTER_SIZE_8_BIT	= 1,
@@ -18,8 +18,28 @@
 #include <wrapper/compiler_attributes.h>
 #include <wrapper/limits.h>
 
+/*
+ * Saturating addition of @v to @old, clamped to [@min, @max]. Clamping
+ * is reported as an overflow or underflow.
+ */
+static __always_inline int64_t lttng_counter_saturate_add(int64_t old, int64_t v,
+				       int64_t min, int64_t max,
+				       bool *overflow, bool *underflow)
+{
+	if (v > 0 && old > max - v) {
+		*overflow = true;
+		return max;
+	}
+	if (v < 0 && old < min - v) {
+		*underflow = true;
+		return min;
+	}
+	return old + v;
+}
+
 /*
  * Using unsigned arithmetic because overflow is defined.
+ * Saturating counters do not carry to the global counters.
  */
 static __always_inline int __lttng_counter_add(const struct lib_counter_config *config,
 				       enum lib_counter_config_alloc alloc,
@@ -56,6 +76,20 @@ static __always_inline int __lttng_counter_add(const struct lib_counter_config *
 		int8_t global_sum_step = counter->global_sum_step.s8;
 
 		res = *int_p;
+		if (config->arithmetic == COUNTER_ARITHMETIC_SATURATE) {
+			do {
+				old = res;
+				overflow = false;
+				underflow = false;
+				n = (int8_t) lttng_counter_saturate_add(old, v, S8_MIN, S8_MAX,
+						&overflow, &underflow);
+				if (sync == COUNTER_SYNC_PER_CPU)
+					res = cmpxchg_local(int_p, old, n);
+				else
+					res = cmpxchg(int_p, old, n);
+			} while (old != res);
+			break;
+		}
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
@@ -97,6 +131,20 @@ static __always_inline int __lttng_counter_add(const struct lib_counter_config *
 		int16_t global_sum_step = counter->global_sum_step.s16;
 
 		res = *int_p;
+		if (config->arithmetic == COUNTER_ARITHMETIC_SATURATE) {
+			do {
+				old = res;
+				overflow = false;
+				underflow = false;
+				n = (int16_t) lttng_counter_saturate_add(old, v, S16_MIN, S16_MAX,
+						&overflow, &underflow);
+				if (sync == COUNTER_SYNC_PER_CPU)
+					res = cmpxchg_local(int_p, old, n);
+				else
+					res = cmpxchg(int_p, old, n);
+			} while (old != res);
+			break;
+		}
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
@@ -138,6 +186,20 @@ static __always_inline int __lttng_counter_add(const struct lib_counter_config *
 		int32_t global_sum_step = counter->global_sum_step.s32;
 
 		res = *int_p;
+		if (config->arithmetic == COUNTER_ARITHMETIC_SATURATE) {
+			do {
+				old = res;
+				overflow = false;
+				underflow = false;
+				n = (int32_t) lttng_counter_saturate_add(old, v, S32_MIN, S32_MAX,
+						&overflow, &underflow);
+				if (sync == COUNTER_SYNC_PER_CPU)
+					res = cmpxchg_local(int_p, old, n);
+				else
+					res = cmpxchg(int_p, old, n);
+			} while (old != res);
+			break;
+		}
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
@@ -180,6 +242,20 @@ static __always_inline int __lttng_counter_add(const struct lib_counter_config *
 		int64_t global_sum_step = counter->global_sum_step.s64;
 
 		res = *int_p;
+		if (config->arithmetic == COUNTER_ARITHMETIC_SATURATE) {
+			do {
+				old = res;
+				overflow = false;
+				underflow = false;
+				n = (int64_t) lttng_counter_saturate_add(old, v, S64_MIN, S64_MAX,
+						&overflow, &underflow);
+				if (sync == COUNTER_SYNC_PER_CPU)
+					res = cmpxchg_local(int_p, old, n);
+				else
+					res = cmpxchg(int_p, old, n);
+			} while (old != res);
+			break;
+		}
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
@@ -38,6 +38,15 @@ enum lib_counter_arithmetic {
 	LIB_COUNTER_ARITHMETIC_SATURATE,
 };
 
+/* Layout of the counter arrays mapped by lttng_counter_map(). */
+struct lib_counter_map_layout {
+	size_t elem_size;	/* Size of a counter, in bytes. */
+	size_t nr_elem;		/* Number of counters in each array. */
+	size_t array_len;	/* Length of each array mapping, page aligned. */
+	unsigned int nr_cpus;	/* Number of per-cpu arrays, mapped first. */
+	bool global;		/* Global array mapped after the per-cpu arrays. */
+};
+
 struct lib_counter {
 	size_t nr_dimensions;
 	int64_t allocated_elem;
@@ -15,6 +15,8 @@
 #include <counter/config.h>
 #include <counter/counter-types.h>
 
+struct vm_area_struct;
+
 /* max_nr_elem is for each dimension. */
 struct lib_counter *lttng_counter_create(const struct lib_counter_config *config,
 					 size_t nr_dimensions,
@@ -43,4 +45,25 @@ int lttng_counter_clear(const struct lib_counter_config *config,
 			struct lib_counter *counter,
 			const size_t *dimension_indexes);
 
+/* Ranges of counters, by linear index (the last dimension varies fastest). */
+int lttng_counter_read_range(const struct lib_counter_config *config,
+			     struct lib_counter *counter,
+			     size_t index, size_t nr_elem, int cpu,
+			     int64_t *values, bool *overflow, bool *underflow);
+int lttng_counter_aggregate_range(const struct lib_counter_config *config,
+				  struct lib_counter *counter,
+				  size_t index, size_t nr_elem,
+				  int64_t *values, bool *overflow, bool *underflow);
+int lttng_counter_exchange_range(const struct lib_counter_config *config,
+				 struct lib_counter *counter,
+				 size_t index, size_t nr_elem,
+				 int64_t *values, bool *overflow, bool *underflow);
+
+int lttng_counter_get_map_layout(const struct lib_counter_config *config,
+				 struct lib_counter *counter,
+				 struct lib_counter_map_layout *map_layout);
+int lttng_counter_map(const struct lib_counter_config *config,
+		      struct lib_counter *counter,
+		      struct vm_area_struct *vma);
+
 #endif /* _LTTNG_COUNTER_H */
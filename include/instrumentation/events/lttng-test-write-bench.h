@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM lttng_test_write_bench
+
+#if !defined(LTTNG_TRACE_LTTNG_TEST_WRITE_BENCH_H) || defined(TRACE_HEADER_MULTI_READ)
+#define LTTNG_TRACE_LTTNG_TEST_WRITE_BENCH_H
+
+#include <lttng/tracepoint-event.h>
+#include <linux/types.h>
+
+/* Fixed-size payloads: their size is known at compile time. */
+LTTNG_TRACEPOINT_EVENT(lttng_test_write_bench_u8,
+	TP_PROTO(uint8_t value),
+	TP_ARGS(value),
+	TP_FIELDS(
+		ctf_integer(uint8_t, payload, value)
+	)
+)
+
+LTTNG_TRACEPOINT_EVENT(lttng_test_write_bench_u64,
+	TP_PROTO(uint64_t value),
+	TP_ARGS(value),
+	TP_FIELDS(
+		ctf_integer(uint64_t, payload, value)
+	)
+)
+
+LTTNG_TRACEPOINT_EVENT(lttng_test_write_bench_array64,
+	TP_PROTO(const uint64_t *values),
+	TP_ARGS(values),
+	TP_FIELDS(
+		ctf_array(uint64_t, payload, values, 8)
+	)
+)
+
+/* Dynamic-size payload, which may cross pages. */
+LTTNG_TRACEPOINT_EVENT(lttng_test_write_bench_sequence,
+	TP_PROTO(const char *buf, size_t len),
+	TP_ARGS(buf, len),
+	TP_FIELDS(
+		ctf_sequence(char, payload, buf, size_t, len)
+	)
+)
+
+#endif /* LTTNG_TRACE_LTTNG_TEST_WRITE_BENCH_H */
+
+/* This part must be outside protection */
+#include <lttng/define_trace.h>
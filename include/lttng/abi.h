@@ -18,7 +18,7 @@
  * should be increased when an incompatible ABI change is done.
  */
 #define LTTNG_KERNEL_ABI_MAJOR_VERSION		2
-#define LTTNG_KERNEL_ABI_MINOR_VERSION		6
+#define LTTNG_KERNEL_ABI_MINOR_VERSION		18
 
 #define LTTNG_KERNEL_ABI_SYM_NAME_LEN		256
 #define LTTNG_KERNEL_ABI_SESSION_NAME_LEN	256
@@ -47,22 +47,56 @@ enum lttng_kernel_abi_instrumentation {
 enum lttng_kernel_abi_output {
 	LTTNG_KERNEL_ABI_SPLICE	= 0,
 	LTTNG_KERNEL_ABI_MMAP	= 1,
+	LTTNG_KERNEL_ABI_READ	= 2,
 };
 
 /*
  * LTTng DebugFS ABI structures.
  */
-#define LTTNG_KERNEL_ABI_CHANNEL_PADDING	LTTNG_KERNEL_ABI_SYM_NAME_LEN + 32
+/*
+ * Channel creation flags.
+ */
+enum lttng_kernel_abi_channel_flags {
+	/* Map each sub-buffer contiguously (vmap ring buffer backend). */
+	LTTNG_KERNEL_ABI_CHANNEL_FLAG_VMAP	= (1U << 0),
+	/* Use the preallocated static region (static ring buffer backend). */
+	LTTNG_KERNEL_ABI_CHANNEL_FLAG_STATIC	= (1U << 1),
+	/* Scale the read timer interval with the buffer fill rate. */
+	LTTNG_KERNEL_ABI_CHANNEL_FLAG_ADAPTIVE_READ_TIMER	= (1U << 2),
+};
+
+#define LTTNG_KERNEL_ABI_CHANNEL_PADDING	LTTNG_KERNEL_ABI_SYM_NAME_LEN + 28
 struct lttng_kernel_abi_channel {
 	uint64_t subbuf_size;			/* in bytes */
 	uint64_t num_subbuf;
 	unsigned int switch_timer_interval;	/* usecs */
 	unsigned int read_timer_interval;	/* usecs */
-	uint32_t output;			/* enum lttng_kernel_abi_output (splice, mmap) */
+	uint32_t output;			/* enum lttng_kernel_abi_output (splice, mmap, read) */
 	int overwrite;				/* 1: overwrite, 0: discard */
+	uint32_t flags;				/* enum lttng_kernel_abi_channel_flags */
 	char padding[LTTNG_KERNEL_ABI_CHANNEL_PADDING];
 } __attribute__((packed));
 
+/*
+ * Header kept in the first page of the static ring buffer region. It
+ * describes the buffers of the last channel which claimed the region,
+ * so that they can be recovered from a crash dump or, after kexec,
+ * read from /proc/lttng-static-region. The buffer of each cpu takes
+ * buf_len / nr_cpus bytes, starting buf_offset bytes into the region,
+ * in cpu number order.
+ */
+#define LTTNG_KERNEL_ABI_STATIC_REGION_MAGIC	0x4c54544e47535442ULL	/* "LTTNGSTB" */
+struct lttng_kernel_abi_static_region_header {
+	uint64_t magic;
+	uint64_t seq;			/* Incremented each time a channel claims the region. */
+	uint64_t buf_offset;		/* in bytes */
+	uint64_t buf_len;		/* in bytes, all cpus */
+	uint64_t subbuf_size;		/* in bytes */
+	uint64_t num_subbuf;		/* per cpu, including the reader sub-buffer */
+	uint32_t nr_cpus;
+	uint32_t in_use;		/* 1 while a channel owns the region */
+} __attribute__((packed));
+
 enum lttng_kernel_abi_kretprobe_entryexit {
 	LTTNG_KERNEL_ABI_KRETPROBE_ENTRYEXIT = 0,
 	LTTNG_KERNEL_ABI_KRETPROBE_ENTRY = 1,
@@ -119,7 +153,7 @@ enum lttng_kernel_abi_syscall_abi {
 
 enum lttng_kernel_abi_syscall_match {
 	LTTNG_KERNEL_ABI_SYSCALL_MATCH_NAME = 0,
-	LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR = 1,		/* Not implemented. */
+	LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR = 1,
 };
 
 struct lttng_kernel_abi_syscall {
@@ -132,6 +166,9 @@ struct lttng_kernel_abi_syscall {
 
 /*
  * For syscall tracing, name = "*" means "enable all".
+ * Native and compat system call numbers differ: matching by number
+ * (LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR) is the only case where a specific
+ * syscall ABI can be selected.
  */
 #define LTTNG_KERNEL_ABI_EVENT_PADDING1	8
 #define LTTNG_KERNEL_ABI_EVENT_PADDING2	LTTNG_KERNEL_ABI_SYM_NAME_LEN + 32
@@ -164,11 +201,15 @@ struct lttng_kernel_abi_event_notifier {
 
 enum lttng_kernel_abi_counter_arithmetic {
 	LTTNG_KERNEL_ABI_COUNTER_ARITHMETIC_MODULAR = 0,
+	/* Counters clamp at their limits and report overflow/underflow. */
+	LTTNG_KERNEL_ABI_COUNTER_ARITHMETIC_SATURATE = 1,
 };
 
 enum lttng_kernel_abi_counter_bitness {
 	LTTNG_KERNEL_ABI_COUNTER_BITNESS_32 = 0,
 	LTTNG_KERNEL_ABI_COUNTER_BITNESS_64 = 1,
+	LTTNG_KERNEL_ABI_COUNTER_BITNESS_8 = 2,		/* Saturating arithmetic only. */
+	LTTNG_KERNEL_ABI_COUNTER_BITNESS_16 = 3,	/* Saturating arithmetic only. */
 };
 
 struct lttng_kernel_abi_counter_dimension {
@@ -222,6 +263,125 @@ struct lttng_kernel_abi_counter_clear {
 	char padding[LTTNG_KERNEL_ABI_COUNTER_CLEAR_PADDING];
 } __attribute__((packed));
 
+/*
+ * Bulk counter operations act on a range of counters identified by
+ * their linear index: the dimension indexes weighted by the product of
+ * the sizes of the following dimensions (the last dimension varies
+ * fastest). Exchange aggregates the counters like aggregate, atomically
+ * resetting each of them, so that no increment is lost or counted
+ * twice across successive exchanges. Exchange fails with -EFAULT
+ * before resetting counters whose values cannot be written out, unless
+ * the values array is unmapped concurrently.
+ */
+#define LTTNG_KERNEL_ABI_COUNTER_BULK_PADDING 32
+struct lttng_kernel_abi_counter_bulk {
+	uint64_t index;		/* Linear index of the first counter. */
+	uint64_t nr_elem;	/* Number of counters. */
+	uint64_t values;	/* Array of nr_elem struct lttng_kernel_abi_counter_value (output). */
+	int32_t cpu;		/* Read: -1 for global counter, >= 0 for specific cpu. */
+	char padding[LTTNG_KERNEL_ABI_COUNTER_BULK_PADDING];
+} __attribute__((packed));
+
+/*
+ * The counter file descriptor can be mapped read-only, one counter
+ * array per mapping: per-cpu array N at offset N * array_len, followed
+ * by the global array, if any. Each array holds the counters in linear
+ * index order.
+ */
+#define LTTNG_KERNEL_ABI_COUNTER_MAP_LAYOUT_PADDING 32
+struct lttng_kernel_abi_counter_map_layout {
+	uint32_t elem_size;	/* Size of a counter, in bytes. */
+	uint32_t nr_cpus;	/* Number of per-cpu arrays. */
+	uint64_t nr_elem;	/* Number of counters in each array. */
+	uint64_t array_len;	/* Length of each array mapping, in bytes. */
+	uint8_t global;		/* Global array mapped after the per-cpu arrays. */
+	char padding[LTTNG_KERNEL_ABI_COUNTER_MAP_LAYOUT_PADDING];
+} __attribute__((packed));
+
+/*
+ * Keyed aggregation map: a counter whose slots are indexed by the
+ * values captured by the event notifiers it is attached to, rather than
+ * by a dimension index. Each event notifier hit increments the counter
+ * of the slot holding its key instead of sending a notification. The
+ * counter values are read with the counter file descriptor ioctls and
+ * mmap, the slot keys with LTTNG_KERNEL_ABI_AGGREGATION_MAP_READ_KEYS.
+ */
+#define LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX	4
+
+#define LTTNG_KERNEL_ABI_AGGREGATION_MAP_CONF_PADDING 32
+struct lttng_kernel_abi_aggregation_map_conf {
+	uint32_t arithmetic;	/* enum lttng_kernel_abi_counter_arithmetic */
+	uint32_t bitness;	/* enum lttng_kernel_abi_counter_bitness */
+	uint64_t nr_slots;	/* Power of two. */
+	char padding[LTTNG_KERNEL_ABI_AGGREGATION_MAP_CONF_PADDING];
+} __attribute__((packed));
+
+#define LTTNG_KERNEL_ABI_AGGREGATE_PADDING 32
+struct lttng_kernel_abi_aggregate {
+	int32_t counter_fd;	/* Aggregation map or histogram counter file descriptor. */
+	char padding[LTTNG_KERNEL_ABI_AGGREGATE_PADDING];
+} __attribute__((packed));
+
+/*
+ * Key of an aggregation map slot. Integer and enumeration captures are
+ * keyed by their value, kernel string captures by their hash. Captures
+ * which could not be evaluated, user-space strings and sequences have a
+ * nil value, flagged in nil_mask (bit N for capture N).
+ *
+ * A string key only holds the 32-bit jhash of the string: distinct
+ * strings may collide into the same key, and the string itself cannot
+ * be recovered from the key.
+ *
+ * A key may be held by more than one slot when it is first hit
+ * concurrently on several CPUs: the counters of such slots add up.
+ */
+struct lttng_kernel_abi_aggregation_map_key {
+	uint8_t used;
+	uint8_t nil_mask;
+	uint64_t values[LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX];
+} __attribute__((packed));
+
+#define LTTNG_KERNEL_ABI_AGGREGATION_MAP_READ_KEYS_PADDING 32
+struct lttng_kernel_abi_aggregation_map_read_keys {
+	uint64_t index;		/* First slot. */
+	uint64_t nr_slots;	/* Number of slots. */
+	uint64_t keys;		/* Array of nr_slots struct lttng_kernel_abi_aggregation_map_key (output). */
+	uint64_t dropped;	/* Hits without a free slot for their key (output). */
+	char padding[LTTNG_KERNEL_ABI_AGGREGATION_MAP_READ_KEYS_PADDING];
+} __attribute__((packed));
+
+/*
+ * Histogram: a counter whose buckets are indexed by the value of the
+ * single capture of the event notifiers it is attached to. Each event
+ * notifier hit increments the bucket of its value instead of sending a
+ * notification. Hits whose capture does not evaluate to an integer or
+ * enumeration are not counted. The buckets are read with the counter
+ * file descriptor ioctls and mmap.
+ */
+enum lttng_kernel_abi_histogram_type {
+	/*
+	 * Bucket 0 counts values below 1, bucket N values in
+	 * [2^(N-1), 2^N).
+	 */
+	LTTNG_KERNEL_ABI_HISTOGRAM_LOG2 = 0,
+	/*
+	 * Bucket 0 counts values below min, bucket N values in
+	 * [min + (N-1) * width, min + N * width).
+	 */
+	LTTNG_KERNEL_ABI_HISTOGRAM_LINEAR = 1,
+};
+
+#define LTTNG_KERNEL_ABI_HISTOGRAM_CONF_PADDING 32
+struct lttng_kernel_abi_histogram_conf {
+	uint32_t arithmetic;	/* enum lttng_kernel_abi_counter_arithmetic */
+	uint32_t bitness;	/* enum lttng_kernel_abi_counter_bitness */
+	uint32_t type;		/* enum lttng_kernel_abi_histogram_type */
+	uint32_t nr_buckets;	/* The last bucket also counts all larger values. */
+	int64_t min;		/* Linear only. */
+	uint64_t width;		/* Linear only. */
+	char padding[LTTNG_KERNEL_ABI_HISTOGRAM_CONF_PADDING];
+} __attribute__((packed));
+
 #define LTTNG_KERNEL_ABI_EVENT_NOTIFIER_NOTIFICATION_PADDING 32
 struct lttng_kernel_abi_event_notifier_notification {
 	uint64_t token;
@@ -229,6 +389,47 @@ struct lttng_kernel_abi_event_notifier_notification {
 	char padding[LTTNG_KERNEL_ABI_EVENT_NOTIFIER_NOTIFICATION_PADDING];
 } __attribute__((packed));
 
+/*
+ * Filter evaluation statistics of an event, summed over all CPUs. The
+ * evaluation cost is only measured on a sample of the evaluations:
+ * sampled_cycles is the cumulative cost of the sampled_evaluations, in
+ * CPU cycles.
+ */
+#define LTTNG_KERNEL_ABI_EVENT_FILTER_STATS_PADDING 32
+struct lttng_kernel_abi_event_filter_stats {
+	uint64_t evaluations;
+	uint64_t accepts;
+	uint64_t rejects;
+	uint64_t sampled_evaluations;
+	uint64_t sampled_cycles;
+	char padding[LTTNG_KERNEL_ABI_EVENT_FILTER_STATS_PADDING];
+} __attribute__((packed));
+
+enum lttng_kernel_abi_ring_buffer_packet_flags {
+	/* Consume the packet held by the previous get before getting the next. */
+	LTTNG_KERNEL_ABI_RING_BUFFER_PACKET_FLAG_PUT_PREVIOUS	= (1U << 0),
+};
+
+/*
+ * Descriptor of the next packet of a stream, gathering what would
+ * otherwise take one ioctl per field.
+ */
+#define LTTNG_KERNEL_ABI_RING_BUFFER_PACKET_PADDING 32
+struct lttng_kernel_abi_ring_buffer_packet {
+	uint32_t flags;			/* enum lttng_kernel_abi_ring_buffer_packet_flags (input) */
+	uint32_t reserved;
+	uint64_t subbuf_size;		/* in bytes, without padding */
+	uint64_t padded_subbuf_size;	/* in bytes, page-size padded */
+	uint64_t mmap_read_offset;	/* offset of the sub-buffer in mmap (mmap output only) */
+	uint64_t timestamp_begin;
+	uint64_t timestamp_end;
+	uint64_t events_discarded;
+	uint64_t content_size;		/* in bits */
+	uint64_t packet_size;		/* in bits */
+	uint64_t seq_num;
+	char padding[LTTNG_KERNEL_ABI_RING_BUFFER_PACKET_PADDING];
+} __attribute__((packed));
+
 struct lttng_kernel_abi_tracer_version {
 	uint32_t major;
 	uint32_t minor;
@@ -401,6 +602,7 @@ struct lttng_kernel_abi_tracker_args {
 	_IOW(0xF6, 0x63, struct lttng_kernel_abi_event)
 #define LTTNG_KERNEL_ABI_SYSCALL_MASK		\
 	_IOWR(0xF6, 0x64, struct lttng_kernel_abi_syscall_mask)
+#define LTTNG_KERNEL_ABI_CHANNEL_READY_SET	_IO(0xF6, 0x65)
 
 /* Event and Channel FD ioctl */
 /* lttng/abi-old.h reserve 0x70. */
@@ -419,6 +621,8 @@ struct lttng_kernel_abi_tracker_args {
 /* Event and Event notifier FD ioctl */
 #define LTTNG_KERNEL_ABI_FILTER			_IO(0xF6, 0x90)
 #define LTTNG_KERNEL_ABI_ADD_CALLSITE		_IO(0xF6, 0x91)
+#define LTTNG_KERNEL_ABI_EVENT_FILTER_STATS	\
+	_IOR(0xF6, 0x92, struct lttng_kernel_abi_event_filter_stats)
 
 /* Session FD ioctl (continued) */
 #define LTTNG_KERNEL_ABI_SESSION_LIST_TRACKER_IDS	\
@@ -433,9 +637,15 @@ struct lttng_kernel_abi_tracker_args {
 	_IOW(0xF6, 0xB0, struct lttng_kernel_abi_event_notifier)
 #define LTTNG_KERNEL_ABI_EVENT_NOTIFIER_GROUP_NOTIFICATION_FD \
 	_IO(0xF6, 0xB1)
+#define LTTNG_KERNEL_ABI_AGGREGATION_MAP \
+	_IOW(0xF6, 0xB2, struct lttng_kernel_abi_aggregation_map_conf)
+#define LTTNG_KERNEL_ABI_HISTOGRAM \
+	_IOW(0xF6, 0xB3, struct lttng_kernel_abi_histogram_conf)
 
 /* Event notifier file descriptor ioctl */
 #define LTTNG_KERNEL_ABI_CAPTURE			_IO(0xF6, 0xB8)
+#define LTTNG_KERNEL_ABI_AGGREGATE \
+	_IOW(0xF6, 0xB9, struct lttng_kernel_abi_aggregate)
 
 /* Counter file descriptor ioctl */
 #define LTTNG_KERNEL_ABI_COUNTER_READ \
@@ -444,6 +654,16 @@ struct lttng_kernel_abi_tracker_args {
 	_IOWR(0xF6, 0xC1, struct lttng_kernel_abi_counter_aggregate)
 #define LTTNG_KERNEL_ABI_COUNTER_CLEAR \
 	_IOW(0xF6, 0xC2, struct lttng_kernel_abi_counter_clear)
+#define LTTNG_KERNEL_ABI_COUNTER_READ_BULK \
+	_IOW(0xF6, 0xC3, struct lttng_kernel_abi_counter_bulk)
+#define LTTNG_KERNEL_ABI_COUNTER_AGGREGATE_BULK \
+	_IOW(0xF6, 0xC4, struct lttng_kernel_abi_counter_bulk)
+#define LTTNG_KERNEL_ABI_COUNTER_MAP_LAYOUT \
+	_IOR(0xF6, 0xC5, struct lttng_kernel_abi_counter_map_layout)
+#define LTTNG_KERNEL_ABI_AGGREGATION_MAP_READ_KEYS \
+	_IOWR(0xF6, 0xC6, struct lttng_kernel_abi_aggregation_map_read_keys)
+#define LTTNG_KERNEL_ABI_COUNTER_EXCHANGE_BULK \
+	_IOW(0xF6, 0xC7, struct lttng_kernel_abi_counter_bulk)
 
 
 /*
@@ -471,6 +691,13 @@ struct lttng_kernel_abi_tracker_args {
 #define LTTNG_KERNEL_ABI_RING_BUFFER_GET_SEQ_NUM		_IOR(0xF6, 0x27, uint64_t)
 /* returns the stream instance id (invariant for the stream) */
 #define LTTNG_KERNEL_ABI_RING_BUFFER_INSTANCE_ID		_IOR(0xF6, 0x28, uint64_t)
+/*
+ * Get exclusive read access to the next sub-buffer, and return its
+ * descriptor. Release it with LTTNG_KERNEL_ABI_RING_BUFFER_PUT_NEXT_SUBBUF,
+ * or with the PUT_PREVIOUS flag of the next call.
+ */
+#define LTTNG_KERNEL_ABI_RING_BUFFER_GET_NEXT_PACKET	\
+	_IOWR(0xF6, 0x29, struct lttng_kernel_abi_ring_buffer_packet)
 
 /*
  * Those ioctl numbers use the wrong direction, but are kept for ABI backward
@@ -519,6 +746,9 @@ struct lttng_kernel_abi_tracker_args {
 /* returns the stream instance id (invariant for the stream) */
 #define LTTNG_KERNEL_ABI_RING_BUFFER_COMPAT_INSTANCE_ID	\
 	LTTNG_KERNEL_ABI_RING_BUFFER_INSTANCE_ID
+/* returns the descriptor of the next sub-buffer */
+#define LTTNG_KERNEL_ABI_RING_BUFFER_COMPAT_GET_NEXT_PACKET	\
+	LTTNG_KERNEL_ABI_RING_BUFFER_GET_NEXT_PACKET
 #endif /* CONFIG_COMPAT */
 
 #endif /* _LTTNG_ABI_H */
@@ -185,6 +185,25 @@ enum bytecode_op {
 
 	BYTECODE_OP_RETURN_S64			= 99,
 
+	/* set membership, see struct set_op */
+	BYTECODE_OP_IN_SET_S64			= 100,
+	BYTECODE_OP_IN_SET_STRING		= 101,
+
+	/*
+	 * Only generated by the specializer. Superinstructions: load a
+	 * field and compare it against an immediate operand.
+	 */
+	BYTECODE_OP_LOAD_PAYLOAD_CMP_S64	= 102,
+	BYTECODE_OP_LOAD_CONTEXT_CMP_S64	= 103,
+	BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING	= 104,
+	BYTECODE_OP_LOAD_CONTEXT_EQ_STRING	= 105,
+	BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING	= 106,
+	BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING	= 107,
+	/* String set with a sorted index, see struct set_index_op. */
+	BYTECODE_OP_IN_SET_STRING_INDEX		= 108,
+	/* Compiled globbing pattern, see struct load_star_glob_op. */
+	BYTECODE_OP_LOAD_STAR_GLOB_COMPILED	= 109,
+
 	NR_BYTECODE_OPS,
 };
 
@@ -218,4 +237,18 @@ struct return_op {
 	bytecode_opcode_t op;
 } __attribute__((packed));
 
+/*
+ * Test whether the top of stack is an element of an immutable set,
+ * replacing it with 1 if it is, 0 otherwise. data holds nr_elem int64_t
+ * values for IN_SET_S64, or nr_elem null-terminated strings for
+ * IN_SET_STRING, and is len bytes long. Strings are compared exactly:
+ * unlike string literals, set elements do not support wildcards.
+ */
+struct set_op {
+	bytecode_opcode_t op;
+	uint16_t nr_elem;
+	uint16_t len;
+	char data[];
+} __attribute__((packed));
+
 #endif /* _FILTER_BYTECODE_H */
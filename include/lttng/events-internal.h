@@ -18,6 +18,7 @@ struct lttng_metadata_cache;
 struct perf_event;
 struct perf_event_attr;
 struct lttng_kernel_ring_buffer_config;
+struct bytecode_merged;
 
 enum lttng_enabler_format_type {
 	LTTNG_ENABLER_FORMAT_STAR_GLOB,
@@ -66,6 +67,21 @@ enum lttng_syscall_abi {
 	LTTNG_SYSCALL_ABI_COMPAT,
 };
 
+/*
+ * Filter evaluation cost is measured once every
+ * LTTNG_KERNEL_FILTER_STATS_SAMPLE_PERIOD evaluations on each CPU.
+ * Power of 2.
+ */
+#define LTTNG_KERNEL_FILTER_STATS_SAMPLE_PERIOD	1024
+
+/* Per-CPU filter evaluation statistics of an event. */
+struct lttng_kernel_event_filter_stats {
+	u64 evaluations;
+	u64 accepts;
+	u64 sampled_evaluations;
+	u64 sampled_cycles;
+};
+
 struct lttng_kernel_event_common_private {
 	struct lttng_kernel_event_common *pub;		/* Public event interface */
 
@@ -78,6 +94,9 @@ struct lttng_kernel_event_common_private {
 	int has_enablers_without_filter_bytecode;
 	/* list of struct lttng_kernel_bytecode_runtime, sorted by seqnum */
 	struct list_head filter_bytecode_runtime_head;
+	/* Union of the filter runtimes as a single program, RCU. NULL if unused. */
+	struct bytecode_merged *filter_merged;
+	struct lttng_kernel_event_filter_stats __percpu *filter_stats;
 
 	struct hlist_node hlist_node;			/* node in events hash table */
 	struct list_head node;				/* node in event list */
@@ -117,24 +136,38 @@ struct lttng_kernel_event_notifier_private {
 	size_t num_captures;				/* Needed to allocate the msgpack array. */
 	uint64_t error_counter_index;
 	struct list_head capture_bytecode_runtime_head;
+	struct lttng_aggregation_map *aggregation_map;	/* Counts hits instead of notifying. */
+	struct lttng_histogram *histogram;		/* Counts hits instead of notifying. */
+};
+
+/*
+ * Dispatch of a system call to the events of a syscall table: the event
+ * function and arity copied from the static syscall table, and the
+ * enabled events, so the probe finds all of them in a single entry.
+ */
+struct lttng_syscall_dispatch {
+	void *event_func;
+	unsigned int nrargs;
+	/* Only enabled event, or NULL if there are none or several. RCU. */
+	struct lttng_kernel_event_common *single_event;
+	struct hlist_head action_list;			/* Enabled events */
 };
 
 struct lttng_kernel_syscall_table {
 	unsigned int sys_enter_registered:1,
 		sys_exit_registered:1;
 
-	struct hlist_head *syscall_dispatch;		/* for syscall tracing */
-	struct hlist_head *compat_syscall_dispatch;
-	struct hlist_head *syscall_exit_dispatch;	/* for syscall exit tracing */
-	struct hlist_head *compat_syscall_exit_dispatch;
-
 	/*
-	 * Combining all unknown syscall events works as long as they
-	 * are only matched by "all" syscalls enablers, but will require
-	 * a design change when we allow matching by syscall number, for
-	 * instance by allocating sc_tables accomodating NR_syscalls
-	 * entries.
+	 * Indexed by system call number, with NR_syscalls (or
+	 * NR_compat_syscalls) entries. Entries of unknown system calls
+	 * hold the unknown events of syscall number enablers.
 	 */
+	struct lttng_syscall_dispatch *syscall_dispatch;	/* for syscall tracing */
+	struct lttng_syscall_dispatch *compat_syscall_dispatch;
+	struct lttng_syscall_dispatch *syscall_exit_dispatch;	/* for syscall exit tracing */
+	struct lttng_syscall_dispatch *compat_syscall_exit_dispatch;
+
+	/* Unknown syscall events of "all" syscalls enablers. */
 	struct hlist_head unknown_syscall_dispatch;	/* for unknown syscalls */
 	struct hlist_head compat_unknown_syscall_dispatch;
 	struct hlist_head unknown_syscall_exit_dispatch;
@@ -218,6 +251,7 @@ struct lttng_kernel_bytecode_runtime {
 				struct lttng_kernel_probe_ctx *lttng_probe_ctx,
 				void *caller_ctx);
 	int link_failed;
+	unsigned long filter_fields;	/* Event fields loaded, see filter_fields in events.h */
 	struct list_head node;	/* list of bytecode runtime in event */
 	struct lttng_kernel_ctx *ctx;
 };
@@ -255,6 +289,8 @@ struct lttng_event_notifier_enabler {
 	/* head list of struct lttng_kernel_bytecode_node */
 	struct list_head capture_bytecode_head;
 	uint64_t num_captures;
+	struct lttng_aggregation_map *aggregation_map;
+	struct lttng_histogram *histogram;
 };
 
 struct lttng_ctx_value {
@@ -400,6 +436,23 @@ struct lttng_counter_ops {
 	int (*counter_aggregate)(struct lib_counter *counter, const size_t *dimension_indexes,
 			int64_t *value, bool *overflow, bool *underflow);
 	int (*counter_clear)(struct lib_counter *counter, const size_t *dimension_indexes);
+	/*
+	 * Range operations on @nr_elem counters starting at linear index
+	 * @index, the last dimension varying fastest.
+	 */
+	int (*counter_read_range)(struct lib_counter *counter, size_t index, size_t nr_elem,
+			int cpu, int64_t *values, bool *overflow, bool *underflow);
+	int (*counter_aggregate_range)(struct lib_counter *counter, size_t index, size_t nr_elem,
+			int64_t *values, bool *overflow, bool *underflow);
+	/*
+	 * counter_exchange_range aggregates like counter_aggregate_range,
+	 * atomically resetting each counter as it is read.
+	 */
+	int (*counter_exchange_range)(struct lib_counter *counter, size_t index, size_t nr_elem,
+			int64_t *values, bool *overflow, bool *underflow);
+	int (*counter_get_map_layout)(struct lib_counter *counter,
+			struct lib_counter_map_layout *map_layout);
+	int (*counter_map)(struct lib_counter *counter, struct vm_area_struct *vma);
 };
 
 struct lttng_counter {
@@ -408,6 +461,46 @@ struct lttng_counter {
 	struct lttng_counter_transport *transport;
 	struct lib_counter *counter;
 	struct lttng_counter_ops *ops;
+	struct lttng_aggregation_map *aggregation_map;	/* NULL unless keyed. */
+	struct lttng_histogram *histogram;		/* NULL unless histogram. */
+};
+
+/*
+ * Keyed aggregation map slot. The slot is claimed by setting a non-zero
+ * key hash, and its key is published by setting ready.
+ */
+struct lttng_aggregation_map_slot {
+	uint32_t hash;
+	uint32_t ready;
+	uint32_t nil_mask;
+	uint64_t values[LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX];
+};
+
+/*
+ * Lock-free open addressing table of the keys captured by event
+ * notifiers, slot N owning counter N of the per-cpu counter.
+ */
+struct lttng_aggregation_map {
+	struct lttng_counter *counter;
+	struct lttng_event_notifier_group *group;
+	struct lttng_aggregation_map_slot *slots;
+	size_t nr_slots;		/* Power of two. */
+	atomic_long_t dropped;		/* Hits without a free slot. */
+	struct list_head node;		/* Event notifier group list of maps. */
+};
+
+/*
+ * Histogram of the values captured by event notifiers, bucket N owning
+ * counter N of the per-cpu counter.
+ */
+struct lttng_histogram {
+	struct lttng_counter *counter;
+	struct lttng_event_notifier_group *group;
+	uint32_t type;			/* enum lttng_kernel_abi_histogram_type */
+	size_t nr_buckets;
+	int64_t min;
+	uint64_t width;
+	struct list_head node;		/* Event notifier group list of histograms. */
 };
 
 #define LTTNG_EVENT_HT_BITS		12
@@ -435,6 +528,9 @@ struct lttng_event_notifier_group {
 
 	struct lttng_counter *error_counter;
 	size_t error_counter_len;
+
+	struct list_head aggregation_maps_head;	/* List of aggregation maps */
+	struct list_head histograms_head;	/* List of histograms */
 };
 
 struct lttng_transport {
@@ -451,6 +547,24 @@ struct lttng_counter_transport {
 	struct lttng_counter_ops ops;
 };
 
+/*
+ * Per-cpu cache of the tracker verdict computed for the last task
+ * identity which hit a probe of the session. It is keyed by the
+ * session tracker generation and by the identity attributes consulted
+ * by the trackers, so exec, setuid/setgid and setns invalidate it
+ * implicitly by changing the task credentials.
+ */
+struct lttng_tracker_verdict_cache {
+	unsigned long generation;		/* Session tracker generation */
+	pid_t tgid;
+	struct pid_namespace *pid_ns;
+	struct user_namespace *user_ns;
+	kuid_t uid;
+	kgid_t gid;
+	bool verdict;
+	bool busy;				/* Guard against nested probes */
+};
+
 struct lttng_kernel_session_private {
 	struct lttng_kernel_session *pub;	/* Public session interface */
 
@@ -470,6 +584,9 @@ struct lttng_kernel_session_private {
 	struct lttng_event_ht events_ht;
 	char name[LTTNG_KERNEL_ABI_SESSION_NAME_LEN];
 	char creation_time[LTTNG_KERNEL_ABI_SESSION_CREATION_TIME_ISO8601_LEN];
+	/* Bumped on each tracker update, invalidates verdict caches. */
+	unsigned long tracker_generation;
+	struct lttng_tracker_verdict_cache __percpu *tracker_verdict_cache;
 };
 
 struct lttng_id_hash_node {
@@ -830,6 +947,12 @@ void lttng_event_notifier_enabler_group_add(struct lttng_event_notifier_group *e
 int lttng_event_notifier_enabler_attach_capture_bytecode(
 		struct lttng_event_notifier_enabler *event_notifier_enabler,
 		struct lttng_kernel_abi_capture_bytecode __user *bytecode);
+int lttng_event_notifier_enabler_attach_aggregation_map(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_aggregation_map *aggregation_map);
+int lttng_event_notifier_enabler_attach_histogram(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_histogram *histogram);
 
 int lttng_event_enabler_enable(struct lttng_event_enabler_common *event_enabler);
 int lttng_event_enabler_disable(struct lttng_event_enabler_common *event_enabler);
@@ -850,6 +973,7 @@ bool lttng_event_enabler_event_name_match_event(struct lttng_event_enabler_commo
 
 void lttng_enabler_link_bytecode(const struct lttng_kernel_event_desc *event_desc,
 		struct lttng_kernel_ctx *ctx,
+		unsigned long *instance_filter_fields,
 		struct list_head *instance_bytecode_runtime_head,
 		struct list_head *enabler_bytecode_runtime_head);
 
@@ -865,6 +989,12 @@ long lttng_syscall_table_get_active_mask(struct lttng_kernel_syscall_table *sysc
 		struct lttng_kernel_abi_syscall_mask __user *usyscall_mask);
 
 void lttng_syscall_table_set_wildcard_all(struct lttng_event_enabler_common *event_enabler);
+
+bool lttng_syscall_desc_match_nr(const struct lttng_kernel_event_desc *desc,
+		bool compat, bool entry, unsigned int nr);
+bool lttng_syscall_event_enabler_match_nr(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_event_common *event);
+bool lttng_syscall_event_is_unknown_nr(struct lttng_kernel_event_common *event);
 #else
 static inline int lttng_event_enabler_create_syscall_events_if_missing(struct lttng_event_enabler_common *event_enabler)
 {
@@ -905,6 +1035,23 @@ static inline int lttng_syscalls_create_matching_event_notifiers(struct lttng_ev
 static inline void lttng_syscall_table_set_wildcard_all(struct lttng_event_enabler_common *event_enabler)
 {
 }
+
+static inline bool lttng_syscall_desc_match_nr(const struct lttng_kernel_event_desc *desc,
+		bool compat, bool entry, unsigned int nr)
+{
+	return false;
+}
+
+static inline bool lttng_syscall_event_enabler_match_nr(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_event_common *event)
+{
+	return true;
+}
+
+static inline bool lttng_syscall_event_is_unknown_nr(struct lttng_kernel_event_common *event)
+{
+	return false;
+}
 #endif
 
 #ifdef CONFIG_KPROBES
@@ -1043,6 +1190,19 @@ int lttng_kernel_counter_aggregate(struct lttng_counter *counter,
 		bool *overflow, bool *underflow);
 int lttng_kernel_counter_clear(struct lttng_counter *counter,
 		const size_t *dimension_indexes);
+int lttng_kernel_counter_read_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem, int32_t cpu,
+		int64_t *values, bool *overflow, bool *underflow);
+int lttng_kernel_counter_aggregate_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem,
+		int64_t *values, bool *overflow, bool *underflow);
+int lttng_kernel_counter_exchange_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem,
+		int64_t *values, bool *overflow, bool *underflow);
+int lttng_kernel_counter_get_map_layout(struct lttng_counter *counter,
+		struct lib_counter_map_layout *map_layout);
+int lttng_kernel_counter_map(struct lttng_counter *counter,
+		struct vm_area_struct *vma);
 struct lttng_event_notifier_group *lttng_event_notifier_group_create(void);
 int lttng_event_notifier_group_create_error_counter(
 		struct file *event_notifier_group_file,
@@ -1050,6 +1210,29 @@ int lttng_event_notifier_group_create_error_counter(
 void lttng_event_notifier_group_destroy(
 		struct lttng_event_notifier_group *event_notifier_group);
 
+struct lttng_aggregation_map *lttng_aggregation_map_create(
+		struct lttng_event_notifier_group *event_notifier_group,
+		const char *counter_transport_name, size_t nr_slots);
+void lttng_aggregation_map_destroy(struct lttng_aggregation_map *aggregation_map);
+void lttng_aggregation_map_update(struct lttng_aggregation_map *aggregation_map,
+		struct lttng_kernel_event_notifier *event_notifier,
+		const char *stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		struct lttng_kernel_notification_ctx *notif_ctx);
+void lttng_aggregation_map_read_key(struct lttng_aggregation_map *aggregation_map,
+		size_t index, struct lttng_kernel_abi_aggregation_map_key *key);
+
+struct lttng_histogram *lttng_histogram_create(
+		struct lttng_event_notifier_group *event_notifier_group,
+		const char *counter_transport_name,
+		const struct lttng_kernel_abi_histogram_conf *histogram_conf);
+void lttng_histogram_destroy(struct lttng_histogram *histogram);
+void lttng_histogram_update(struct lttng_histogram *histogram,
+		struct lttng_kernel_event_notifier *event_notifier,
+		const char *stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		struct lttng_kernel_notification_ctx *notif_ctx);
+
 struct lttng_kernel_channel_buffer *lttng_channel_buffer_create(struct lttng_kernel_session *session,
 				       const char *transport_name,
 				       void *buf_addr,
@@ -1073,6 +1256,10 @@ int lttng_channel_enable(struct lttng_kernel_channel_common *channel);
 int lttng_channel_disable(struct lttng_kernel_channel_common *channel);
 int lttng_event_enable(struct lttng_kernel_event_common *event);
 int lttng_event_disable(struct lttng_kernel_event_common *event);
+void lttng_event_filter_stats(struct lttng_kernel_event_common *event,
+		struct lttng_kernel_abi_event_filter_stats *stats);
+int lttng_event_enabler_filter_stats(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_abi_event_filter_stats *stats);
 
 void lttng_transport_register(struct lttng_transport *transport);
 void lttng_transport_unregister(struct lttng_transport *transport);
@@ -1115,6 +1302,11 @@ int lttng_session_list_tracker_ids(struct lttng_kernel_session *session,
 void lttng_clock_ref(void);
 void lttng_clock_unref(void);
 
+int lttng_static_region_init(void);
+void lttng_static_region_exit(void);
+void *lttng_static_region_get(size_t subbuf_size, size_t num_subbuf);
+void lttng_static_region_put(void);
+
 void lttng_free_event_filter_runtime(struct lttng_kernel_event_common *event);
 
 int lttng_probes_init(void);
@@ -336,6 +336,14 @@ struct lttng_kernel_probe_desc {
 	int lazy;				/* lazy registration */
 };
 
+/*
+ * Bit of the filter_fields mask for the filterable event field at
+ * @index, counting only fields without nofilter. Fields beyond the
+ * width of the mask share its last bit.
+ */
+#define LTTNG_KERNEL_EVENT_FILTER_FIELD_BIT(index)	\
+	(1UL << min_t(unsigned int, (index), BITS_PER_LONG - 1))
+
 /*
  * Result of the run_filter() callback.
  */
@@ -359,6 +367,7 @@ struct lttng_kernel_event_common {
 
 	int enabled;
 	int eval_filter;				/* Need to evaluate filters */
+	unsigned long filter_fields;			/* Fields loaded by filters and captures */
 	int (*run_filter)(const struct lttng_kernel_event_common *event,
 		const char *stack_data,
 		struct lttng_kernel_probe_ctx *probe_ctx,
@@ -454,7 +463,16 @@ DECLARE_PER_CPU(struct lttng_dynamic_len_stack, lttng_dynamic_len_stack);
 #define LTTNG_ID_HASH_BITS	6
 #define LTTNG_ID_TABLE_SIZE	(1 << LTTNG_ID_HASH_BITS)
 
+/*
+ * IDs below LTTNG_ID_BITMAP_BITS (default pid_max) are also mirrored in
+ * a direct-mapped bitmap, so the common lookup is a single cache-line
+ * load. The hash table holds the authoritative set, and is only walked
+ * for IDs outside of the bitmap range.
+ */
+#define LTTNG_ID_BITMAP_BITS	(1U << 15)
+
 struct lttng_kernel_id_tracker_rcu {
+	unsigned long id_bitmap[BITS_TO_LONGS(LTTNG_ID_BITMAP_BITS)];
 	struct hlist_head id_hash[LTTNG_ID_TABLE_SIZE];
 };
 
@@ -477,11 +495,19 @@ struct lttng_kernel_session {
 	struct lttng_kernel_id_tracker vuid_tracker;
 	struct lttng_kernel_id_tracker gid_tracker;
 	struct lttng_kernel_id_tracker vgid_tracker;
+
+	/*
+	 * Mask of trackers which currently filter IDs, indexed by
+	 * tracker type. Zero when all IDs are tracked, which lets the
+	 * probe prologue skip every tracker lookup with a single load.
+	 */
+	unsigned int tracker_mask;
 };
 
 int lttng_kernel_probe_register(struct lttng_kernel_probe_desc *desc);
 void lttng_kernel_probe_unregister(struct lttng_kernel_probe_desc *desc);
 
 bool lttng_id_tracker_lookup(struct lttng_kernel_id_tracker_rcu *p, int id);
+bool lttng_session_tracker_admit(struct lttng_kernel_session *session);
 
 #endif /* _LTTNG_EVENTS_H */
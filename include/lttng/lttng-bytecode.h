@@ -15,6 +15,7 @@
 #include <lttng/events.h>
 #include <lttng/events-internal.h>
 #include <lttng/bytecode.h>
+#include <lttng/string-utils.h>
 
 /* Interpreter stack length, in number of entries */
 #define INTERPRETER_STACK_LEN	10	/* includes 2 dummy */
@@ -35,12 +36,134 @@ do {								\
 } while (0)
 #endif
 
+/*
+ * Superinstructions replace, in place, the load of a field followed by
+ * the load of an immediate operand and a comparison. @len is the length
+ * of the replaced instructions.
+ */
+struct load_cmp_s64_op {
+	bytecode_opcode_t op;
+	bytecode_opcode_t cmp;	/* BYTECODE_OP_{EQ,NE,GT,LT,GE,LE}_S64 */
+	uint8_t len;
+	uint16_t index;		/* Payload offset or context index */
+	int64_t v;		/* Immediate operand */
+} __attribute__((packed));
+
+struct load_cmp_string_op {
+	bytecode_opcode_t op;
+	uint16_t index;		/* Payload offset or context index */
+	uint16_t len;
+	char data[];		/* Literal string */
+} __attribute__((packed));
+
+struct load_cmp_glob_op {
+	bytecode_opcode_t op;
+	uint16_t index;		/* Payload offset or context index */
+	uint16_t len;
+	uint16_t glob;		/* Offset of the compiled pattern in the runtime data */
+} __attribute__((packed));
+
+enum bytecode_compiled_op {
+	BYTECODE_COMPILED_OP_TEST,	/* Operand a is non-zero */
+	/* Same order as the BYTECODE_OP_*_S64 comparators. */
+	BYTECODE_COMPILED_OP_EQ,
+	BYTECODE_COMPILED_OP_NE,
+	BYTECODE_COMPILED_OP_GT,
+	BYTECODE_COMPILED_OP_LT,
+	BYTECODE_COMPILED_OP_GE,
+	BYTECODE_COMPILED_OP_LE,
+	BYTECODE_COMPILED_OP_NOT,
+	BYTECODE_COMPILED_OP_AND,
+	BYTECODE_COMPILED_OP_OR,
+	BYTECODE_COMPILED_OP_RETURN,
+};
+
+enum bytecode_compiled_operand_type {
+	BYTECODE_COMPILED_OPERAND_IMM,
+	BYTECODE_COMPILED_OPERAND_PAYLOAD,
+	BYTECODE_COMPILED_OPERAND_CONTEXT,
+};
+
+struct bytecode_compiled_operand {
+	enum bytecode_compiled_operand_type type;
+	union {
+		int64_t imm;
+		uint32_t offset;	/* Offset in interpreter stack data */
+		uint32_t ctx_index;	/* Index in lttng_static_ctx */
+	} u;
+};
+
+struct bytecode_compiled_insn {
+	enum bytecode_compiled_op op;
+	uint16_t target;		/* AND/OR jump target instruction */
+	struct bytecode_compiled_operand a, b;
+};
+
+/* Filter bytecode compiled into a predicate program. */
+struct bytecode_compiled {
+	unsigned int len;		/* Number of instructions */
+	struct bytecode_compiled_insn insn[];
+};
+
+/*
+ * Specialized IN_SET_STRING, same layout as struct set_op. index is the
+ * offset of a struct bytecode_string_set within the runtime data.
+ */
+struct set_index_op {
+	bytecode_opcode_t op;
+	uint16_t index;
+	uint16_t len;
+	char data[];
+} __attribute__((packed));
+
+/*
+ * Specialized LOAD_STAR_GLOB_STRING. index is the offset of a struct
+ * strutils_star_glob within the runtime data, len the length of the
+ * replaced instruction.
+ */
+struct load_star_glob_op {
+	bytecode_opcode_t op;
+	uint16_t index;
+	uint16_t len;
+} __attribute__((packed));
+
+/* Elements of a string set, sorted. */
+struct bytecode_string_set {
+	uint32_t nr_elem;
+	const char *elem[];	/* Strings within the op data */
+};
+
+/* Values compared for equality against a single field. */
+struct bytecode_merged_set {
+	struct bytecode_compiled_operand field;
+	unsigned int nr_values;
+	int64_t *values;		/* Sorted, without duplicates */
+};
+
+/*
+ * Union of the enabled filter runtimes of an event. Runtimes compiled
+ * into equality tests of a field against immediate values are merged
+ * into sets, loading each field once. Other runtimes are evaluated in
+ * turn.
+ */
+struct bytecode_merged {
+	unsigned int nr_sets;
+	struct bytecode_merged_set *sets;
+	unsigned int nr_runtimes;
+	struct lttng_kernel_bytecode_runtime **runtimes;	/* Not merged */
+	unsigned int nr_inputs;
+	struct lttng_kernel_bytecode_runtime **inputs;	/* Enabled runtimes */
+	int64_t *values;
+	struct list_head retired_node;	/* Replaced, waiting for a grace period */
+};
+
 /* Linked bytecode. Child of struct lttng_kernel_bytecode_runtime. */
 struct bytecode_runtime {
 	struct lttng_kernel_bytecode_runtime p;
 	size_t data_len;
 	size_t data_alloc_len;
 	char *data;
+	struct bytecode_compiled *compiled;	/* NULL if not compiled */
 	uint16_t len;
 	char code[];
 };
@@ -203,6 +326,8 @@ struct estack_entry {
 			size_t seq_len;
 			enum estack_string_literal_type literal_type;
 			bool user;		/* is string from userspace ? */
+			/* Compiled star globbing pattern, or NULL. */
+			const struct strutils_star_glob *glob;
 		} s;
 		struct load_ptr ptr;
 	} u;
@@ -295,6 +420,11 @@ int lttng_bytecode_validate(struct bytecode_runtime *bytecode);
 int lttng_bytecode_validate_load(struct bytecode_runtime *bytecode);
 int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 		struct bytecode_runtime *bytecode);
+int lttng_bytecode_compile(struct bytecode_runtime *bytecode);
+void lttng_bytecode_merge_event_filter(struct lttng_kernel_event_common *event,
+		struct list_head *retired);
+void lttng_bytecode_merged_free(struct bytecode_merged *merged);
+void lttng_bytecode_merged_free_retired(struct list_head *retired);
 
 int lttng_bytecode_interpret_error(struct lttng_kernel_bytecode_runtime *bytecode_runtime,
 		const char *stack_data,
@@ -306,4 +436,13 @@ int lttng_bytecode_interpret(struct lttng_kernel_bytecode_runtime *kernel_byteco
 		struct lttng_kernel_probe_ctx *lttng_probe_ctx,
 		void *caller_ctx);
 
+int lttng_bytecode_interpret_compiled(struct lttng_kernel_bytecode_runtime *kernel_bytecode,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *lttng_probe_ctx,
+		void *caller_ctx);
+
+int lttng_bytecode_interpret_merged(const struct bytecode_merged *merged,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *lttng_probe_ctx);
+
 #endif /* _LTTNG_FILTER_H */
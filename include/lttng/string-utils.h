@@ -6,8 +6,25 @@
  * Copyright (C) 2017 Philippe Proulx <pproulx@efficios.com>
  */
 
+#include <linux/types.h>
+
 typedef char (*strutils_get_char_at_cb)(size_t, void *);
 
+/*
+ * Star globbing pattern compiled for strutils_star_glob_compiled_match():
+ * the unescaped literal pieces of the pattern, separated by its stars,
+ * followed by the original pattern.
+ */
+struct strutils_star_glob {
+	uint16_t len;			/* Size, including the data */
+	uint16_t nr_pieces;		/* Number of stars + 1 */
+	uint16_t prefix_len;		/* Length of the first piece */
+	uint16_t suffix_len;		/* Length of the last piece */
+	uint16_t suffix_offset;		/* Offset of the last piece in data */
+	uint16_t pattern_offset;	/* Offset of the original pattern in data */
+	char data[];			/* Null-terminated pieces, then the pattern */
+};
+
 bool strutils_is_star_glob_pattern(const char *pattern);
 bool strutils_is_star_at_the_end_only_glob_pattern(const char *pattern);
 bool strutils_star_glob_match(const char *pattern, size_t pattern_len,
@@ -17,5 +34,10 @@ bool strutils_star_glob_match_char_cb(
 		void *pattern_get_char_at_cb_data,
 		strutils_get_char_at_cb candidate_get_char_at_cb,
 		void *candidate_get_char_at_cb_data);
+size_t strutils_star_glob_compiled_len(const char *pattern);
+int strutils_star_glob_compile(const char *pattern,
+		struct strutils_star_glob *glob);
+bool strutils_star_glob_compiled_match(const struct strutils_star_glob *glob,
+		const char *candidate, size_t candidate_len);
 
 #endif /* _LTTNG_STRING_UTILS_H */
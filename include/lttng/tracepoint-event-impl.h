@@ -523,6 +523,8 @@ error:									      \
  *
  * Create static inline function that layout the filter stack data.
  * We make both write and nowrite data available to the filter.
+ * Only the fields within the __filter_fields mask are fetched, the
+ * slots of the other fields are left uninitialized.
  */
 
 /* Reset all macros within TRACEPOINT_EVENT */
@@ -530,6 +532,15 @@ error:									      \
 #include <lttng/events-write.h>
 #include <lttng/events-nowrite.h>
 
+#undef _ctf_stack_field
+#define _ctf_stack_field(_size, ...)					       \
+	if (__filter_fields & LTTNG_KERNEL_EVENT_FILTER_FIELD_BIT(__filter_field_idx)) { \
+		__VA_ARGS__						       \
+	} else {							       \
+		__stack_data += (_size);				       \
+	}								       \
+	__filter_field_idx++;
+
 #undef _ctf_integer_ext_fetched
 #define _ctf_integer_ext_fetched(_type, _item, _src, _byte_order, _base, _nowrite) \
 	if (lttng_is_signed_type(_type)) {				       \
@@ -628,10 +639,12 @@ error:									      \
 
 #undef _ctf_integer_ext
 #define _ctf_integer_ext(_type, _item, _user_src, _byte_order, _base, _user, _nowrite) \
-	_ctf_integer_ext_isuser##_user(_type, _item, _user_src, _byte_order, _base, _nowrite)
+	_ctf_stack_field(sizeof(int64_t),				       \
+		_ctf_integer_ext_isuser##_user(_type, _item, _user_src, _byte_order, _base, _nowrite))
 
 #undef _ctf_array_encoded
 #define _ctf_array_encoded(_type, _item, _src, _length, _encoding, _byte_order, _base, _user, _nowrite) \
+	_ctf_stack_field(sizeof(unsigned long) + sizeof(void *),	       \
 	{								       \
 		unsigned long __ctf_tmp_ulong = (unsigned long) (_length);     \
 		const void *__ctf_tmp_ptr = (_src);			       \
@@ -639,7 +652,7 @@ error:									      \
 		__stack_data += sizeof(unsigned long);			       \
 		memcpy(__stack_data, &__ctf_tmp_ptr, sizeof(void *));	       \
 		__stack_data += sizeof(void *);				       \
-	}
+	})
 
 #undef _ctf_array_bitfield
 #define _ctf_array_bitfield(_type, _item, _src, _length, _user, _nowrite) \
@@ -648,6 +661,7 @@ error:									      \
 #undef _ctf_sequence_encoded
 #define _ctf_sequence_encoded(_type, _item, _src, _length_type,		       \
 			_src_length, _encoding, _byte_order, _base, _user, _nowrite) \
+	_ctf_stack_field(sizeof(unsigned long) + sizeof(void *),	       \
 	{								       \
 		unsigned long __ctf_tmp_ulong = (unsigned long) (_src_length); \
 		const void *__ctf_tmp_ptr = (_src);			       \
@@ -655,7 +669,7 @@ error:									      \
 		__stack_data += sizeof(unsigned long);			       \
 		memcpy(__stack_data, &__ctf_tmp_ptr, sizeof(void *));	       \
 		__stack_data += sizeof(void *);				       \
-	}
+	})
 
 #undef _ctf_sequence_bitfield
 #define _ctf_sequence_bitfield(_type, _item, _src,		\
@@ -666,12 +680,13 @@ error:									      \
 
 #undef _ctf_string
 #define _ctf_string(_item, _src, _user, _nowrite)			       \
+	_ctf_stack_field(sizeof(void *),				       \
 	{								       \
 		const void *__ctf_tmp_ptr =				       \
 			((_src) ? (_src) : __LTTNG_NULL_STRING);	       \
 		memcpy(__stack_data, &__ctf_tmp_ptr, sizeof(void *));	       \
 		__stack_data += sizeof(void *);				       \
-	}
+	})
 
 #undef _ctf_enum
 #define _ctf_enum(_name, _type, _item, _src, _user, _nowrite)		       \
@@ -690,9 +705,10 @@ error:									      \
 #define LTTNG_TRACEPOINT_EVENT_CLASS_CODE_NOARGS(_name, _locvar, _code_pre, _fields, _code_post) \
 static inline								      \
 void __event_prepare_interpreter_stack__##_name(char *__stack_data,		      \
-		void *__tp_locvar)					      \
+		unsigned long __filter_fields, void *__tp_locvar)	      \
 {									      \
 	struct { _locvar } *tp_locvar __attribute__((unused)) = __tp_locvar;  \
+	unsigned int __filter_field_idx __attribute__((unused)) = 0;	      \
 									      \
 	_fields								      \
 }
@@ -701,9 +717,10 @@ void __event_prepare_interpreter_stack__##_name(char *__stack_data,		      \
 #define LTTNG_TRACEPOINT_EVENT_CLASS_CODE(_name, _proto, _args, _locvar, _code_pre, _fields, _code_post) \
 static inline								      \
 void __event_prepare_interpreter_stack__##_name(char *__stack_data,		      \
-		void *__tp_locvar, _proto)				      \
+		unsigned long __filter_fields, void *__tp_locvar, _proto)     \
 {									      \
 	struct { _locvar } *tp_locvar __attribute__((unused)) = __tp_locvar;  \
+	unsigned int __filter_field_idx __attribute__((unused)) = 0;	      \
 									      \
 	_fields								      \
 }
@@ -1078,6 +1095,7 @@ static void __event_probe__##_name(_data_proto)						\
 	struct probe_local_vars *tp_locvar __attribute__((unused)) =			\
 			&__tp_locvar;							\
 	bool __interpreter_stack_prepared = false;					\
+	unsigned long __filter_fields = 0;						\
 											\
 	switch (__event->type) {							\
 	case LTTNG_KERNEL_EVENT_TYPE_RECORDER:						\
@@ -1086,35 +1104,14 @@ static void __event_probe__##_name(_data_proto)						\
 			container_of(__event, struct lttng_kernel_event_recorder, parent); \
 		struct lttng_kernel_channel_buffer *__chan = __event_recorder->chan;	\
 		struct lttng_kernel_session *__session = __chan->parent.session;	\
-		struct lttng_kernel_id_tracker_rcu *__lf;				\
-											\
 		if (!_TP_SESSION_CHECK(session, __session))				\
 			return;								\
 		if (unlikely(!LTTNG_READ_ONCE(__session->active)))			\
 			return;								\
 		if (unlikely(!LTTNG_READ_ONCE(__chan->parent.enabled)))			\
 			return;								\
-		__lf = lttng_rcu_dereference(__session->pid_tracker.p);			\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf, current->tgid)))	\
-			return;								\
-		__lf = lttng_rcu_dereference(__session->vpid_tracker.p);		\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf, task_tgid_vnr(current)))) \
-			return;								\
-		__lf = lttng_rcu_dereference(__session->uid_tracker.p);			\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf,			\
-				from_kuid_munged(&init_user_ns, current_uid()))))	\
-			return;								\
-		__lf = lttng_rcu_dereference(__session->vuid_tracker.p);		\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf,			\
-				from_kuid_munged(current_user_ns(), current_uid()))))	\
-			return;								\
-		__lf = lttng_rcu_dereference(__session->gid_tracker.p);			\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf,			\
-				from_kgid_munged(&init_user_ns, current_gid()))))	\
-			return;								\
-		__lf = lttng_rcu_dereference(__session->vgid_tracker.p);		\
-		if (__lf && likely(!lttng_id_tracker_lookup(__lf,			\
-				from_kgid_munged(current_user_ns(), current_gid()))))	\
+		if (unlikely(LTTNG_READ_ONCE(__session->tracker_mask)) &&		\
+				!lttng_session_tracker_admit(__session))		\
 			return;								\
 		break;									\
 	}										\
@@ -1129,8 +1126,10 @@ static void __event_probe__##_name(_data_proto)						\
 	__dynamic_len_idx = __orig_dynamic_len_offset;					\
 	_code_pre									\
 	if (unlikely(READ_ONCE(__event->eval_filter))) {				\
+		__filter_fields = READ_ONCE(__event->filter_fields);			\
+		smp_rmb();	/* Fields before bytecode programs, see link_bytecode(). */ \
 		__event_prepare_interpreter_stack__##_name(__stackvar.__interpreter_stack_data, \
-				_locvar_args);						\
+				__filter_fields, _locvar_args);				\
 		__interpreter_stack_prepared = true;					\
 		if (likely(__event->run_filter(__event,			      		\
 				__stackvar.__interpreter_stack_data, &__lttng_probe_ctx, NULL) != LTTNG_KERNEL_EVENT_FILTER_ACCEPT)) \
@@ -1169,10 +1168,16 @@ static void __event_probe__##_name(_data_proto)						\
 		struct lttng_kernel_notification_ctx __notif_ctx;			\
 											\
 		__notif_ctx.eval_capture = LTTNG_READ_ONCE(__event_notifier->eval_capture); \
-		if (unlikely(!__interpreter_stack_prepared && __notif_ctx.eval_capture)) \
-			__event_prepare_interpreter_stack__##_name(			\
-					__stackvar.__interpreter_stack_data,		\
-					_locvar_args);					\
+		if (unlikely(__notif_ctx.eval_capture)) {				\
+			unsigned long __capture_fields = READ_ONCE(__event->filter_fields); \
+											\
+			smp_rmb();	/* Fields before bytecode programs. */		\
+			/* Captures linked since the filter ran may load more fields. */ \
+			if (!__interpreter_stack_prepared || __capture_fields != __filter_fields) \
+				__event_prepare_interpreter_stack__##_name(		\
+						__stackvar.__interpreter_stack_data,	\
+						__capture_fields, _locvar_args);	\
+		}									\
 											\
 		__event_notifier->notification_send(__event_notifier,			\
 				__stackvar.__interpreter_stack_data,			\
@@ -59,6 +59,37 @@ extern void *
 lib_ring_buffer_read_offset_address(struct lttng_kernel_ring_buffer_backend *bufb,
 				    size_t offset);
 
+/*
+ * Number of bytes which can be written directly at @offset, out of @len.
+ * Sub-buffers of the RING_BUFFER_VMAP backend are virtually contiguous,
+ * and writes never cross sub-buffers, so the whole write is contiguous.
+ */
+static inline __attribute__((always_inline))
+size_t lib_ring_buffer_write_contig_len(const struct lttng_kernel_ring_buffer_config *config,
+					size_t offset, size_t len)
+{
+	if (config->backend == RING_BUFFER_VMAP)
+		return len;
+	return min_t(size_t, len, (-offset) & ~PAGE_MASK);
+}
+
+/*
+ * Address of @offset within the sub-buffer described by @backend_pages.
+ */
+static inline __attribute__((always_inline))
+void *lib_ring_buffer_write_address(const struct lttng_kernel_ring_buffer_config *config,
+				    struct channel_backend *chanb,
+				    struct lttng_kernel_ring_buffer_backend_pages *backend_pages,
+				    size_t offset)
+{
+	size_t sb_offset = offset & (chanb->subbuf_size - 1);
+
+	if (config->backend == RING_BUFFER_VMAP)
+		return backend_pages->vmap + sb_offset;
+	return backend_pages->p[sb_offset >> PAGE_SHIFT].virt
+		+ (offset & ~PAGE_MASK);
+}
+
 /**
  * lib_ring_buffer_write - write data to a buffer backend
  * @config : ring buffer instance configuration
@@ -78,7 +109,7 @@ void lib_ring_buffer_write(const struct lttng_kernel_ring_buffer_config *config,
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -87,12 +118,11 @@ void lib_ring_buffer_write(const struct lttng_kernel_ring_buffer_config *config,
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 	if (likely(bytes_left_in_page == len))
 		lib_ring_buffer_do_copy(config,
-					backend_pages->p[index].virt
-					    + (offset & ~PAGE_MASK),
+					lib_ring_buffer_write_address(config, chanb,
+					    backend_pages, offset),
 					src, len);
 	else
 		_lib_ring_buffer_write(bufb, offset, src, len);
@@ -118,7 +148,7 @@ void lib_ring_buffer_memset(const struct lttng_kernel_ring_buffer_config *config
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -127,11 +157,10 @@ void lib_ring_buffer_memset(const struct lttng_kernel_ring_buffer_config *config
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 	if (likely(bytes_left_in_page == len))
-		lib_ring_buffer_do_memset(backend_pages->p[index].virt
-					  + (offset & ~PAGE_MASK),
+		lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+					  backend_pages, offset),
 					  c, len);
 	else
 		_lib_ring_buffer_memset(bufb, offset, c, len);
@@ -215,7 +244,7 @@ void lib_ring_buffer_strcpy(const struct lttng_kernel_ring_buffer_config *config
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -224,28 +253,27 @@ void lib_ring_buffer_strcpy(const struct lttng_kernel_ring_buffer_config *config
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 	if (likely(bytes_left_in_page == len)) {
 		size_t count;
 
 		count = lib_ring_buffer_do_strcpy(config,
-					backend_pages->p[index].virt
-					    + (offset & ~PAGE_MASK),
+					lib_ring_buffer_write_address(config, chanb,
+					    backend_pages, offset),
 					src, len - 1);
 		offset += count;
 		/* Padding */
 		if (unlikely(count < len - 1)) {
 			size_t pad_len = len - 1 - count;
 
-			lib_ring_buffer_do_memset(backend_pages->p[index].virt
-						+ (offset & ~PAGE_MASK),
+			lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+						backend_pages, offset),
 					pad, pad_len);
 			offset += pad_len;
 		}
 		/* Ending '\0' */
-		lib_ring_buffer_do_memset(backend_pages->p[index].virt
-					+ (offset & ~PAGE_MASK),
+		lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+					backend_pages, offset),
 				'\0', 1);
 	} else {
 		_lib_ring_buffer_strcpy(bufb, offset, src, len, pad);
@@ -281,7 +309,7 @@ void lib_ring_buffer_pstrcpy(const struct lttng_kernel_ring_buffer_config *confi
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -290,22 +318,21 @@ void lib_ring_buffer_pstrcpy(const struct lttng_kernel_ring_buffer_config *confi
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 	if (likely(bytes_left_in_page == len)) {
 		size_t count;
 
 		count = lib_ring_buffer_do_strcpy(config,
-					backend_pages->p[index].virt
-					    + (offset & ~PAGE_MASK),
+					lib_ring_buffer_write_address(config, chanb,
+					    backend_pages, offset),
 					src, len);
 		offset += count;
 		/* Padding */
 		if (unlikely(count < len)) {
 			size_t pad_len = len - count;
 
-			lib_ring_buffer_do_memset(backend_pages->p[index].virt
-						+ (offset & ~PAGE_MASK),
+			lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+						backend_pages, offset),
 					pad, pad_len);
 			offset += pad_len;
 		}
@@ -335,7 +362,7 @@ void lib_ring_buffer_copy_from_user_inatomic(const struct lttng_kernel_ring_buff
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 	unsigned long ret;
@@ -345,8 +372,7 @@ void lib_ring_buffer_copy_from_user_inatomic(const struct lttng_kernel_ring_buff
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 
 	if (unlikely(!lttng_access_ok(VERIFY_READ, src, len)))
 		goto fill_buffer;
@@ -354,7 +380,8 @@ void lib_ring_buffer_copy_from_user_inatomic(const struct lttng_kernel_ring_buff
 	pagefault_disable();
 	if (likely(bytes_left_in_page == len)) {
 		ret = lib_ring_buffer_do_copy_from_user_inatomic(
-			backend_pages->p[index].virt + (offset & ~PAGE_MASK),
+			lib_ring_buffer_write_address(config, chanb,
+				backend_pages, offset),
 			src, len);
 		if (unlikely(ret > 0)) {
 			/* Copy failed. */
@@ -404,7 +431,7 @@ void lib_ring_buffer_strcpy_from_user_inatomic(const struct lttng_kernel_ring_bu
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -413,8 +440,7 @@ void lib_ring_buffer_strcpy_from_user_inatomic(const struct lttng_kernel_ring_bu
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 
 	if (unlikely(!lttng_access_ok(VERIFY_READ, src, len)))
 		goto fill_buffer;
@@ -424,22 +450,22 @@ void lib_ring_buffer_strcpy_from_user_inatomic(const struct lttng_kernel_ring_bu
 		size_t count;
 
 		count = lib_ring_buffer_do_strcpy_from_user_inatomic(config,
-					backend_pages->p[index].virt
-					    + (offset & ~PAGE_MASK),
+					lib_ring_buffer_write_address(config, chanb,
+					    backend_pages, offset),
 					src, len - 1);
 		offset += count;
 		/* Padding */
 		if (unlikely(count < len - 1)) {
 			size_t pad_len = len - 1 - count;
 
-			lib_ring_buffer_do_memset(backend_pages->p[index].virt
-						+ (offset & ~PAGE_MASK),
+			lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+						backend_pages, offset),
 					pad, pad_len);
 			offset += pad_len;
 		}
 		/* Ending '\0' */
-		lib_ring_buffer_do_memset(backend_pages->p[index].virt
-					+ (offset & ~PAGE_MASK),
+		lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+					backend_pages, offset),
 				'\0', 1);
 	} else {
 		_lib_ring_buffer_strcpy_from_user_inatomic(bufb, offset, src,
@@ -489,7 +515,7 @@ void lib_ring_buffer_pstrcpy_from_user_inatomic(const struct lttng_kernel_ring_b
 {
 	struct lttng_kernel_ring_buffer_backend *bufb = &ctx->priv.buf->backend;
 	struct channel_backend *chanb = &ctx->priv.chan->backend;
-	size_t index, bytes_left_in_page;
+	size_t bytes_left_in_page;
 	size_t offset = ctx->priv.buf_offset;
 	struct lttng_kernel_ring_buffer_backend_pages *backend_pages;
 
@@ -498,8 +524,7 @@ void lib_ring_buffer_pstrcpy_from_user_inatomic(const struct lttng_kernel_ring_b
 	backend_pages =
 		lib_ring_buffer_get_backend_pages_from_ctx(config, ctx);
 	offset &= chanb->buf_size - 1;
-	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-	bytes_left_in_page = min_t(size_t, len, (-offset) & ~PAGE_MASK);
+	bytes_left_in_page = lib_ring_buffer_write_contig_len(config, offset, len);
 
 	if (unlikely(!lttng_access_ok(VERIFY_READ, src, len)))
 		goto fill_buffer;
@@ -509,16 +534,16 @@ void lib_ring_buffer_pstrcpy_from_user_inatomic(const struct lttng_kernel_ring_b
 		size_t count;
 
 		count = lib_ring_buffer_do_strcpy_from_user_inatomic(config,
-					backend_pages->p[index].virt
-					    + (offset & ~PAGE_MASK),
+					lib_ring_buffer_write_address(config, chanb,
+					    backend_pages, offset),
 					src, len);
 		offset += count;
 		/* Padding */
 		if (unlikely(count < len)) {
 			size_t pad_len = len - count;
 
-			lib_ring_buffer_do_memset(backend_pages->p[index].virt
-						+ (offset & ~PAGE_MASK),
+			lib_ring_buffer_do_memset(lib_ring_buffer_write_address(config, chanb,
+						backend_pages, offset),
 					pad, pad_len);
 			offset += pad_len;
 		}
@@ -12,6 +12,7 @@
 
 #include <wrapper/compiler.h>
 #include <wrapper/inline_memcpy.h>
+#include <wrapper/unaligned.h>
 #include <ringbuffer/config.h>
 #include <ringbuffer/backend_types.h>
 #include <ringbuffer/frontend_types.h>
@@ -29,7 +30,7 @@ void lib_ring_buffer_backend_free(struct lttng_kernel_ring_buffer_backend *bufb)
 int channel_backend_init(struct channel_backend *chanb,
 			 const char *name,
 			 const struct lttng_kernel_ring_buffer_config *config,
-			 void *priv, size_t subbuf_size,
+			 void *priv, void *buf_addr, size_t subbuf_size,
 			 size_t num_subbuf);
 void channel_backend_free(struct channel_backend *chanb);
 
@@ -471,6 +472,38 @@ int update_read_sb_index(const struct lttng_kernel_ring_buffer_config *config,
 	return 0;
 }
 
+/*
+ * Copy small payloads (up to 64 bytes) of statically unknown size with
+ * word-sized accesses rather than calling into memcpy. The last word is
+ * copied with an overlapping access to handle the tail.
+ */
+static inline __attribute__((always_inline))
+void lttng_inline_memcpy_small(void *dest, const void *src,
+		unsigned long len)
+{
+	unsigned long i;
+
+	if (len >= sizeof(uint64_t)) {
+		for (i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+			put_unaligned(get_unaligned((const uint64_t *) (src + i)),
+				      (uint64_t *) (dest + i));
+		if (i < len)
+			put_unaligned(get_unaligned((const uint64_t *) (src + len - sizeof(uint64_t))),
+				      (uint64_t *) (dest + len - sizeof(uint64_t)));
+	} else if (len >= sizeof(uint32_t)) {
+		uint32_t head = get_unaligned((const uint32_t *) src);
+		uint32_t tail = get_unaligned((const uint32_t *) (src + len - sizeof(uint32_t)));
+
+		put_unaligned(head, (uint32_t *) dest);
+		put_unaligned(tail, (uint32_t *) (dest + len - sizeof(uint32_t)));
+	} else {
+		for (i = 0; i < len; i++)
+			((uint8_t *) dest)[i] = ((const uint8_t *) src)[i];
+	}
+}
+
+#define LTTNG_INLINE_MEMCPY_SMALL_MAX	64
+
 static inline __attribute__((always_inline))
 void lttng_inline_memcpy(void *dest, const void *src,
 		unsigned long len)
@@ -489,7 +522,10 @@ void lttng_inline_memcpy(void *dest, const void *src,
 		*(uint64_t *) dest = *(const uint64_t *) src;
 		break;
 	default:
-		inline_memcpy(dest, src, len);
+		if (len <= LTTNG_INLINE_MEMCPY_SMALL_MAX)
+			lttng_inline_memcpy_small(dest, src, len);
+		else
+			inline_memcpy(dest, src, len);
 	}
 }
 
@@ -25,6 +25,7 @@ struct lttng_kernel_ring_buffer_backend_pages {
 	union v_atomic records_commit;	/* current records committed count */
 	union v_atomic records_unread;	/* records to read */
 	unsigned long data_size;	/* Amount of data to read from subbuf */
+	void *vmap;			/* Contiguous subbuf mapping (RING_BUFFER_VMAP) */
 	struct lttng_kernel_ring_buffer_backend_page p[];
 };
 
@@ -84,6 +85,7 @@ struct channel_backend {
 	unsigned long num_subbuf;	/* Number of sub-buffers for writer */
 	u64 start_timestamp;		/* Channel creation timestamp value */
 	void *priv;			/* Client-specific information */
+	void *buf_addr;			/* Preallocated memory (RING_BUFFER_STATIC) */
 	void *priv_ops;			/* Client-specific ops pointer */
 	void (*release_priv_ops)(void *priv_ops);
 #if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(4,10,0))
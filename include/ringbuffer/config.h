@@ -126,14 +126,14 @@ struct lttng_kernel_ring_buffer_config {
 	enum {
 		RING_BUFFER_SPLICE,
 		RING_BUFFER_MMAP,
-		RING_BUFFER_READ,		/* TODO */
+		RING_BUFFER_READ,
 		RING_BUFFER_ITERATOR,
 		RING_BUFFER_NONE,
 	} output;
 	enum {
 		RING_BUFFER_PAGE,
-		RING_BUFFER_VMAP,		/* TODO */
-		RING_BUFFER_STATIC,		/* TODO */
+		RING_BUFFER_VMAP,
+		RING_BUFFER_STATIC,
 	} backend;
 	enum {
 		RING_BUFFER_NO_OOPS_CONSISTENCY,
@@ -67,6 +67,22 @@ struct lttng_kernel_ring_buffer_channel *channel_create(const struct lttng_kerne
 extern
 void *channel_destroy(struct lttng_kernel_ring_buffer_channel *chan);
 
+extern
+void channel_set_read_timer_adaptive(struct lttng_kernel_ring_buffer_channel *chan,
+				     int adaptive);
+
+/*
+ * The channel ready set reports which buffers of the channel have
+ * sub-buffers to deliver, so a single reader can wait for the whole
+ * channel rather than polling each buffer. Ready set readers wait on
+ * chan->ready_wait.
+ */
+extern int channel_ready_set_open(struct lttng_kernel_ring_buffer_channel *chan);
+extern void channel_ready_set_release(struct lttng_kernel_ring_buffer_channel *chan);
+extern bool channel_ready_set_fetch(struct lttng_kernel_ring_buffer_channel *chan,
+				    unsigned long *ready);
+extern bool channel_ready_set_empty(struct lttng_kernel_ring_buffer_channel *chan);
+
 
 /* Buffer read operations */
 
@@ -14,6 +14,7 @@
 
 #include <linux/kref.h>
 #include <linux/irq_work.h>
+#include <linux/mutex.h>
 #include <ringbuffer/config.h>
 #include <ringbuffer/backend_types.h>
 #include <lttng/prio_heap.h>	/* For per-CPU read-side iterator */
@@ -54,6 +55,7 @@ struct lttng_kernel_ring_buffer_channel {
 
 	unsigned long switch_timer_interval;	/* Buffer flush (jiffies) */
 	unsigned long read_timer_interval;	/* Reader wakeup (jiffies) */
+	int read_timer_adaptive;		/* Scale reader wakeup with fill rate */
 #if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(4,10,0))
 	struct lttng_cpuhp_node cpuhp_prepare;
 	struct lttng_cpuhp_node cpuhp_online;
@@ -68,6 +70,11 @@ struct lttng_kernel_ring_buffer_channel {
 	wait_queue_head_t read_wait;		/* reader wait queue */
 	wait_queue_head_t hp_wait;		/* CPU hotplug wait queue */
 	struct irq_work wakeup_pending;		/* Pending wakeup irq work */
+	wait_queue_head_t ready_wait;		/* Ready set reader wait queue */
+	struct irq_work ready_wakeup_pending;	/* Pending ready set wakeup irq work */
+	unsigned long *ready_set;		/* Buffers with data to deliver, by cpu */
+	unsigned long ready_signaled;		/* Ready set readers were woken up */
+	unsigned long ready_set_opened;		/* A ready set reader is open */
 	int finalized;				/* Has channel been finalized */
 	struct channel_iter iter;		/* Channel read-side iterator */
 	struct kref ref;			/* Reference count */
@@ -147,11 +154,16 @@ struct lttng_kernel_ring_buffer {
 	union v_atomic records_count;	/* Number of records written */
 	union v_atomic records_overrun;	/* Number of overwritten records */
 	wait_queue_head_t read_wait;	/* reader buffer-level wait queue */
+	struct mutex read_mutex;	/* Serializes read() of whole packets */
 	wait_queue_head_t write_wait;	/* writer buffer-level wait queue (for metadata only) */
 	struct irq_work wakeup_pending;		/* Pending wakeup irq work */
 	int finalized;			/* buffer has been finalized */
 	struct timer_list switch_timer;	/* timer for periodical switch */
 	struct timer_list read_timer;	/* timer for read poll */
+	union v_atomic read_timer_delivered;	/* Sub-buffers delivered by writers */
+	unsigned long read_timer_delivered_snapshot;	/* Delivered count at last read timer */
+	unsigned long read_timer_cur_interval;	/* Adaptive reader wakeup (jiffies) */
+	int read_timer_idle;		/* Adaptive read timer is backed off */
 	raw_spinlock_t raw_tick_nohz_spinlock;	/* nohz entry lock/trylock */
 	struct lttng_kernel_ring_buffer_iter iter;	/* read-side iterator */
 	unsigned long get_subbuf_consumed;	/* Read-side consumed */
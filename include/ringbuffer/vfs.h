@@ -34,6 +34,8 @@ ssize_t lib_ring_buffer_splice_read(struct file *in, loff_t *ppos,
 		unsigned int flags, struct lttng_kernel_ring_buffer *buf);
 int lib_ring_buffer_mmap(struct file *filp, struct vm_area_struct *vma,
 		struct lttng_kernel_ring_buffer *buf);
+ssize_t lib_ring_buffer_read_packets(struct file *filp, char __user *user_buf,
+		size_t count, struct lttng_kernel_ring_buffer *buf);
 
 /* Ring Buffer ioctl() and ioctl numbers */
 long lib_ring_buffer_ioctl(struct file *filp, unsigned int cmd,
@@ -51,6 +53,8 @@ int vfs_lib_ring_buffer_mmap(struct file *filp, struct vm_area_struct *vma);
 ssize_t vfs_lib_ring_buffer_splice_read(struct file *in, loff_t *ppos,
 		struct pipe_inode_info *pipe, size_t len,
 		unsigned int flags);
+ssize_t vfs_lib_ring_buffer_read(struct file *filp, char __user *user_buf,
+		size_t count, loff_t *ppos);
 
 /*
  * Use LTTNG_KERNEL_ABI_RING_BUFFER_GET_NEXT_SUBBUF / LTTNG_KERNEL_ABI_RING_BUFFER_PUT_NEXT_SUBBUF to read and
@@ -21,6 +21,13 @@ void wrapper_vm_flags_set(struct vm_area_struct *vma,
 {
 	vm_flags_set(vma, flags);
 }
+
+static inline
+void wrapper_vm_flags_clear(struct vm_area_struct *vma,
+		vm_flags_t flags)
+{
+	vm_flags_clear(vma, flags);
+}
 #else
 static inline
 void wrapper_vm_flags_set(struct vm_area_struct *vma,
@@ -28,6 +35,13 @@ void wrapper_vm_flags_set(struct vm_area_struct *vma,
 {
 	vma->vm_flags |= flags;
 }
+
+static inline
+void wrapper_vm_flags_clear(struct vm_area_struct *vma,
+		vm_flags_t flags)
+{
+	vma->vm_flags &= ~flags;
+}
 #endif
 
 #if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(4,6,0) \
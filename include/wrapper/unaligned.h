@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * wrapper/unaligned.h
+ *
+ * wrapper around get_unaligned/put_unaligned.
+ */
+
+#ifndef _LTTNG_WRAPPER_UNALIGNED_H
+#define _LTTNG_WRAPPER_UNALIGNED_H
+
+#include <lttng/kernel-version.h>
+
+#if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(6,12,0))
+#include <linux/unaligned.h>
+#else
+#include <asm/unaligned.h>
+#endif
+
+#endif /* _LTTNG_WRAPPER_UNALIGNED_H */
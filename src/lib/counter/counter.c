@@ -9,11 +9,15 @@
 #include <linux/slab.h>
 #include <lttng/tracer.h>
 #include <linux/cpumask.h>
+#include <linux/mm.h>
+#include <linux/smp.h>
 #include <counter/counter.h>
 #include <counter/counter-internal.h>
 #include <wrapper/compiler_attributes.h>
+#include <wrapper/cpu.h>
 #include <wrapper/vmalloc.h>
 #include <wrapper/limits.h>
+#include <wrapper/mm.h>
 
 static size_t lttng_counter_get_dimension_nr_elements(struct lib_counter_dimension *dimension)
 {
@@ -63,8 +67,11 @@ static int lttng_counter_layout_init(struct lib_counter *counter, int cpu)
 	default:
 		return -EINVAL;
 	}
-	layout->counters = lttng_kvzalloc_node(ALIGN(counter_size * nr_elem,
-						     1 << INTERNODE_CACHE_SHIFT),
+	/*
+	 * Page-aligned, so the counters can be mapped to user-space
+	 * without exposing neighbouring allocations.
+	 */
+	layout->counters = lttng_kvzalloc_node(PAGE_ALIGN(counter_size * nr_elem),
 					       GFP_KERNEL | __GFP_NOWARN,
 					       cpu_to_node(max(cpu, 0)));
 	if (!layout->counters)
@@ -150,6 +157,9 @@ int validate_args(const struct lib_counter_config *config,
 	if (global_sum_step && (!(config->alloc & COUNTER_ALLOC_GLOBAL) ||
 			!(config->alloc & COUNTER_ALLOC_PER_CPU)))
 		return -1;
+	/* Saturated per-cpu counters are not carried to the global counters. */
+	if (global_sum_step && config->arithmetic == COUNTER_ARITHMETIC_SATURATE)
+		return -1;
 	return 0;
 }
 
@@ -184,7 +194,11 @@ struct lib_counter *lttng_counter_create(const struct lib_counter_config *config
 
 	if (lttng_counter_init_stride(config, counter))
 		goto error_init_stride;
-	//TODO saturation values.
+	/*
+	 * Saturating counters clamp at the limits of their counter size
+	 * (see lttng_counter_saturate_add()), and flag the clamping as an
+	 * overflow or underflow.
+	 */
 	for (dimension = 0; dimension < counter->nr_dimensions; dimension++)
 		nr_elem *= lttng_counter_get_dimension_nr_elements(&counter->dimensions[dimension]);
 	counter->allocated_elem = nr_elem;
@@ -238,73 +252,89 @@ void lttng_counter_destroy(struct lib_counter *counter)
 }
 EXPORT_SYMBOL_GPL(lttng_counter_destroy);
 
-int lttng_counter_read(const struct lib_counter_config *config,
-		       struct lib_counter *counter,
-		       const size_t *dimension_indexes,
-		       int cpu, int64_t *value, bool *overflow,
-		       bool *underflow)
+static
+int lttng_counter_get_layout(const struct lib_counter_config *config,
+			     struct lib_counter *counter, int cpu,
+			     struct lib_counter_layout **layoutp)
 {
-	struct lib_counter_layout *layout;
-	size_t index;
-
-	if (unlikely(lttng_counter_validate_indexes(config, counter, dimension_indexes)))
-		return -EOVERFLOW;
-	index = lttng_counter_get_index(config, counter, dimension_indexes);
-
 	switch (config->alloc) {
 	case COUNTER_ALLOC_PER_CPU:
 		if (cpu < 0 || cpu >= num_possible_cpus())
 			return -EINVAL;
-		layout = per_cpu_ptr(counter->percpu_counters, cpu);
+		*layoutp = per_cpu_ptr(counter->percpu_counters, cpu);
 		break;
 	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
 		if (cpu >= 0) {
 			if (cpu >= num_possible_cpus())
 				return -EINVAL;
-			layout = per_cpu_ptr(counter->percpu_counters, cpu);
+			*layoutp = per_cpu_ptr(counter->percpu_counters, cpu);
 		} else {
-			layout = &counter->global_counters;
+			*layoutp = &counter->global_counters;
 		}
 		break;
 	case COUNTER_ALLOC_GLOBAL:
 		if (cpu >= 0)
 			return -EINVAL;
-		layout = &counter->global_counters;
+		*layoutp = &counter->global_counters;
 		break;
 	default:
 		return -EINVAL;
 	}
+	return 0;
+}
 
+static
+int64_t lttng_counter_layout_read(const struct lib_counter_config *config,
+				  struct lib_counter_layout *layout,
+				  size_t index)
+{
 	switch (config->counter_size) {
 	case COUNTER_SIZE_8_BIT:
 	{
 		int8_t *int_p = (int8_t *) layout->counters + index;
-		*value = (int64_t) READ_ONCE(*int_p);
-		break;
+		return (int64_t) READ_ONCE(*int_p);
 	}
 	case COUNTER_SIZE_16_BIT:
 	{
 		int16_t *int_p = (int16_t *) layout->counters + index;
-		*value = (int64_t) READ_ONCE(*int_p);
-		break;
+		return (int64_t) READ_ONCE(*int_p);
 	}
 	case COUNTER_SIZE_32_BIT:
 	{
 		int32_t *int_p = (int32_t *) layout->counters + index;
-		*value = (int64_t) READ_ONCE(*int_p);
-		break;
+		return (int64_t) READ_ONCE(*int_p);
 	}
 #if BITS_PER_LONG == 64
 	case COUNTER_SIZE_64_BIT:
 	{
 		int64_t *int_p = (int64_t *) layout->counters + index;
-		*value = READ_ONCE(*int_p);
-		break;
+		return READ_ONCE(*int_p);
 	}
 #endif
 	default:
 		WARN_ON_ONCE(1);
+		return 0;
 	}
+}
+
+int lttng_counter_read(const struct lib_counter_config *config,
+		       struct lib_counter *counter,
+		       const size_t *dimension_indexes,
+		       int cpu, int64_t *value, bool *overflow,
+		       bool *underflow)
+{
+	struct lib_counter_layout *layout;
+	size_t index;
+	int ret;
+
+	if (unlikely(lttng_counter_validate_indexes(config, counter, dimension_indexes)))
+		return -EOVERFLOW;
+	index = lttng_counter_get_index(config, counter, dimension_indexes);
+
+	ret = lttng_counter_get_layout(config, counter, cpu, &layout);
+	if (ret)
+		return ret;
+	*value = lttng_counter_layout_read(config, layout, index);
 	*overflow = test_bit(index, layout->overflow_bitmap);
 	*underflow = test_bit(index, layout->underflow_bitmap);
 	return 0;
@@ -374,41 +404,290 @@ int lttng_counter_aggregate(const struct lib_counter_config *config,
 EXPORT_SYMBOL_GPL(lttng_counter_aggregate);
 
 static
-int lttng_counter_clear_cpu(const struct lib_counter_config *config,
-			    struct lib_counter *counter,
-			    const size_t *dimension_indexes,
-			    int cpu)
+int lttng_counter_validate_range(struct lib_counter *counter,
+				 size_t index, size_t nr_elem)
 {
-	struct lib_counter_layout *layout;
-	size_t index;
+	size_t allocated_elem = (size_t) counter->allocated_elem;
 
-	if (unlikely(lttng_counter_validate_indexes(config, counter, dimension_indexes)))
+	if (index > allocated_elem || nr_elem > allocated_elem - index)
 		return -EOVERFLOW;
-	index = lttng_counter_get_index(config, counter, dimension_indexes);
+	return 0;
+}
+
+/*
+ * Read the @nr_elem counters starting at linear index @index, in
+ * index order (the last dimension varies fastest), of a specific cpu
+ * if @cpu >= 0, or of the global counter if @cpu == -1.
+ */
+int lttng_counter_read_range(const struct lib_counter_config *config,
+			     struct lib_counter *counter,
+			     size_t index, size_t nr_elem, int cpu,
+			     int64_t *values, bool *overflow,
+			     bool *underflow)
+{
+	struct lib_counter_layout *layout;
+	size_t i;
+	int ret;
+
+	ret = lttng_counter_validate_range(counter, index, nr_elem);
+	if (ret)
+		return ret;
+	ret = lttng_counter_get_layout(config, counter, cpu, &layout);
+	if (ret)
+		return ret;
+	for (i = 0; i < nr_elem; i++) {
+		values[i] = lttng_counter_layout_read(config, layout, index + i);
+		overflow[i] = test_bit(index + i, layout->overflow_bitmap);
+		underflow[i] = test_bit(index + i, layout->underflow_bitmap);
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lttng_counter_read_range);
+
+/*
+ * Atomically read and reset a counter. Increments are either counted
+ * in the returned value or left in the counter.
+ */
+static
+int64_t lttng_counter_layout_exchange(const struct lib_counter_config *config,
+				      struct lib_counter_layout *layout,
+				      size_t index)
+{
+	switch (config->counter_size) {
+	case COUNTER_SIZE_8_BIT:
+	{
+		int8_t *int_p = (int8_t *) layout->counters + index;
+		return (int64_t) xchg(int_p, 0);
+	}
+	case COUNTER_SIZE_16_BIT:
+	{
+		int16_t *int_p = (int16_t *) layout->counters + index;
+		return (int64_t) xchg(int_p, 0);
+	}
+	case COUNTER_SIZE_32_BIT:
+	{
+		int32_t *int_p = (int32_t *) layout->counters + index;
+		return (int64_t) xchg(int_p, 0);
+	}
+#if BITS_PER_LONG == 64
+	case COUNTER_SIZE_64_BIT:
+	{
+		int64_t *int_p = (int64_t *) layout->counters + index;
+		return xchg(int_p, 0);
+	}
+#endif
+	default:
+		WARN_ON_ONCE(1);
+		return 0;
+	}
+}
+
+/*
+ * Add the @nr_elem counters of @layout starting at linear index @index
+ * to @values, resetting them if @exchange is set.
+ */
+static
+void lttng_counter_layout_sum_range(const struct lib_counter_config *config,
+				    struct lib_counter_layout *layout,
+				    size_t index, size_t nr_elem,
+				    int64_t *values, bool *overflow,
+				    bool *underflow, bool exchange)
+{
+	size_t i;
+
+	for (i = 0; i < nr_elem; i++) {
+		int64_t old = values[i], v;
+
+		if (exchange) {
+			v = lttng_counter_layout_exchange(config, layout, index + i);
+			overflow[i] |= test_and_clear_bit(index + i, layout->overflow_bitmap);
+			underflow[i] |= test_and_clear_bit(index + i, layout->underflow_bitmap);
+		} else {
+			v = lttng_counter_layout_read(config, layout, index + i);
+			overflow[i] |= test_bit(index + i, layout->overflow_bitmap);
+			underflow[i] |= test_bit(index + i, layout->underflow_bitmap);
+		}
+		/* Overflow is defined on unsigned types. */
+		values[i] = (int64_t) ((uint64_t) old + (uint64_t) v);
+		if (v > 0 && values[i] < old)
+			overflow[i] = true;
+		else if (v < 0 && values[i] > old)
+			underflow[i] = true;
+	}
+}
+
+/*
+ * Aggregate the @nr_elem counters starting at linear index @index, in
+ * index order. Each counter array is walked sequentially, one after
+ * the other, rather than gathering each element across all cpus.
+ */
+int lttng_counter_aggregate_range(const struct lib_counter_config *config,
+				  struct lib_counter *counter,
+				  size_t index, size_t nr_elem,
+				  int64_t *values, bool *overflow,
+				  bool *underflow)
+{
+	int cpu, ret;
+
+	ret = lttng_counter_validate_range(counter, index, nr_elem);
+	if (ret)
+		return ret;
+	memset(values, 0, nr_elem * sizeof(*values));
+	memset(overflow, 0, nr_elem * sizeof(*overflow));
+	memset(underflow, 0, nr_elem * sizeof(*underflow));
 
 	switch (config->alloc) {
+	case COUNTER_ALLOC_GLOBAL:
+		lttng_fallthrough;
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		lttng_counter_layout_sum_range(config, &counter->global_counters,
+					       index, nr_elem, values, overflow, underflow,
+					       false);
+		break;
 	case COUNTER_ALLOC_PER_CPU:
-		if (cpu < 0 || cpu >= num_possible_cpus())
-			return -EINVAL;
-		layout = per_cpu_ptr(counter->percpu_counters, cpu);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	switch (config->alloc) {
+	case COUNTER_ALLOC_GLOBAL:
 		break;
 	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
-		if (cpu >= 0) {
-			if (cpu >= num_possible_cpus())
-				return -EINVAL;
-			layout = per_cpu_ptr(counter->percpu_counters, cpu);
-		} else {
-			layout = &counter->global_counters;
-		}
+		lttng_fallthrough;
+	case COUNTER_ALLOC_PER_CPU:
+		for (cpu = 0; cpu < num_possible_cpus(); cpu++)
+			lttng_counter_layout_sum_range(config,
+					per_cpu_ptr(counter->percpu_counters, cpu),
+					index, nr_elem, values, overflow, underflow,
+					false);
 		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lttng_counter_aggregate_range);
+
+struct lttng_counter_exchange_args {
+	const struct lib_counter_config *config;
+	struct lib_counter_layout *layout;
+	size_t index, nr_elem;
+	int64_t *values;
+	bool *overflow, *underflow;
+};
+
+static
+void lttng_counter_exchange_ipi(void *info)
+{
+	struct lttng_counter_exchange_args *args = info;
+
+	lttng_counter_layout_sum_range(args->config, args->layout,
+				       args->index, args->nr_elem, args->values,
+				       args->overflow, args->underflow, true);
+}
+
+/*
+ * Per-cpu counters updated with cpu-local atomic operations are only
+ * atomic with respect to their own cpu, so they are exchanged on it.
+ * Counters of offline cpus cannot be updated concurrently.
+ */
+static
+void lttng_counter_exchange_cpu(const struct lib_counter_config *config,
+				struct lib_counter *counter, int cpu,
+				size_t index, size_t nr_elem,
+				int64_t *values, bool *overflow,
+				bool *underflow)
+{
+	struct lttng_counter_exchange_args args = {
+		.config = config,
+		.layout = per_cpu_ptr(counter->percpu_counters, cpu),
+		.index = index,
+		.nr_elem = nr_elem,
+		.values = values,
+		.overflow = overflow,
+		.underflow = underflow,
+	};
+
+	if (config->sync == COUNTER_SYNC_PER_CPU && cpu_online(cpu)) {
+		if (!smp_call_function_single(cpu, lttng_counter_exchange_ipi, &args, 1))
+			return;
+	}
+	lttng_counter_exchange_ipi(&args);
+}
+
+/*
+ * Aggregate the @nr_elem counters starting at linear index @index, in
+ * index order, resetting each counter to zero as it is read. Each
+ * increment is counted by exactly one exchange: a global sum step
+ * carry racing with the exchange is counted by the next one.
+ */
+int lttng_counter_exchange_range(const struct lib_counter_config *config,
+				 struct lib_counter *counter,
+				 size_t index, size_t nr_elem,
+				 int64_t *values, bool *overflow,
+				 bool *underflow)
+{
+	int cpu, ret;
+
+	ret = lttng_counter_validate_range(counter, index, nr_elem);
+	if (ret)
+		return ret;
+	memset(values, 0, nr_elem * sizeof(*values));
+	memset(overflow, 0, nr_elem * sizeof(*overflow));
+	memset(underflow, 0, nr_elem * sizeof(*underflow));
+
+	switch (config->alloc) {
 	case COUNTER_ALLOC_GLOBAL:
-		if (cpu >= 0)
-			return -EINVAL;
-		layout = &counter->global_counters;
+		lttng_fallthrough;
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		lttng_counter_layout_sum_range(config, &counter->global_counters,
+					       index, nr_elem, values, overflow, underflow,
+					       true);
+		break;
+	case COUNTER_ALLOC_PER_CPU:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	switch (config->alloc) {
+	case COUNTER_ALLOC_GLOBAL:
+		break;
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		lttng_fallthrough;
+	case COUNTER_ALLOC_PER_CPU:
+		/* Prevent cpus from coming online while exchanging their counters. */
+		lttng_cpus_read_lock();
+		for (cpu = 0; cpu < num_possible_cpus(); cpu++)
+			lttng_counter_exchange_cpu(config, counter, cpu,
+					index, nr_elem, values, overflow, underflow);
+		lttng_cpus_read_unlock();
 		break;
 	default:
 		return -EINVAL;
 	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lttng_counter_exchange_range);
+
+static
+int lttng_counter_clear_cpu(const struct lib_counter_config *config,
+			    struct lib_counter *counter,
+			    const size_t *dimension_indexes,
+			    int cpu)
+{
+	struct lib_counter_layout *layout;
+	size_t index;
+	int ret;
+
+	if (unlikely(lttng_counter_validate_indexes(config, counter, dimension_indexes)))
+		return -EOVERFLOW;
+	index = lttng_counter_get_index(config, counter, dimension_indexes);
+
+	ret = lttng_counter_get_layout(config, counter, cpu, &layout);
+	if (ret)
+		return ret;
 	switch (config->counter_size) {
 	case COUNTER_SIZE_8_BIT:
 	{
@@ -504,6 +783,78 @@ int lttng_counter_get_max_nr_elem(const struct lib_counter_config *config,
 }
 EXPORT_SYMBOL_GPL(lttng_counter_get_max_nr_elem);
 
+/*
+ * The counter arrays are mapped one after the other: the per-cpu
+ * arrays, in cpu order, followed by the global array. Each array
+ * holds the counters in index order and is padded to a page multiple.
+ */
+int lttng_counter_get_map_layout(const struct lib_counter_config *config,
+				 struct lib_counter *counter,
+				 struct lib_counter_map_layout *map_layout)
+{
+	map_layout->elem_size = (size_t) config->counter_size;
+	map_layout->nr_elem = (size_t) counter->allocated_elem;
+	map_layout->array_len = PAGE_ALIGN(map_layout->elem_size * map_layout->nr_elem);
+	map_layout->nr_cpus = (config->alloc & COUNTER_ALLOC_PER_CPU) ? num_possible_cpus() : 0;
+	map_layout->global = config->alloc & COUNTER_ALLOC_GLOBAL;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lttng_counter_get_map_layout);
+
+/*
+ * Map one counter array read-only into @vma. The mapping offset selects
+ * the array, as described by lttng_counter_get_map_layout(). Only the
+ * counters are mapped: overflow and underflow state is available
+ * through the read operations.
+ *
+ * The caller must keep the counter alive as long as the mapping exists.
+ */
+int lttng_counter_map(const struct lib_counter_config *config,
+		      struct lib_counter *counter,
+		      struct vm_area_struct *vma)
+{
+	unsigned long length = vma->vm_end - vma->vm_start;
+	struct lib_counter_map_layout map_layout;
+	struct lib_counter_layout *layout;
+	unsigned long array_pages, offset;
+	int ret;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	ret = lttng_counter_get_map_layout(config, counter, &map_layout);
+	if (ret)
+		return ret;
+	array_pages = map_layout.array_len >> PAGE_SHIFT;
+	if (length != map_layout.array_len || vma->vm_pgoff % array_pages)
+		return -EINVAL;
+	if (vma->vm_pgoff / array_pages < map_layout.nr_cpus)
+		ret = lttng_counter_get_layout(config, counter,
+				vma->vm_pgoff / array_pages, &layout);
+	else if (vma->vm_pgoff / array_pages == map_layout.nr_cpus && map_layout.global)
+		ret = lttng_counter_get_layout(config, counter, -1, &layout);
+	else
+		ret = -EINVAL;
+	if (ret)
+		return ret;
+	if (WARN_ON_ONCE(!PAGE_ALIGNED(layout->counters)))
+		return -EINVAL;
+
+	wrapper_vm_flags_clear(vma, VM_MAYWRITE);
+	if (!is_vmalloc_addr(layout->counters))
+		return remap_pfn_range(vma, vma->vm_start,
+				virt_to_phys(layout->counters) >> PAGE_SHIFT,
+				length, vma->vm_page_prot);
+	for (offset = 0; offset < length; offset += PAGE_SIZE) {
+		ret = remap_pfn_range(vma, vma->vm_start + offset,
+				vmalloc_to_pfn(layout->counters + offset),
+				PAGE_SIZE, vma->vm_page_prot);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(lttng_counter_map);
+
 MODULE_LICENSE("GPL and additional rights");
 MODULE_AUTHOR("Mathieu Desnoyers <mathieu.desnoyers@efficios.com>");
 MODULE_DESCRIPTION("LTTng counter library");
@@ -22,6 +22,19 @@
 #include <ringbuffer/backend.h>
 #include <ringbuffer/frontend.h>
 
+/*
+ * Page frame number backing an address of the RING_BUFFER_STATIC
+ * preallocated memory, which may be either in the linear mapping or
+ * remapped into the vmalloc area.
+ */
+static
+unsigned long lib_ring_buffer_static_pfn(void *virt)
+{
+	if (is_vmalloc_addr(virt))
+		return vmalloc_to_pfn(virt);
+	return page_to_pfn(virt_to_page(virt));
+}
+
 /**
  * lib_ring_buffer_backend_allocate - allocate a channel buffer
  * @config: ring buffer instance configuration
@@ -40,7 +53,8 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 	unsigned long j, num_pages, num_pages_per_subbuf, page_idx = 0;
 	unsigned long subbuf_size, mmap_offset = 0;
 	unsigned long num_subbuf_alloc;
-	struct page **pages;
+	struct page **pages = NULL;
+	void *static_addr = NULL;
 	unsigned long i;
 
 	num_pages = size >> PAGE_SHIFT;
@@ -51,8 +65,10 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 	 * wrapper_check_enough_free_pages uses si_mem_available() if available
 	 * and returns if there should be enough free pages based on the
 	 * current estimate.
+	 * The static backend uses preallocated memory for its pages.
 	 */
-	if (!wrapper_check_enough_free_pages(num_pages))
+	if (config->backend != RING_BUFFER_STATIC
+			&& !wrapper_check_enough_free_pages(num_pages))
 		goto not_enough_pages;
 
 	/*
@@ -72,11 +88,20 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 		num_subbuf_alloc++;
 	}
 
-	pages = vmalloc_node(ALIGN(sizeof(*pages) * num_pages,
-				   1 << INTERNODE_CACHE_SHIFT),
-			cpu_to_node(max(bufb->cpu, 0)));
-	if (unlikely(!pages))
-		goto pages_error;
+	if (config->backend == RING_BUFFER_STATIC) {
+		/*
+		 * Each buffer of the channel takes its own slice of the
+		 * preallocated memory, indexed by cpu number.
+		 */
+		static_addr = chanb->buf_addr
+			+ max(bufb->cpu, 0) * (num_pages << PAGE_SHIFT);
+	} else {
+		pages = vmalloc_node(ALIGN(sizeof(*pages) * num_pages,
+					   1 << INTERNODE_CACHE_SHIFT),
+				cpu_to_node(max(bufb->cpu, 0)));
+		if (unlikely(!pages))
+			goto pages_error;
+	}
 
 	bufb->array = lttng_kvmalloc_node(ALIGN(sizeof(*bufb->array)
 					 * num_subbuf_alloc,
@@ -86,7 +111,7 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 	if (unlikely(!bufb->array))
 		goto array_error;
 
-	for (i = 0; i < num_pages; i++) {
+	for (i = 0; pages && i < num_pages; i++) {
 		pages[i] = alloc_pages_node(cpu_to_node(max(bufb->cpu, 0)),
 				GFP_KERNEL | __GFP_NOWARN | __GFP_ZERO, 0);
 		if (unlikely(!pages[i]))
@@ -142,8 +167,16 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 	for (i = 0; i < num_subbuf_alloc; i++) {
 		for (j = 0; j < num_pages_per_subbuf; j++) {
 			CHAN_WARN_ON(chanb, page_idx > num_pages);
-			bufb->array[i]->p[j].virt = page_address(pages[page_idx]);
-			bufb->array[i]->p[j].pfn = page_to_pfn(pages[page_idx]);
+			if (config->backend == RING_BUFFER_STATIC) {
+				void *virt = static_addr + (page_idx << PAGE_SHIFT);
+
+				bufb->array[i]->p[j].virt = virt;
+				bufb->array[i]->p[j].pfn =
+					lib_ring_buffer_static_pfn(virt);
+			} else {
+				bufb->array[i]->p[j].virt = page_address(pages[page_idx]);
+				bufb->array[i]->p[j].pfn = page_to_pfn(pages[page_idx]);
+			}
 			page_idx++;
 		}
 		if (config->output == RING_BUFFER_MMAP) {
@@ -152,6 +185,21 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 		}
 	}
 
+	/*
+	 * The vmap backend maps each sub-buffer into a virtually contiguous
+	 * range, so records can be written and read without splitting them
+	 * at page boundaries.
+	 */
+	if (config->backend == RING_BUFFER_VMAP) {
+		for (i = 0; i < num_subbuf_alloc; i++) {
+			bufb->array[i]->vmap =
+				vmap(&pages[i * num_pages_per_subbuf],
+				     num_pages_per_subbuf, VM_MAP, PAGE_KERNEL);
+			if (unlikely(!bufb->array[i]->vmap))
+				goto free_vmap;
+		}
+	}
+
 	/*
 	 * If kmalloc ever uses vmalloc underneath, make sure the buffer pages
 	 * will not fault.
@@ -161,6 +209,12 @@ int lib_ring_buffer_backend_allocate(const struct lttng_kernel_ring_buffer_confi
 	vfree(pages);
 	return 0;
 
+free_vmap:
+	for (i = 0; i < num_subbuf_alloc; i++) {
+		if (bufb->array[i]->vmap)
+			vunmap(bufb->array[i]->vmap);
+	}
+	lttng_kvfree(bufb->buf_cnt);
 free_wsb:
 	lttng_kvfree(bufb->buf_wsb);
 free_array:
@@ -168,7 +222,7 @@ free_array:
 		lttng_kvfree(bufb->array[i]);
 depopulate:
 	/* Free all allocated pages */
-	for (i = 0; (i < num_pages && pages[i]); i++)
+	for (i = 0; (pages && i < num_pages && pages[i]); i++)
 		__free_page(pages[i]);
 	lttng_kvfree(bufb->array);
 array_error:
@@ -195,6 +249,7 @@ int lib_ring_buffer_backend_create(struct lttng_kernel_ring_buffer_backend *bufb
 void lib_ring_buffer_backend_free(struct lttng_kernel_ring_buffer_backend *bufb)
 {
 	struct channel_backend *chanb = &bufb->chan->backend;
+	const struct lttng_kernel_ring_buffer_config *config = &chanb->config;
 	unsigned long i, j, num_subbuf_alloc;
 
 	num_subbuf_alloc = chanb->num_subbuf;
@@ -204,7 +259,10 @@ void lib_ring_buffer_backend_free(struct lttng_kernel_ring_buffer_backend *bufb)
 	lttng_kvfree(bufb->buf_wsb);
 	lttng_kvfree(bufb->buf_cnt);
 	for (i = 0; i < num_subbuf_alloc; i++) {
-		for (j = 0; j < bufb->num_pages_per_subbuf; j++)
+		if (bufb->array[i]->vmap)
+			vunmap(bufb->array[i]->vmap);
+		for (j = 0; config->backend != RING_BUFFER_STATIC
+				&& j < bufb->num_pages_per_subbuf; j++)
 			__free_page(pfn_to_page(bufb->array[i]->p[j].pfn));
 		lttng_kvfree(bufb->array[i]);
 	}
@@ -349,7 +407,7 @@ int lib_ring_buffer_cpu_hp_callback(struct notifier_block *nb,
  * @name: channel name
  * @config: client ring buffer configuration
  * @priv: client private data
- * @parent: dentry of parent directory, %NULL for root directory
+ * @buf_addr: preallocated memory, page aligned (RING_BUFFER_STATIC only)
  * @subbuf_size: size of sub-buffers (> PAGE_SIZE, power of 2)
  * @num_subbuf: number of sub-buffers (power of 2)
  *
@@ -364,7 +422,8 @@ int lib_ring_buffer_cpu_hp_callback(struct notifier_block *nb,
 int channel_backend_init(struct channel_backend *chanb,
 			 const char *name,
 			 const struct lttng_kernel_ring_buffer_config *config,
-			 void *priv, size_t subbuf_size, size_t num_subbuf)
+			 void *priv, void *buf_addr, size_t subbuf_size,
+			 size_t num_subbuf)
 {
 	struct lttng_kernel_ring_buffer_channel *chan = container_of(chanb, struct lttng_kernel_ring_buffer_channel, backend);
 	unsigned int i;
@@ -396,7 +455,16 @@ int channel_backend_init(struct channel_backend *chanb,
 	if (ret)
 		return ret;
 
+	/*
+	 * The static backend carves its buffers out of memory provided by
+	 * the client, which must hold one buffer per possible cpu.
+	 */
+	if (config->backend == RING_BUFFER_STATIC
+			&& (!buf_addr || !PAGE_ALIGNED(buf_addr)))
+		return -EINVAL;
+
 	chanb->priv = priv;
+	chanb->buf_addr = buf_addr;
 	chanb->buf_size = num_subbuf * subbuf_size;
 	chanb->subbuf_size = subbuf_size;
 	chanb->buf_size_order = get_count_order(chanb->buf_size);
@@ -559,6 +627,37 @@ void channel_backend_free(struct channel_backend *chanb)
 	}
 }
 
+/*
+ * Writes never cross sub-buffers, so the backend pages of a write are
+ * looked up once, and the write is split into the head of its first
+ * page followed by whole pages.
+ */
+static
+struct lttng_kernel_ring_buffer_backend_pages *
+	lib_ring_buffer_write_get_pages(struct lttng_kernel_ring_buffer_backend *bufb,
+					size_t offset, size_t len)
+{
+	struct channel_backend *chanb = &bufb->chan->backend;
+	const struct lttng_kernel_ring_buffer_config *config = &chanb->config;
+	unsigned long sb_bindex, id;
+	size_t sbidx;
+
+	/*
+	 * Underlying layer should never ask for writes across
+	 * subbuffers.
+	 */
+	CHAN_WARN_ON(chanb, offset >= chanb->buf_size);
+	CHAN_WARN_ON(chanb, (offset & (chanb->subbuf_size - 1)) + len
+		     > chanb->subbuf_size);
+
+	sbidx = offset >> chanb->subbuf_size_order;
+	id = bufb->buf_wsb[sbidx].id;
+	sb_bindex = subbuffer_id_get_index(config, id);
+	CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
+		     && subbuffer_id_is_noref(config, id));
+	return bufb->array[sb_bindex];
+}
+
 /**
  * lib_ring_buffer_write - write data to a ring_buffer buffer.
  * @bufb : buffer backend
@@ -571,34 +670,26 @@ void _lib_ring_buffer_write(struct lttng_kernel_ring_buffer_backend *bufb, size_
 {
 	struct channel_backend *chanb = &bufb->chan->backend;
 	const struct lttng_kernel_ring_buffer_config *config = &chanb->config;
-	size_t sbidx, index, bytes_left_in_page;
 	struct lttng_kernel_ring_buffer_backend_pages *rpages;
-	unsigned long sb_bindex, id;
-
-	do {
-		sbidx = offset >> chanb->subbuf_size_order;
-		index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-
-		/*
-		 * Underlying layer should never ask for writes across
-		 * subbuffers.
-		 */
-		CHAN_WARN_ON(chanb, offset >= chanb->buf_size);
+	size_t index, bytes_left_in_page;
 
-		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
-		id = bufb->buf_wsb[sbidx].id;
-		sb_bindex = subbuffer_id_get_index(config, id);
-		rpages = bufb->array[sb_bindex];
-		CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
-			     && subbuffer_id_is_noref(config, id));
-		lib_ring_buffer_do_copy(config,
-					rpages->p[index].virt
-						+ (offset & ~PAGE_MASK),
+	rpages = lib_ring_buffer_write_get_pages(bufb, offset, len);
+	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
+	bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
+	lib_ring_buffer_do_copy(config,
+				rpages->p[index].virt + (offset & ~PAGE_MASK),
+				src, bytes_left_in_page);
+	len -= bytes_left_in_page;
+	src += bytes_left_in_page;
+	/* Following pages are written from their start. */
+	while (unlikely(len)) {
+		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE);
+		index++;
+		lib_ring_buffer_do_copy(config, rpages->p[index].virt,
 					src, bytes_left_in_page);
 		len -= bytes_left_in_page;
 		src += bytes_left_in_page;
-		offset += bytes_left_in_page;
-	} while (unlikely(len));
+	}
 }
 EXPORT_SYMBOL_GPL(_lib_ring_buffer_write);
 
@@ -613,33 +704,21 @@ void _lib_ring_buffer_memset(struct lttng_kernel_ring_buffer_backend *bufb,
 			     size_t offset, int c, size_t len)
 {
 	struct channel_backend *chanb = &bufb->chan->backend;
-	const struct lttng_kernel_ring_buffer_config *config = &chanb->config;
-	size_t sbidx, index, bytes_left_in_page;
 	struct lttng_kernel_ring_buffer_backend_pages *rpages;
-	unsigned long sb_bindex, id;
+	size_t index, bytes_left_in_page;
 
-	do {
-		sbidx = offset >> chanb->subbuf_size_order;
-		index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
-
-		/*
-		 * Underlying layer should never ask for writes across
-		 * subbuffers.
-		 */
-		CHAN_WARN_ON(chanb, offset >= chanb->buf_size);
-
-		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
-		id = bufb->buf_wsb[sbidx].id;
-		sb_bindex = subbuffer_id_get_index(config, id);
-		rpages = bufb->array[sb_bindex];
-		CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
-			     && subbuffer_id_is_noref(config, id));
-		lib_ring_buffer_do_memset(rpages->p[index].virt
-					  + (offset & ~PAGE_MASK),
-					  c, bytes_left_in_page);
+	rpages = lib_ring_buffer_write_get_pages(bufb, offset, len);
+	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
+	bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
+	memset(rpages->p[index].virt + (offset & ~PAGE_MASK),
+	       c, bytes_left_in_page);
+	len -= bytes_left_in_page;
+	/* Following pages are written from their start. */
+	while (unlikely(len)) {
+		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE);
+		memset(rpages->p[++index].virt, c, bytes_left_in_page);
 		len -= bytes_left_in_page;
-		offset += bytes_left_in_page;
-	} while (unlikely(len));
+	}
 }
 EXPORT_SYMBOL_GPL(_lib_ring_buffer_memset);
 
@@ -1044,6 +1123,16 @@ size_t lib_ring_buffer_read(struct lttng_kernel_ring_buffer_backend *bufb, size_
 	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
 	if (unlikely(!len))
 		return 0;
+	if (config->backend == RING_BUFFER_VMAP) {
+		id = bufb->buf_rsb.id;
+		sb_bindex = subbuffer_id_get_index(config, id);
+		rpages = bufb->array[sb_bindex];
+		CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
+			     && subbuffer_id_is_noref(config, id));
+		memcpy(dest, rpages->vmap + (offset & (chanb->subbuf_size - 1)),
+		       len);
+		return orig_len;
+	}
 	for (;;) {
 		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
 		id = bufb->buf_rsb.id;
@@ -1095,6 +1184,18 @@ int __lib_ring_buffer_copy_to_user(struct lttng_kernel_ring_buffer_backend *bufb
 	index = (offset & (chanb->subbuf_size - 1)) >> PAGE_SHIFT;
 	if (unlikely(!len))
 		return 0;
+	if (config->backend == RING_BUFFER_VMAP) {
+		id = bufb->buf_rsb.id;
+		sb_bindex = subbuffer_id_get_index(config, id);
+		rpages = bufb->array[sb_bindex];
+		CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
+			     && subbuffer_id_is_noref(config, id));
+		if (__copy_to_user(dest,
+			       rpages->vmap + (offset & (chanb->subbuf_size - 1)),
+			       len))
+			return -EFAULT;
+		return 0;
+	}
 	for (;;) {
 		bytes_left_in_page = min_t(size_t, len, PAGE_SIZE - (offset & ~PAGE_MASK));
 		id = bufb->buf_rsb.id;
@@ -1239,6 +1340,8 @@ void *lib_ring_buffer_read_offset_address(struct lttng_kernel_ring_buffer_backen
 	rpages = bufb->array[sb_bindex];
 	CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
 		     && subbuffer_id_is_noref(config, id));
+	if (config->backend == RING_BUFFER_VMAP)
+		return rpages->vmap + (offset & (chanb->subbuf_size - 1));
 	return rpages->p[index].virt + (offset & ~PAGE_MASK);
 }
 EXPORT_SYMBOL_GPL(lib_ring_buffer_read_offset_address);
@@ -1270,6 +1373,8 @@ void *lib_ring_buffer_offset_address(struct lttng_kernel_ring_buffer_backend *bu
 	rpages = bufb->array[sb_bindex];
 	CHAN_WARN_ON(chanb, config->mode == RING_BUFFER_OVERWRITE
 		     && subbuffer_id_is_noref(config, id));
+	if (config->backend == RING_BUFFER_VMAP)
+		return rpages->vmap + (offset & (chanb->subbuf_size - 1));
 	return rpages->p[index].virt + (offset & ~PAGE_MASK);
 }
 EXPORT_SYMBOL_GPL(lib_ring_buffer_offset_address);
@@ -222,6 +222,46 @@ static void lib_ring_buffer_pending_wakeup_chan(struct irq_work *entry)
 	wake_up_interruptible(&chan->read_wait);
 }
 
+static void lib_ring_buffer_pending_wakeup_ready_set(struct irq_work *entry)
+{
+	struct lttng_kernel_ring_buffer_channel *chan = container_of(entry, struct lttng_kernel_ring_buffer_channel, ready_wakeup_pending);
+	wake_up_interruptible(&chan->ready_wait);
+}
+
+/*
+ * Add @buf to the channel ready set. Returns true if ready set readers
+ * need to be woken up, which only happens for the first buffer added
+ * since the set was last fetched: wakeups are coalesced per channel
+ * rather than issued per buffer.
+ */
+static
+bool lib_ring_buffer_ready_set_add(struct lttng_kernel_ring_buffer_channel *chan,
+				   struct lttng_kernel_ring_buffer *buf)
+{
+	unsigned int cpu = max(buf->backend.cpu, 0);
+
+	/* Already reported, and not fetched yet. */
+	if (test_bit(cpu, chan->ready_set))
+		return false;
+	set_bit(cpu, chan->ready_set);
+	/*
+	 * Order the ready set update before the signaled flag load. Pairs
+	 * with the barrier in channel_ready_set_fetch().
+	 */
+	smp_mb__after_atomic();
+	if (test_bit(0, &chan->ready_signaled))
+		return false;
+	return !test_and_set_bit(0, &chan->ready_signaled);
+}
+
+static
+void lib_ring_buffer_ready_set_wakeup(struct lttng_kernel_ring_buffer_channel *chan,
+				      struct lttng_kernel_ring_buffer *buf)
+{
+	if (lib_ring_buffer_ready_set_add(chan, buf))
+		wake_up_interruptible(&chan->ready_wait);
+}
+
 /*
  * Must be called under cpu hotplug protection.
  */
@@ -283,6 +323,7 @@ int lib_ring_buffer_create(struct lttng_kernel_ring_buffer *buf,
 	}
 
 	init_waitqueue_head(&buf->read_wait);
+	mutex_init(&buf->read_mutex);
 	init_waitqueue_head(&buf->write_wait);
 	init_irq_work(&buf->wakeup_pending, lib_ring_buffer_pending_wakeup_buf);
 	raw_spin_lock_init(&buf->raw_tick_nohz_spinlock);
@@ -392,6 +433,53 @@ static void lib_ring_buffer_stop_switch_timer(struct lttng_kernel_ring_buffer *b
 	buf->switch_timer_enabled = 0;
 }
 
+/*
+ * The adaptive read timer backs off up to (read_timer_interval << MAX_SHIFT)
+ * on idle buffers, and speeds up down to (read_timer_interval >> MIN_SHIFT)
+ * on buffers filling up faster than they are consumed.
+ */
+#define READ_TIMER_ADAPTIVE_MAX_SHIFT	6
+#define READ_TIMER_ADAPTIVE_MIN_SHIFT	2
+
+/*
+ * Compute the next adaptive read timer interval from the number of
+ * sub-buffers delivered by writers since the last timer expiry, and from
+ * the number of sub-buffers waiting for the reader.
+ */
+static
+unsigned long lib_ring_buffer_read_timer_adapt(const struct lttng_kernel_ring_buffer_config *config,
+					       struct lttng_kernel_ring_buffer *buf,
+					       struct lttng_kernel_ring_buffer_channel *chan)
+{
+	unsigned long base = chan->read_timer_interval;
+	unsigned long interval = buf->read_timer_cur_interval;
+	unsigned long delivered, pending, count;
+
+	count = v_read(config, &buf->read_timer_delivered);
+	delivered = count - buf->read_timer_delivered_snapshot;
+	buf->read_timer_delivered_snapshot = count;
+	pending = (subbuf_trunc(v_read(config, &buf->offset), chan)
+		   - subbuf_trunc(atomic_long_read(&buf->consumed), chan))
+		  >> chan->backend.subbuf_size_order;
+
+	if (!delivered && !pending) {
+		/* Idle: back off. */
+		interval = min(interval << 1, base << READ_TIMER_ADAPTIVE_MAX_SHIFT);
+		WRITE_ONCE(buf->read_timer_idle, 1);
+	} else if (pending << 1 >= chan->backend.num_subbuf) {
+		/* At least half full: speed up. */
+		interval = max(interval >> 1,
+			       max(base >> READ_TIMER_ADAPTIVE_MIN_SHIFT, 1UL));
+	} else {
+		/* Active: return to the nominal interval. */
+		interval = min(interval << 1, base);
+	}
+	if (interval <= base)
+		WRITE_ONCE(buf->read_timer_idle, 0);
+	buf->read_timer_cur_interval = interval;
+	return interval;
+}
+
 /*
  * Polling timer to check the channels for data.
  */
@@ -400,6 +488,7 @@ static void read_buffer_timer(LTTNG_TIMER_FUNC_ARG_TYPE t)
 	struct lttng_kernel_ring_buffer *buf = lttng_from_timer(buf, t, read_timer);
 	struct lttng_kernel_ring_buffer_channel *chan = buf->backend.chan;
 	const struct lttng_kernel_ring_buffer_config *config = &chan->backend.config;
+	unsigned long interval = chan->read_timer_interval;
 
 	CHAN_WARN_ON(chan, !buf->backend.allocated);
 
@@ -407,14 +496,18 @@ static void read_buffer_timer(LTTNG_TIMER_FUNC_ARG_TYPE t)
 	    && lib_ring_buffer_poll_deliver(config, buf, chan)) {
 		wake_up_interruptible(&buf->read_wait);
 		wake_up_interruptible(&chan->read_wait);
+		lib_ring_buffer_ready_set_wakeup(chan, buf);
 	}
 
+	if (READ_ONCE(chan->read_timer_adaptive))
+		interval = lib_ring_buffer_read_timer_adapt(config, buf, chan);
+
 	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU)
 		lttng_mod_timer_pinned(&buf->read_timer,
-				 jiffies + chan->read_timer_interval);
+				 jiffies + interval);
 	else
 		mod_timer(&buf->read_timer,
-			  jiffies + chan->read_timer_interval);
+			  jiffies + interval);
 }
 
 /*
@@ -434,6 +527,9 @@ static void lib_ring_buffer_start_read_timer(struct lttng_kernel_ring_buffer *bu
 	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU)
 		flags = LTTNG_TIMER_PINNED;
 
+	buf->read_timer_delivered_snapshot = v_read(config, &buf->read_timer_delivered);
+	buf->read_timer_cur_interval = chan->read_timer_interval;
+	WRITE_ONCE(buf->read_timer_idle, 0);
 	lttng_timer_setup(&buf->read_timer, read_buffer_timer, flags, buf);
 	buf->read_timer.expires = jiffies + chan->read_timer_interval;
 
@@ -466,6 +562,7 @@ static void lib_ring_buffer_stop_read_timer(struct lttng_kernel_ring_buffer *buf
 	if (lib_ring_buffer_poll_deliver(config, buf, chan)) {
 		wake_up_interruptible(&buf->read_wait);
 		wake_up_interruptible(&chan->read_wait);
+		lib_ring_buffer_ready_set_wakeup(chan, buf);
 	}
 	buf->read_timer_enabled = 0;
 }
@@ -646,6 +743,7 @@ static int notrace ring_buffer_tick_nohz_callback(struct notifier_block *nb,
 			|| lib_ring_buffer_pending_data(config, buf, chan))) {
 			wake_up_interruptible(&buf->read_wait);
 			wake_up_interruptible(&chan->read_wait);
+			lib_ring_buffer_ready_set_wakeup(chan, buf);
 		}
 		if (chan->switch_timer_interval)
 			lib_ring_buffer_switch_slow(buf, SWITCH_ACTIVE);
@@ -818,6 +916,7 @@ static void channel_free(struct lttng_kernel_ring_buffer_channel *chan)
 	}
 	channel_iterator_free(chan);
 	channel_backend_free(&chan->backend);
+	kfree(chan->ready_set);
 	kfree(chan);
 }
 
@@ -856,8 +955,16 @@ struct lttng_kernel_ring_buffer_channel *channel_create(const struct lttng_kerne
 	if (!chan)
 		return NULL;
 
+	chan->ready_set = kcalloc(BITS_TO_LONGS(nr_cpu_ids),
+				  sizeof(unsigned long), GFP_KERNEL);
+	if (!chan->ready_set)
+		goto error;
+	init_waitqueue_head(&chan->ready_wait);
+	init_irq_work(&chan->ready_wakeup_pending,
+		      lib_ring_buffer_pending_wakeup_ready_set);
+
 	ret = channel_backend_init(&chan->backend, name, config, priv,
-				   subbuf_size, num_subbuf);
+				   buf_addr, subbuf_size, num_subbuf);
 	if (ret)
 		goto error;
 
@@ -952,6 +1059,7 @@ cpuhp_prepare_error:
 error_free_backend:
 	channel_backend_free(&chan->backend);
 error:
+	kfree(chan->ready_set);
 	kfree(chan);
 	return NULL;
 }
@@ -982,6 +1090,7 @@ void *channel_destroy(struct lttng_kernel_ring_buffer_channel *chan)
 	void *priv;
 
 	irq_work_sync(&chan->wakeup_pending);
+	irq_work_sync(&chan->ready_wakeup_pending);
 
 	channel_unregister_notifiers(chan);
 
@@ -1020,12 +1129,105 @@ void *channel_destroy(struct lttng_kernel_ring_buffer_channel *chan)
 	WRITE_ONCE(chan->finalized, 1);
 	wake_up_interruptible(&chan->hp_wait);
 	wake_up_interruptible(&chan->read_wait);
+	wake_up_interruptible(&chan->ready_wait);
 	priv = chan->backend.priv;
 	kref_put(&chan->ref, channel_release);
 	return priv;
 }
 EXPORT_SYMBOL_GPL(channel_destroy);
 
+/**
+ * channel_set_read_timer_adaptive - set the channel read timer mode
+ * @chan: channel
+ * @adaptive: scale the read timer interval with the buffer fill rate
+ *
+ * In adaptive mode, the read timer of each buffer backs off on idle
+ * buffers, down to one expiry every 64 read timer intervals, and expires
+ * up to 4 times more often on buffers at least half full. The first
+ * sub-buffer delivered into a backed off buffer wakes readers up
+ * immediately. Only meaningful for channels woken up by timer with a
+ * non-zero read timer interval.
+ */
+void channel_set_read_timer_adaptive(struct lttng_kernel_ring_buffer_channel *chan,
+				     int adaptive)
+{
+	WRITE_ONCE(chan->read_timer_adaptive, adaptive);
+}
+EXPORT_SYMBOL_GPL(channel_set_read_timer_adaptive);
+
+/**
+ * channel_ready_set_open - take a reference on the channel for a ready set reader
+ * @chan: channel
+ *
+ * Fetching the ready set clears it, so a channel has at most one ready
+ * set reader: returns -EBUSY if one is already open.
+ */
+int channel_ready_set_open(struct lttng_kernel_ring_buffer_channel *chan)
+{
+	if (test_and_set_bit(0, &chan->ready_set_opened))
+		return -EBUSY;
+	if (!lttng_kref_get(&chan->ref)) {
+		clear_bit(0, &chan->ready_set_opened);
+		return -EOVERFLOW;
+	}
+	return 0;
+}
+EXPORT_SYMBOL_GPL(channel_ready_set_open);
+
+/**
+ * channel_ready_set_release - release a ready set reader channel reference
+ * @chan: channel
+ */
+void channel_ready_set_release(struct lttng_kernel_ring_buffer_channel *chan)
+{
+	clear_bit(0, &chan->ready_set_opened);
+	kref_put(&chan->ref, channel_release);
+}
+EXPORT_SYMBOL_GPL(channel_ready_set_release);
+
+/**
+ * channel_ready_set_fetch - fetch and clear the channel ready set
+ * @chan: channel
+ * @ready: bitmap of nr_cpu_ids bits, indexed by cpu (output)
+ *
+ * The ready set holds the buffers which had sub-buffers to deliver since
+ * it was last fetched. Readers are expected to consume each reported
+ * buffer until it has no more sub-buffer available, since a buffer is
+ * only reported again when it has new data to deliver.
+ * Returns whether any buffer is set in @ready.
+ */
+bool channel_ready_set_fetch(struct lttng_kernel_ring_buffer_channel *chan,
+			     unsigned long *ready)
+{
+	bool found = false;
+	unsigned int i;
+
+	clear_bit(0, &chan->ready_signaled);
+	/*
+	 * Order the signaled flag clear before the ready set loads. Pairs
+	 * with the barrier in lib_ring_buffer_ready_set_add().
+	 */
+	smp_mb__after_atomic();
+	for (i = 0; i < BITS_TO_LONGS(nr_cpu_ids); i++) {
+		ready[i] = READ_ONCE(chan->ready_set[i]) ?
+			xchg(&chan->ready_set[i], 0) : 0;
+		if (ready[i])
+			found = true;
+	}
+	return found;
+}
+EXPORT_SYMBOL_GPL(channel_ready_set_fetch);
+
+/**
+ * channel_ready_set_empty - check whether the channel ready set is empty
+ * @chan: channel
+ */
+bool channel_ready_set_empty(struct lttng_kernel_ring_buffer_channel *chan)
+{
+	return bitmap_empty(chan->ready_set, nr_cpu_ids);
+}
+EXPORT_SYMBOL_GPL(channel_ready_set_empty);
+
 struct lttng_kernel_ring_buffer *channel_get_ring_buffer(
 					const struct lttng_kernel_ring_buffer_config *config,
 					struct lttng_kernel_ring_buffer_channel *chan, int cpu)
@@ -2410,8 +2612,28 @@ void lib_ring_buffer_check_deliver_slow(const struct lttng_kernel_ring_buffer_co
 		    && lib_ring_buffer_poll_deliver(config, buf, chan)) {
 			irq_work_queue(&buf->wakeup_pending);
 			irq_work_queue(&chan->wakeup_pending);
+			if (lib_ring_buffer_ready_set_add(chan, buf))
+				irq_work_queue(&chan->ready_wakeup_pending);
 		}
 
+		/*
+		 * The adaptive read timer counts delivered sub-buffers. The
+		 * first delivery into a buffer whose read timer backed off
+		 * wakes up readers right away rather than waiting for the
+		 * next, distant, timer expiry.
+		 */
+		if (config->wakeup == RING_BUFFER_WAKEUP_BY_TIMER
+		    && READ_ONCE(chan->read_timer_adaptive)) {
+			v_inc(config, &buf->read_timer_delivered);
+			if (READ_ONCE(buf->read_timer_idle)
+			    && atomic_long_read(&buf->active_readers)) {
+				WRITE_ONCE(buf->read_timer_idle, 0);
+				irq_work_queue(&buf->wakeup_pending);
+				irq_work_queue(&chan->wakeup_pending);
+				if (lib_ring_buffer_ready_set_add(chan, buf))
+					irq_work_queue(&chan->ready_wakeup_pending);
+			}
+		}
 	}
 }
 EXPORT_SYMBOL_GPL(lib_ring_buffer_check_deliver_slow);
@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: (GPL-2.0-only OR LGPL-2.1-only)
+ *
+ * ring_buffer_read.c
+ *
+ * Ring Buffer read() file operation, copying whole packets.
+ *
+ * Copyright (C) 2010-2012 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
+ */
+
+#include <linux/module.h>
+#include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+
+#include <ringbuffer/backend.h>
+#include <ringbuffer/frontend.h>
+#include <ringbuffer/vfs.h>
+#include <wrapper/uaccess.h>
+
+/*
+ * Get the next sub-buffer for reading, waiting for one to be available
+ * unless the file is non-blocking.
+ * Returns 0 on success, -ENODATA at end of stream, or a negative error.
+ */
+static
+int lib_ring_buffer_read_get_next_subbuf(struct file *filp,
+		struct lttng_kernel_ring_buffer *buf)
+{
+	int ret, error;
+
+	ret = lib_ring_buffer_get_next_subbuf(buf);
+	if (ret != -EAGAIN || (filp->f_flags & O_NONBLOCK))
+		return ret;
+	error = wait_event_interruptible(buf->read_wait,
+			((ret = lib_ring_buffer_get_next_subbuf(buf)), ret != -EAGAIN));
+	if (error)
+		return error;
+	return ret;
+}
+
+/**
+ * lib_ring_buffer_read_packets - copy whole packets to user-space
+ * @filp: file structure pointer
+ * @user_buf: user buffer to read data into
+ * @count: number of bytes to read
+ * @buf: ring buffer
+ *
+ * Copies as many complete sub-buffers, page-padded as reported by
+ * LTTNG_KERNEL_ABI_RING_BUFFER_GET_PADDED_SUBBUF_SIZE, as fit in @count,
+ * and consumes them. Packets are never split across calls: -EINVAL is
+ * returned if @count cannot hold the next packet, which is left in the
+ * buffer. Blocks until at least one packet is available, unless the
+ * file is non-blocking. Returns 0 at end of stream.
+ *
+ * readv() falls back on this operation for each iovec, so each iovec
+ * receives whole packets. Concurrent calls on the same buffer are
+ * serialized, each of them consuming distinct packets.
+ */
+ssize_t lib_ring_buffer_read_packets(struct file *filp, char __user *user_buf,
+		size_t count, struct lttng_kernel_ring_buffer *buf)
+{
+	struct lttng_kernel_ring_buffer_channel *chan = buf->backend.chan;
+	const struct lttng_kernel_ring_buffer_config *config = &chan->backend.config;
+	ssize_t read_count = 0;
+	int ret;
+
+	if (config->output != RING_BUFFER_READ)
+		return -EINVAL;
+	if (lib_ring_buffer_channel_is_disabled(chan))
+		return -EIO;
+	might_sleep();
+	if (!lttng_access_ok(VERIFY_WRITE, user_buf, count))
+		return -EFAULT;
+	/*
+	 * The consumed position snapshot and the sub-buffer held between
+	 * get_subbuf and put_subbuf belong to a single reader at a time.
+	 */
+	if (mutex_lock_interruptible(&buf->read_mutex))
+		return -ERESTARTSYS;
+
+	while (read_count < count) {
+		unsigned long size;
+
+		/* Only wait for the first packet. */
+		if (read_count)
+			ret = lib_ring_buffer_get_next_subbuf(buf);
+		else
+			ret = lib_ring_buffer_read_get_next_subbuf(filp, buf);
+		if (ret) {
+			/* A 0 read_count tells about end of stream. */
+			if (!read_count && ret != -ENODATA)
+				read_count = ret;
+			break;
+		}
+		size = PAGE_ALIGN(lib_ring_buffer_get_read_data_size(config, buf));
+		if (size > count - read_count) {
+			/* Leave the packet for the next read. */
+			lib_ring_buffer_put_subbuf(buf);
+			if (!read_count)
+				read_count = -EINVAL;
+			break;
+		}
+		if (__lib_ring_buffer_copy_to_user(&buf->backend,
+				buf->cons_snapshot, user_buf + read_count,
+				size)) {
+			lib_ring_buffer_put_subbuf(buf);
+			if (!read_count)
+				read_count = -EFAULT;
+			break;
+		}
+		lib_ring_buffer_put_next_subbuf(buf);
+		read_count += size;
+	}
+	mutex_unlock(&buf->read_mutex);
+	return read_count;
+}
+EXPORT_SYMBOL_GPL(lib_ring_buffer_read_packets);
+
+ssize_t vfs_lib_ring_buffer_read(struct file *filp, char __user *user_buf,
+		size_t count, loff_t *ppos)
+{
+	struct lttng_kernel_ring_buffer *buf = filp->private_data;
+
+	return lib_ring_buffer_read_packets(filp, user_buf, count, buf);
+}
+EXPORT_SYMBOL_GPL(vfs_lib_ring_buffer_read);
@@ -441,6 +441,7 @@ const struct file_operations lib_ring_buffer_file_operations = {
 	.open = vfs_lib_ring_buffer_open,
 	.release = vfs_lib_ring_buffer_release,
 	.poll = vfs_lib_ring_buffer_poll,
+	.read = vfs_lib_ring_buffer_read,
 	.splice_read = vfs_lib_ring_buffer_splice_read,
 	.mmap = vfs_lib_ring_buffer_mmap,
 	.unlocked_ioctl = vfs_lib_ring_buffer_ioctl,
@@ -31,6 +31,7 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/err.h>
+#include <linux/log2.h>
 #include <wrapper/vmalloc.h>	/* for wrapper_vmalloc_sync_mappings() */
 #include <ringbuffer/vfs.h>
 #include <ringbuffer/backend.h>
@@ -45,6 +46,7 @@
 #include <lttng/events-internal.h>
 #include <lttng/tracer.h>
 #include <lttng/tp-mempool.h>
+#include <counter/counter-types.h>
 #include <ringbuffer/frontend_types.h>
 #include <ringbuffer/iterator.h>
 
@@ -484,6 +486,36 @@ static const struct file_operations lttng_proc_ops = {
 };
 #endif
 
+static
+const char *lttng_abi_channel_transport_name(const struct lttng_kernel_abi_channel *chan_param)
+{
+	/* The read timer mode does not select the transport. */
+	uint32_t flags = chan_param->flags
+		& ~LTTNG_KERNEL_ABI_CHANNEL_FLAG_ADAPTIVE_READ_TIMER;
+	bool overwrite = chan_param->overwrite;
+
+	switch (chan_param->output) {
+	case LTTNG_KERNEL_ABI_SPLICE:
+		if (flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_STATIC)
+			return overwrite ? "relay-overwrite-static" : "relay-discard-static";
+		if (flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_VMAP)
+			return overwrite ? "relay-overwrite-vmap" : "relay-discard-vmap";
+		return overwrite ? "relay-overwrite" : "relay-discard";
+	case LTTNG_KERNEL_ABI_MMAP:
+		if (flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_STATIC)
+			return overwrite ? "relay-overwrite-mmap-static" : "relay-discard-mmap-static";
+		if (flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_VMAP)
+			return overwrite ? "relay-overwrite-mmap-vmap" : "relay-discard-mmap-vmap";
+		return overwrite ? "relay-overwrite-mmap" : "relay-discard-mmap";
+	case LTTNG_KERNEL_ABI_READ:
+		if (flags)
+			return NULL;
+		return overwrite ? "relay-overwrite-read" : "relay-discard-read";
+	default:
+		return NULL;
+	}
+}
+
 static
 int lttng_abi_create_channel(struct file *session_file,
 			     struct lttng_kernel_abi_channel *chan_param,
@@ -497,6 +529,16 @@ int lttng_abi_create_channel(struct file *session_file,
 	int chan_fd;
 	int ret = 0;
 
+	if (chan_param->flags & ~(LTTNG_KERNEL_ABI_CHANNEL_FLAG_VMAP
+			| LTTNG_KERNEL_ABI_CHANNEL_FLAG_STATIC
+			| LTTNG_KERNEL_ABI_CHANNEL_FLAG_ADAPTIVE_READ_TIMER))
+		return -EINVAL;
+	/* Backend flags are mutually exclusive. */
+	if ((chan_param->flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_VMAP)
+			&& (chan_param->flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_STATIC))
+		return -EINVAL;
+	if (channel_type == METADATA_CHANNEL && chan_param->flags)
+		return -EINVAL;
 	chan_fd = get_unused_fd_flags(0);
 	if (chan_fd < 0) {
 		ret = chan_fd;
@@ -520,15 +562,9 @@ int lttng_abi_create_channel(struct file *session_file,
 	}
 	switch (channel_type) {
 	case PER_CPU_CHANNEL:
-		if (chan_param->output == LTTNG_KERNEL_ABI_SPLICE) {
-			transport_name = chan_param->overwrite ?
-				"relay-overwrite" : "relay-discard";
-		} else if (chan_param->output == LTTNG_KERNEL_ABI_MMAP) {
-			transport_name = chan_param->overwrite ?
-				"relay-overwrite-mmap" : "relay-discard-mmap";
-		} else {
+		transport_name = lttng_abi_channel_transport_name(chan_param);
+		if (!transport_name)
 			return -EINVAL;
-		}
 		break;
 	case METADATA_CHANNEL:
 		if (chan_param->output == LTTNG_KERNEL_ABI_SPLICE)
@@ -560,6 +596,8 @@ int lttng_abi_create_channel(struct file *session_file,
 		ret = -EINVAL;
 		goto chan_error;
 	}
+	if (chan_param->flags & LTTNG_KERNEL_ABI_CHANNEL_FLAG_ADAPTIVE_READ_TIMER)
+		channel_set_read_timer_adaptive(chan->priv->rb_chan, 1);
 	chan->priv->parent.file = chan_file;
 	chan_file->private_data = chan;
 	fd_install(chan_fd, chan_file);
@@ -626,6 +664,149 @@ int lttng_counter_release(struct inode *inode, struct file *file)
 	return 0;
 }
 
+/* Number of counters converted and copied to user-space at once. */
+#define LTTNG_COUNTER_BULK_CHUNK	256
+
+static
+long lttng_counter_ioctl_bulk(struct lttng_counter *counter, unsigned int cmd,
+		struct lttng_kernel_abi_counter_bulk __user *ucounter_bulk)
+{
+	struct lttng_kernel_abi_counter_value __user *uvalues;
+	struct lttng_kernel_abi_counter_bulk local_counter_bulk;
+	struct lttng_kernel_abi_counter_value *chunk = NULL;
+	bool *overflow = NULL, *underflow = NULL;
+	int64_t *values = NULL;
+	uint64_t done;
+	long ret = 0;
+
+	if (copy_from_user(&local_counter_bulk, ucounter_bulk,
+				sizeof(local_counter_bulk)))
+		return -EFAULT;
+	if (validate_zeroed_padding(local_counter_bulk.padding,
+			sizeof(local_counter_bulk.padding)))
+		return -EINVAL;
+	if (local_counter_bulk.index > SIZE_MAX
+			|| local_counter_bulk.nr_elem > SIZE_MAX - local_counter_bulk.index)
+		return -EOVERFLOW;
+	if (local_counter_bulk.nr_elem > SIZE_MAX / sizeof(*uvalues))
+		return -EOVERFLOW;
+	uvalues = (struct lttng_kernel_abi_counter_value __user *)
+			(unsigned long) local_counter_bulk.values;
+	if (!lttng_access_ok(VERIFY_WRITE, uvalues,
+			local_counter_bulk.nr_elem * sizeof(*uvalues)))
+		return -EFAULT;
+
+	values = kmalloc_array(LTTNG_COUNTER_BULK_CHUNK, sizeof(*values), GFP_KERNEL);
+	overflow = kmalloc_array(LTTNG_COUNTER_BULK_CHUNK, sizeof(*overflow), GFP_KERNEL);
+	underflow = kmalloc_array(LTTNG_COUNTER_BULK_CHUNK, sizeof(*underflow), GFP_KERNEL);
+	chunk = kmalloc_array(LTTNG_COUNTER_BULK_CHUNK, sizeof(*chunk), GFP_KERNEL);
+	if (!values || !overflow || !underflow || !chunk) {
+		ret = -ENOMEM;
+		goto end;
+	}
+
+	for (done = 0; done < local_counter_bulk.nr_elem; done += LTTNG_COUNTER_BULK_CHUNK) {
+		size_t index = (size_t) (local_counter_bulk.index + done);
+		size_t nr_elem, i;
+
+		nr_elem = min_t(uint64_t, local_counter_bulk.nr_elem - done,
+				LTTNG_COUNTER_BULK_CHUNK);
+		switch (cmd) {
+		case LTTNG_KERNEL_ABI_COUNTER_READ_BULK:
+			ret = lttng_kernel_counter_read_range(counter, index, nr_elem,
+					local_counter_bulk.cpu, values, overflow, underflow);
+			break;
+		case LTTNG_KERNEL_ABI_COUNTER_AGGREGATE_BULK:
+			ret = lttng_kernel_counter_aggregate_range(counter, index, nr_elem,
+					values, overflow, underflow);
+			break;
+		case LTTNG_KERNEL_ABI_COUNTER_EXCHANGE_BULK:
+			/*
+			 * The exchanged counts are lost if they cannot be
+			 * copied out: fault in the destination before
+			 * resetting the counters.
+			 */
+			if (clear_user(uvalues + done, nr_elem * sizeof(*uvalues))) {
+				ret = -EFAULT;
+				break;
+			}
+			ret = lttng_kernel_counter_exchange_range(counter, index, nr_elem,
+					values, overflow, underflow);
+			break;
+		default:
+			ret = -EINVAL;
+		}
+		if (ret)
+			goto end;
+		for (i = 0; i < nr_elem; i++) {
+			chunk[i].value = values[i];
+			chunk[i].overflow = overflow[i];
+			chunk[i].underflow = underflow[i];
+		}
+		if (copy_to_user(uvalues + done, chunk, nr_elem * sizeof(*chunk))) {
+			ret = -EFAULT;
+			goto end;
+		}
+		cond_resched();
+	}
+end:
+	kfree(chunk);
+	kfree(underflow);
+	kfree(overflow);
+	kfree(values);
+	return ret;
+}
+
+static
+long lttng_counter_ioctl_read_keys(struct lttng_counter *counter,
+		struct lttng_kernel_abi_aggregation_map_read_keys __user *uread_keys)
+{
+	struct lttng_aggregation_map *aggregation_map = counter->aggregation_map;
+	struct lttng_kernel_abi_aggregation_map_key __user *ukeys;
+	struct lttng_kernel_abi_aggregation_map_read_keys local_read_keys;
+	struct lttng_kernel_abi_aggregation_map_key *chunk;
+	uint64_t done, dropped;
+	long ret = 0;
+
+	if (!aggregation_map)
+		return -EINVAL;
+	if (copy_from_user(&local_read_keys, uread_keys, sizeof(local_read_keys)))
+		return -EFAULT;
+	if (validate_zeroed_padding(local_read_keys.padding,
+			sizeof(local_read_keys.padding)))
+		return -EINVAL;
+	if (local_read_keys.index > aggregation_map->nr_slots
+			|| local_read_keys.nr_slots > aggregation_map->nr_slots - local_read_keys.index)
+		return -EINVAL;
+	ukeys = (struct lttng_kernel_abi_aggregation_map_key __user *)
+			(unsigned long) local_read_keys.keys;
+
+	chunk = kmalloc_array(LTTNG_COUNTER_BULK_CHUNK, sizeof(*chunk), GFP_KERNEL);
+	if (!chunk)
+		return -ENOMEM;
+
+	for (done = 0; done < local_read_keys.nr_slots; done += LTTNG_COUNTER_BULK_CHUNK) {
+		size_t index = (size_t) (local_read_keys.index + done);
+		size_t nr_slots, i;
+
+		nr_slots = min_t(uint64_t, local_read_keys.nr_slots - done,
+				LTTNG_COUNTER_BULK_CHUNK);
+		for (i = 0; i < nr_slots; i++)
+			lttng_aggregation_map_read_key(aggregation_map, index + i, &chunk[i]);
+		if (copy_to_user(ukeys + done, chunk, nr_slots * sizeof(*chunk))) {
+			ret = -EFAULT;
+			goto end;
+		}
+		cond_resched();
+	}
+	dropped = atomic_long_read(&aggregation_map->dropped);
+	if (copy_to_user(&uread_keys->dropped, &dropped, sizeof(dropped)))
+		ret = -EFAULT;
+end:
+	kfree(chunk);
+	return ret;
+}
+
 static
 long lttng_counter_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
@@ -729,14 +910,58 @@ long lttng_counter_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 
 		return lttng_kernel_counter_clear(counter, indexes);
 	}
+	case LTTNG_KERNEL_ABI_COUNTER_READ_BULK:
+		lttng_fallthrough;
+	case LTTNG_KERNEL_ABI_COUNTER_AGGREGATE_BULK:
+		lttng_fallthrough;
+	case LTTNG_KERNEL_ABI_COUNTER_EXCHANGE_BULK:
+		return lttng_counter_ioctl_bulk(counter, cmd,
+				(struct lttng_kernel_abi_counter_bulk __user *) arg);
+	case LTTNG_KERNEL_ABI_COUNTER_MAP_LAYOUT:
+	{
+		struct lttng_kernel_abi_counter_map_layout __user *umap_layout =
+				(struct lttng_kernel_abi_counter_map_layout __user *) arg;
+		struct lttng_kernel_abi_counter_map_layout local_map_layout;
+		struct lib_counter_map_layout map_layout;
+		int ret;
+
+		ret = lttng_kernel_counter_get_map_layout(counter, &map_layout);
+		if (ret)
+			return ret;
+		memset(&local_map_layout, 0, sizeof(local_map_layout));
+		local_map_layout.elem_size = map_layout.elem_size;
+		local_map_layout.nr_cpus = map_layout.nr_cpus;
+		local_map_layout.nr_elem = map_layout.nr_elem;
+		local_map_layout.array_len = map_layout.array_len;
+		local_map_layout.global = map_layout.global;
+		if (copy_to_user(umap_layout, &local_map_layout, sizeof(local_map_layout)))
+			return -EFAULT;
+		return 0;
+	}
+	case LTTNG_KERNEL_ABI_AGGREGATION_MAP_READ_KEYS:
+		return lttng_counter_ioctl_read_keys(counter,
+				(struct lttng_kernel_abi_aggregation_map_read_keys __user *) arg);
 	default:
 		return -ENOSYS;
 	}
 }
 
+/*
+ * The mapping holds a reference on the counter file, which holds a
+ * reference on its owner, keeping the counter alive while mapped.
+ */
+static
+int lttng_counter_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct lttng_counter *counter = file->private_data;
+
+	return lttng_kernel_counter_map(counter, vma);
+}
+
 static const struct file_operations lttng_counter_fops = {
 	.owner = THIS_MODULE,
 	.release = lttng_counter_release,
+	.mmap = lttng_counter_mmap,
 	.unlocked_ioctl = lttng_counter_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = lttng_counter_ioctl,
@@ -843,6 +1068,7 @@ long lttng_session_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		chan_param.switch_timer_interval = old_chan_param.switch_timer_interval;
 		chan_param.read_timer_interval = old_chan_param.read_timer_interval;
 		chan_param.output = old_chan_param.output;
+		chan_param.flags = 0;
 
 		return lttng_abi_create_channel(file, &chan_param,
 				PER_CPU_CHANNEL);
@@ -878,6 +1104,7 @@ long lttng_session_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		chan_param.switch_timer_interval = old_chan_param.switch_timer_interval;
 		chan_param.read_timer_interval = old_chan_param.read_timer_interval;
 		chan_param.output = old_chan_param.output;
+		chan_param.flags = 0;
 
 		return lttng_abi_create_channel(file, &chan_param,
 				METADATA_CHANNEL);
@@ -1659,6 +1886,172 @@ fd_error:
 	return ret;
 }
 
+struct lttng_channel_ready_set {
+	struct lttng_kernel_ring_buffer_channel *chan;
+	struct mutex lock;		/* Serializes readers of the fetched ready set */
+	unsigned long *ready;		/* Fetched ready set, by cpu */
+};
+
+static
+ssize_t lttng_channel_ready_set_read(struct file *filp, char __user *user_buf,
+		size_t count, loff_t *ppos)
+{
+	struct lttng_channel_ready_set *ready_set = filp->private_data;
+	struct lttng_kernel_ring_buffer_channel *chan = ready_set->chan;
+	size_t len = DIV_ROUND_UP(nr_cpu_ids, 64) * sizeof(uint64_t);
+	unsigned int i;
+	ssize_t ret;
+
+	if (count < len)
+		return -EINVAL;
+	if (lib_ring_buffer_channel_is_disabled(chan))
+		return -EIO;
+	/* The fetched buffers are cleared from the set: do not lose them. */
+	if (!lttng_access_ok(VERIFY_WRITE, user_buf, len))
+		return -EFAULT;
+	/*
+	 * Concurrent readers share the fetched ready set: each fetch and
+	 * copy to user-space is done under the lock, so each buffer is
+	 * reported to a single reader.
+	 */
+	if (mutex_lock_interruptible(&ready_set->lock))
+		return -ERESTARTSYS;
+	while (!channel_ready_set_fetch(chan, ready_set->ready)) {
+		int error;
+
+		if (lib_ring_buffer_channel_is_finalized(chan)) {
+			ret = 0;	/* End of stream. */
+			goto end;
+		}
+		if (filp->f_flags & O_NONBLOCK) {
+			ret = -EAGAIN;
+			goto end;
+		}
+		mutex_unlock(&ready_set->lock);
+		error = wait_event_interruptible(chan->ready_wait,
+				!channel_ready_set_empty(chan)
+				|| lib_ring_buffer_channel_is_finalized(chan));
+		if (error)
+			return error;
+		if (mutex_lock_interruptible(&ready_set->lock))
+			return -ERESTARTSYS;
+	}
+	for (i = 0; i < len / sizeof(uint64_t); i++) {
+		uint64_t word;
+
+#if BITS_PER_LONG == 64
+		word = ready_set->ready[i];
+#else
+		word = ready_set->ready[2 * i];
+		if (2 * i + 1 < BITS_TO_LONGS(nr_cpu_ids))
+			word |= (uint64_t) ready_set->ready[2 * i + 1] << 32;
+#endif
+		if (put_user(word, (uint64_t __user *) user_buf + i)) {
+			ret = -EFAULT;
+			goto end;
+		}
+	}
+	ret = len;
+end:
+	mutex_unlock(&ready_set->lock);
+	return ret;
+}
+
+static
+unsigned int lttng_channel_ready_set_poll(struct file *filp, poll_table *wait)
+{
+	struct lttng_channel_ready_set *ready_set = filp->private_data;
+	struct lttng_kernel_ring_buffer_channel *chan = ready_set->chan;
+
+	poll_wait(filp, &chan->ready_wait, wait);
+
+	if (lib_ring_buffer_channel_is_disabled(chan))
+		return POLLERR;
+	if (!channel_ready_set_empty(chan))
+		return POLLIN | POLLRDNORM;
+	if (lib_ring_buffer_channel_is_finalized(chan))
+		return POLLHUP;
+	return 0;
+}
+
+static
+int lttng_channel_ready_set_release(struct inode *inode, struct file *filp)
+{
+	struct lttng_channel_ready_set *ready_set = filp->private_data;
+
+	channel_ready_set_release(ready_set->chan);
+	kfree(ready_set->ready);
+	kfree(ready_set);
+	return 0;
+}
+
+static const struct file_operations lttng_channel_ready_set_fops = {
+	.owner = THIS_MODULE,
+	.release = lttng_channel_ready_set_release,
+	.read = lttng_channel_ready_set_read,
+	.poll = lttng_channel_ready_set_poll,
+	.llseek = noop_llseek,
+};
+
+/*
+ * The ready set file descriptor lets a consumer wait on a whole channel
+ * instead of polling each of its streams. Each read() returns a bitmap,
+ * made of 64-bit words indexed by cpu, of the streams which have
+ * sub-buffers to deliver. A stream is only reported again once it has
+ * new data, so the consumer must drain each reported stream until
+ * -EAGAIN. A channel has at most one ready set file descriptor open at
+ * a time: opening another one fails with -EBUSY.
+ */
+static
+int lttng_abi_open_channel_ready_set(struct file *channel_file)
+{
+	struct lttng_kernel_channel_buffer *channel = channel_file->private_data;
+	struct lttng_channel_ready_set *ready_set;
+	struct file *ready_set_file;
+	int ready_set_fd, ret;
+
+	ready_set = kzalloc(sizeof(*ready_set), GFP_KERNEL);
+	if (!ready_set) {
+		ret = -ENOMEM;
+		goto alloc_error;
+	}
+	ready_set->ready = kcalloc(BITS_TO_LONGS(nr_cpu_ids),
+			sizeof(unsigned long), GFP_KERNEL);
+	if (!ready_set->ready) {
+		ret = -ENOMEM;
+		goto alloc_ready_error;
+	}
+	mutex_init(&ready_set->lock);
+	ready_set->chan = channel->priv->rb_chan;
+	ret = channel_ready_set_open(ready_set->chan);
+	if (ret)
+		goto ref_error;
+	ready_set_fd = get_unused_fd_flags(0);
+	if (ready_set_fd < 0) {
+		ret = ready_set_fd;
+		goto fd_error;
+	}
+	ready_set_file = anon_inode_getfile("[lttng_channel_ready_set]",
+			&lttng_channel_ready_set_fops, ready_set, O_RDONLY);
+	if (IS_ERR(ready_set_file)) {
+		ret = PTR_ERR(ready_set_file);
+		goto file_error;
+	}
+	fd_install(ready_set_fd, ready_set_file);
+	return ready_set_fd;
+
+file_error:
+	put_unused_fd(ready_set_fd);
+fd_error:
+	channel_ready_set_release(ready_set->chan);
+ref_error:
+	kfree(ready_set->ready);
+alloc_ready_error:
+	kfree(ready_set);
+alloc_error:
+	return ret;
+}
+
 static
 int lttng_abi_open_metadata_stream(struct file *channel_file)
 {
@@ -1776,14 +2169,22 @@ int lttng_abi_validate_event_param(struct lttng_kernel_abi_event *event_param)
 		default:
 			return -EINVAL;
 		}
-		switch (event_param->u.syscall.abi) {
-		case LTTNG_KERNEL_ABI_SYSCALL_ABI_ALL:
-			break;
-		default:
-			return -EINVAL;
-		}
 		switch (event_param->u.syscall.match) {
 		case LTTNG_KERNEL_ABI_SYSCALL_MATCH_NAME:
+			if (event_param->u.syscall.abi != LTTNG_KERNEL_ABI_SYSCALL_ABI_ALL)
+				return -EINVAL;
+			break;
+		case LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR:
+			switch (event_param->u.syscall.abi) {
+			case LTTNG_KERNEL_ABI_SYSCALL_ABI_ALL:
+				lttng_fallthrough;
+			case LTTNG_KERNEL_ABI_SYSCALL_ABI_NATIVE:
+				lttng_fallthrough;
+			case LTTNG_KERNEL_ABI_SYSCALL_ABI_COMPAT:
+				break;
+			default:
+				return -EINVAL;
+			}
 			break;
 		default:
 			return -EINVAL;
@@ -1964,6 +2365,72 @@ fd_error:
 	return ret;
 }
 
+static
+long lttng_abi_event_filter_stats(struct lttng_kernel_event_common *event,
+		struct lttng_kernel_abi_event_filter_stats __user *ustats)
+{
+	struct lttng_kernel_abi_event_filter_stats stats;
+
+	lttng_event_filter_stats(event, &stats);
+	if (copy_to_user(ustats, &stats, sizeof(stats)))
+		return -EFAULT;
+	return 0;
+}
+
+static
+long lttng_abi_event_enabler_filter_stats(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_abi_event_filter_stats __user *ustats)
+{
+	struct lttng_kernel_abi_event_filter_stats stats;
+	int ret;
+
+	ret = lttng_event_enabler_filter_stats(event_enabler, &stats);
+	if (ret)
+		return ret;
+	if (copy_to_user(ustats, &stats, sizeof(stats)))
+		return -EFAULT;
+	return 0;
+}
+
+static
+long lttng_abi_event_notifier_enabler_aggregate(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_kernel_abi_aggregate __user *uaggregate)
+{
+	struct lttng_kernel_abi_aggregate aggregate;
+	struct lttng_counter *counter;
+	struct file *counter_file;
+	int ret;
+
+	if (copy_from_user(&aggregate, uaggregate, sizeof(aggregate)))
+		return -EFAULT;
+	if (validate_zeroed_padding(aggregate.padding, sizeof(aggregate.padding)))
+		return -EINVAL;
+	counter_file = fget(aggregate.counter_fd);
+	if (!counter_file)
+		return -EBADF;
+	if (counter_file->f_op != &lttng_counter_fops) {
+		ret = -EINVAL;
+		goto end;
+	}
+	/*
+	 * The map or histogram lives as long as its event notifier group,
+	 * which the enabler holds a reference on.
+	 */
+	counter = counter_file->private_data;
+	if (counter->aggregation_map)
+		ret = lttng_event_notifier_enabler_attach_aggregation_map(event_notifier_enabler,
+				counter->aggregation_map);
+	else if (counter->histogram)
+		ret = lttng_event_notifier_enabler_attach_histogram(event_notifier_enabler,
+				counter->histogram);
+	else
+		ret = -EINVAL;
+end:
+	fput(counter_file);
+	return ret;
+}
+
 static
 long lttng_event_notifier_event_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
@@ -1978,9 +2445,14 @@ long lttng_event_notifier_event_ioctl(struct file *file, unsigned int cmd, unsig
 		return -EINVAL;
 	case LTTNG_KERNEL_ABI_CAPTURE:
 		return -EINVAL;
+	case LTTNG_KERNEL_ABI_AGGREGATE:
+		return -EINVAL;
 	case LTTNG_KERNEL_ABI_ADD_CALLSITE:
 		return lttng_event_add_callsite(&event_notifier->parent,
 			(struct lttng_kernel_abi_event_callsite __user *) arg);
+	case LTTNG_KERNEL_ABI_EVENT_FILTER_STATS:
+		return lttng_abi_event_filter_stats(&event_notifier->parent,
+			(struct lttng_kernel_abi_event_filter_stats __user *) arg);
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2003,8 +2475,14 @@ long lttng_event_notifier_enabler_ioctl(struct file *file, unsigned int cmd, uns
 		return lttng_event_notifier_enabler_attach_capture_bytecode(
 			event_notifier_enabler,
 			(struct lttng_kernel_abi_capture_bytecode __user *) arg);
+	case LTTNG_KERNEL_ABI_AGGREGATE:
+		return lttng_abi_event_notifier_enabler_aggregate(event_notifier_enabler,
+			(struct lttng_kernel_abi_aggregate __user *) arg);
 	case LTTNG_KERNEL_ABI_ADD_CALLSITE:
 		return -EINVAL;
+	case LTTNG_KERNEL_ABI_EVENT_FILTER_STATS:
+		return lttng_abi_event_enabler_filter_stats(&event_notifier_enabler->parent,
+			(struct lttng_kernel_abi_event_filter_stats __user *) arg);
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2202,37 +2680,59 @@ inval_instr:
 	return ret;
 }
 
+static
+const char *lttng_abi_get_counter_transport_name(uint32_t arithmetic, uint32_t bitness)
+{
+	switch (arithmetic) {
+	case LTTNG_KERNEL_ABI_COUNTER_ARITHMETIC_MODULAR:
+		switch (bitness) {
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_64:
+			return "counter-per-cpu-64-modular";
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_32:
+			return "counter-per-cpu-32-modular";
+		default:
+			return NULL;
+		}
+	case LTTNG_KERNEL_ABI_COUNTER_ARITHMETIC_SATURATE:
+		switch (bitness) {
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_64:
+			return "counter-per-cpu-64-saturate";
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_32:
+			return "counter-per-cpu-32-saturate";
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_16:
+			return "counter-per-cpu-16-saturate";
+		case LTTNG_KERNEL_ABI_COUNTER_BITNESS_8:
+			return "counter-per-cpu-8-saturate";
+		default:
+			return NULL;
+		}
+	default:
+		return NULL;
+	}
+}
+
 static
 long lttng_abi_event_notifier_group_create_error_counter(
 		struct file *event_notifier_group_file,
 		const struct lttng_kernel_abi_counter_conf *error_counter_conf)
 {
 	int counter_fd, ret;
-	char *counter_transport_name;
+	const char *counter_transport_name;
 	size_t counter_len;
 	struct lttng_counter *counter = NULL;
 	struct file *counter_file;
 	struct lttng_event_notifier_group *event_notifier_group =
 			(struct lttng_event_notifier_group *) event_notifier_group_file->private_data;
 
-	if (error_counter_conf->arithmetic != LTTNG_KERNEL_ABI_COUNTER_ARITHMETIC_MODULAR) {
-		printk(KERN_ERR "LTTng: event_notifier: Error counter of the wrong arithmetic type.\n");
-		return -EINVAL;
-	}
-
 	if (error_counter_conf->number_dimensions != 1) {
 		printk(KERN_ERR "LTTng: event_notifier: Error counter has more than one dimension.\n");
 		return -EINVAL;
 	}
 
-	switch (error_counter_conf->bitness) {
-	case LTTNG_KERNEL_ABI_COUNTER_BITNESS_64:
-		counter_transport_name = "counter-per-cpu-64-modular";
-		break;
-	case LTTNG_KERNEL_ABI_COUNTER_BITNESS_32:
-		counter_transport_name = "counter-per-cpu-32-modular";
-		break;
-	default:
+	counter_transport_name = lttng_abi_get_counter_transport_name(error_counter_conf->arithmetic,
+			error_counter_conf->bitness);
+	if (!counter_transport_name) {
+		printk(KERN_ERR "LTTng: event_notifier: Error counter of the wrong arithmetic type or bitness.\n");
 		return -EINVAL;
 	}
 
@@ -2307,6 +2807,179 @@ fd_error:
 	return ret;
 }
 
+static
+long lttng_abi_event_notifier_group_create_aggregation_map(
+		struct file *event_notifier_group_file,
+		const struct lttng_kernel_abi_aggregation_map_conf *aggregation_map_conf)
+{
+	int counter_fd, ret;
+	const char *counter_transport_name;
+	struct lttng_aggregation_map *aggregation_map;
+	struct file *counter_file;
+	struct lttng_event_notifier_group *event_notifier_group =
+			(struct lttng_event_notifier_group *) event_notifier_group_file->private_data;
+
+	if (validate_zeroed_padding(aggregation_map_conf->padding,
+			sizeof(aggregation_map_conf->padding)))
+		return -EINVAL;
+	if (aggregation_map_conf->nr_slots > SIZE_MAX
+			|| !is_power_of_2((size_t) aggregation_map_conf->nr_slots))
+		return -EINVAL;
+	counter_transport_name = lttng_abi_get_counter_transport_name(aggregation_map_conf->arithmetic,
+			aggregation_map_conf->bitness);
+	if (!counter_transport_name)
+		return -EINVAL;
+
+	/*
+	 * Lock sessions to provide mutual exclusion against concurrent
+	 * modification of the event_notifier group list of maps.
+	 */
+	lttng_lock_sessions();
+
+	counter_fd = get_unused_fd_flags(0);
+	if (counter_fd < 0) {
+		ret = counter_fd;
+		goto fd_error;
+	}
+
+	counter_file = anon_inode_getfile("[lttng_counter]",
+				       &lttng_counter_fops,
+				       NULL, O_RDONLY);
+	if (IS_ERR(counter_file)) {
+		ret = PTR_ERR(counter_file);
+		goto file_error;
+	}
+
+	if (!atomic_long_add_unless(&event_notifier_group_file->f_count, 1, LONG_MAX)) {
+		ret = -EOVERFLOW;
+		goto refcount_error;
+	}
+
+	aggregation_map = lttng_aggregation_map_create(event_notifier_group,
+			counter_transport_name, (size_t) aggregation_map_conf->nr_slots);
+	if (!aggregation_map) {
+		ret = -EINVAL;
+		goto map_error;
+	}
+
+	aggregation_map->counter->file = counter_file;
+	aggregation_map->counter->owner = event_notifier_group->file;
+	counter_file->private_data = aggregation_map->counter;
+
+	fd_install(counter_fd, counter_file);
+	lttng_unlock_sessions();
+
+	return counter_fd;
+
+map_error:
+	atomic_long_dec(&event_notifier_group_file->f_count);
+refcount_error:
+	fput(counter_file);
+file_error:
+	put_unused_fd(counter_fd);
+fd_error:
+	lttng_unlock_sessions();
+	return ret;
+}
+
+static
+int lttng_abi_validate_histogram_conf(const struct lttng_kernel_abi_histogram_conf *histogram_conf)
+{
+	if (validate_zeroed_padding(histogram_conf->padding,
+			sizeof(histogram_conf->padding)))
+		return -EINVAL;
+	if (!histogram_conf->nr_buckets)
+		return -EINVAL;
+	switch (histogram_conf->type) {
+	case LTTNG_KERNEL_ABI_HISTOGRAM_LOG2:
+		/* Bucket 0 and one bucket per bit. */
+		if (histogram_conf->nr_buckets > 65)
+			return -EINVAL;
+		if (histogram_conf->min || histogram_conf->width)
+			return -EINVAL;
+		break;
+	case LTTNG_KERNEL_ABI_HISTOGRAM_LINEAR:
+		if (!histogram_conf->width)
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static
+long lttng_abi_event_notifier_group_create_histogram(
+		struct file *event_notifier_group_file,
+		const struct lttng_kernel_abi_histogram_conf *histogram_conf)
+{
+	int counter_fd, ret;
+	const char *counter_transport_name;
+	struct lttng_histogram *histogram;
+	struct file *counter_file;
+	struct lttng_event_notifier_group *event_notifier_group =
+			(struct lttng_event_notifier_group *) event_notifier_group_file->private_data;
+
+	ret = lttng_abi_validate_histogram_conf(histogram_conf);
+	if (ret)
+		return ret;
+	counter_transport_name = lttng_abi_get_counter_transport_name(histogram_conf->arithmetic,
+			histogram_conf->bitness);
+	if (!counter_transport_name)
+		return -EINVAL;
+
+	/*
+	 * Lock sessions to provide mutual exclusion against concurrent
+	 * modification of the event_notifier group list of histograms.
+	 */
+	lttng_lock_sessions();
+
+	counter_fd = get_unused_fd_flags(0);
+	if (counter_fd < 0) {
+		ret = counter_fd;
+		goto fd_error;
+	}
+
+	counter_file = anon_inode_getfile("[lttng_counter]",
+				       &lttng_counter_fops,
+				       NULL, O_RDONLY);
+	if (IS_ERR(counter_file)) {
+		ret = PTR_ERR(counter_file);
+		goto file_error;
+	}
+
+	if (!atomic_long_add_unless(&event_notifier_group_file->f_count, 1, LONG_MAX)) {
+		ret = -EOVERFLOW;
+		goto refcount_error;
+	}
+
+	histogram = lttng_histogram_create(event_notifier_group,
+			counter_transport_name, histogram_conf);
+	if (!histogram) {
+		ret = -EINVAL;
+		goto histogram_error;
+	}
+
+	histogram->counter->file = counter_file;
+	histogram->counter->owner = event_notifier_group->file;
+	counter_file->private_data = histogram->counter;
+
+	fd_install(counter_fd, counter_file);
+	lttng_unlock_sessions();
+
+	return counter_fd;
+
+histogram_error:
+	atomic_long_dec(&event_notifier_group_file->f_count);
+refcount_error:
+	fput(counter_file);
+file_error:
+	put_unused_fd(counter_fd);
+fd_error:
+	lttng_unlock_sessions();
+	return ret;
+}
+
 static
 long lttng_event_notifier_group_ioctl(struct file *file, unsigned int cmd,
 		unsigned long arg)
@@ -2337,6 +3010,28 @@ long lttng_event_notifier_group_ioctl(struct file *file, unsigned int cmd,
 		return lttng_abi_event_notifier_group_create_error_counter(file,
 				&uerror_counter_conf);
 	}
+	case LTTNG_KERNEL_ABI_AGGREGATION_MAP:
+	{
+		struct lttng_kernel_abi_aggregation_map_conf uaggregation_map_conf;
+
+		if (copy_from_user(&uaggregation_map_conf,
+				(struct lttng_kernel_abi_aggregation_map_conf __user *) arg,
+				sizeof(uaggregation_map_conf)))
+			return -EFAULT;
+		return lttng_abi_event_notifier_group_create_aggregation_map(file,
+				&uaggregation_map_conf);
+	}
+	case LTTNG_KERNEL_ABI_HISTOGRAM:
+	{
+		struct lttng_kernel_abi_histogram_conf uhistogram_conf;
+
+		if (copy_from_user(&uhistogram_conf,
+				(struct lttng_kernel_abi_histogram_conf __user *) arg,
+				sizeof(uhistogram_conf)))
+			return -EFAULT;
+		return lttng_abi_event_notifier_group_create_histogram(file,
+				&uhistogram_conf);
+	}
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2382,6 +3077,9 @@ static const struct file_operations lttng_event_notifier_group_fops = {
  *		Enable recording for events in this channel (weak enable)
  *	LTTNG_KERNEL_ABI_DISABLE
  *		Disable recording for events in this channel (strong disable)
+ *	LTTNG_KERNEL_ABI_CHANNEL_READY_SET
+ *		Returns a file descriptor reporting which streams of the
+ *		channel have sub-buffers to deliver, or failure.
  *
  * Channel and event file descriptors also hold a reference on the session.
  */
@@ -2541,6 +3239,8 @@ old_ctx_end:
 	case LTTNG_KERNEL_ABI_SYSCALL_MASK:
 		return lttng_syscall_table_get_active_mask(&channel->priv->parent.syscall_table,
 			(struct lttng_kernel_abi_syscall_mask __user *) arg);
+	case LTTNG_KERNEL_ABI_CHANNEL_READY_SET:
+		return lttng_abi_open_channel_ready_set(file);
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2656,6 +3356,8 @@ static const struct file_operations lttng_metadata_fops = {
  *		Enable recording for this event (weak enable)
  *	LTTNG_KERNEL_ABI_DISABLE
  *		Disable recording for this event (strong disable)
+ *	LTTNG_KERNEL_ABI_EVENT_FILTER_STATS
+ *		Get the filter evaluation statistics of this event
  */
 static
 long lttng_event_recorder_event_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
@@ -2684,6 +3386,9 @@ long lttng_event_recorder_event_ioctl(struct file *file, unsigned int cmd, unsig
 	case LTTNG_KERNEL_ABI_ADD_CALLSITE:
 		return lttng_event_add_callsite(&event_recorder->parent,
 			(struct lttng_kernel_abi_event_callsite __user *) arg);
+	case LTTNG_KERNEL_ABI_EVENT_FILTER_STATS:
+		return lttng_abi_event_filter_stats(&event_recorder->parent,
+			(struct lttng_kernel_abi_event_filter_stats __user *) arg);
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2703,6 +3408,9 @@ long lttng_event_recorder_event_ioctl(struct file *file, unsigned int cmd, unsig
  *		Enable recording for this event (weak enable)
  *	LTTNG_KERNEL_ABI_DISABLE
  *		Disable recording for this event (strong disable)
+ *	LTTNG_KERNEL_ABI_EVENT_FILTER_STATS
+ *		Get the filter evaluation statistics summed over the events
+ *		matched by this enabler
  */
 static
 long lttng_event_recorder_enabler_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
@@ -2731,6 +3439,9 @@ long lttng_event_recorder_enabler_ioctl(struct file *file, unsigned int cmd, uns
 			(struct lttng_kernel_abi_filter_bytecode __user *) arg);
 	case LTTNG_KERNEL_ABI_ADD_CALLSITE:
 		return -EINVAL;
+	case LTTNG_KERNEL_ABI_EVENT_FILTER_STATS:
+		return lttng_abi_event_enabler_filter_stats(&event_enabler->parent,
+			(struct lttng_kernel_abi_event_filter_stats __user *) arg);
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -2784,6 +3495,77 @@ static int put_u32(uint32_t val, unsigned long arg)
 	return put_user(val, (uint32_t __user *) arg);
 }
 
+/*
+ * Get the next sub-buffer and fill its descriptor in a single call,
+ * optionally consuming the sub-buffer held from the previous call first.
+ */
+static long lttng_stream_ring_buffer_get_next_packet(struct file *filp,
+		struct lttng_kernel_ring_buffer *buf, unsigned long arg)
+{
+	struct lttng_kernel_abi_ring_buffer_packet __user *upacket =
+		(struct lttng_kernel_abi_ring_buffer_packet __user *) arg;
+	struct lttng_kernel_ring_buffer_channel *chan = buf->backend.chan;
+	const struct lttng_kernel_ring_buffer_config *config = &chan->backend.config;
+	const struct lttng_kernel_channel_buffer_ops *ops = chan->backend.priv_ops;
+	struct lttng_kernel_abi_ring_buffer_packet packet;
+	uint64_t ts_begin, ts_end, ed, cs, ps, seq;
+	uint32_t flags;
+	int ret;
+
+	if (get_user(flags, &upacket->flags))
+		return -EFAULT;
+	if (flags & ~LTTNG_KERNEL_ABI_RING_BUFFER_PACKET_FLAG_PUT_PREVIOUS)
+		return -EINVAL;
+	if (flags & LTTNG_KERNEL_ABI_RING_BUFFER_PACKET_FLAG_PUT_PREVIOUS) {
+		if (!buf->get_subbuf)
+			return -EINVAL;
+		lib_ring_buffer_put_next_subbuf(buf);
+	}
+	ret = lib_ring_buffer_get_next_subbuf(buf);
+	if (ret)
+		return ret;
+	/* Set file position to zero at each successful "get" */
+	filp->f_pos = 0;
+
+	memset(&packet, 0, sizeof(packet));
+	packet.flags = flags;
+	packet.subbuf_size = lib_ring_buffer_get_read_data_size(config, buf);
+	packet.padded_subbuf_size = PAGE_ALIGN(packet.subbuf_size);
+	if (config->output == RING_BUFFER_MMAP) {
+		unsigned long sb_bindex;
+
+		sb_bindex = subbuffer_id_get_index(config,
+						   buf->backend.buf_rsb.id);
+		packet.mmap_read_offset =
+			buf->backend.array[sb_bindex]->mmap_offset;
+	}
+	if (ops->priv->timestamp_begin(config, buf, &ts_begin) < 0
+			|| ops->priv->timestamp_end(config, buf, &ts_end) < 0
+			|| ops->priv->events_discarded(config, buf, &ed) < 0
+			|| ops->priv->content_size(config, buf, &cs) < 0
+			|| ops->priv->packet_size(config, buf, &ps) < 0
+			|| ops->priv->sequence_number(config, buf, &seq) < 0) {
+		ret = -ENOSYS;
+		goto error;
+	}
+	packet.timestamp_begin = ts_begin;
+	packet.timestamp_end = ts_end;
+	packet.events_discarded = ed;
+	packet.content_size = cs;
+	packet.packet_size = ps;
+	packet.seq_num = seq;
+	if (copy_to_user(upacket, &packet, sizeof(packet))) {
+		ret = -EFAULT;
+		goto error;
+	}
+	return 0;
+
+error:
+	/* Leave the packet in the buffer. */
+	lib_ring_buffer_put_subbuf(buf);
+	return ret;
+}
+
 static long lttng_stream_ring_buffer_ioctl(struct file *filp,
 		unsigned int cmd, unsigned long arg)
 {
@@ -2878,6 +3660,8 @@ static long lttng_stream_ring_buffer_ioctl(struct file *filp,
 			goto error;
 		return put_u64(id, arg);
 	}
+	case LTTNG_KERNEL_ABI_RING_BUFFER_GET_NEXT_PACKET:
+		return lttng_stream_ring_buffer_get_next_packet(filp, buf, arg);
 	default:
 		return lib_ring_buffer_file_operations.unlocked_ioctl(filp,
 				cmd, arg);
@@ -2982,6 +3766,8 @@ static long lttng_stream_ring_buffer_compat_ioctl(struct file *filp,
 			goto error;
 		return put_u64(id, arg);
 	}
+	case LTTNG_KERNEL_ABI_RING_BUFFER_COMPAT_GET_NEXT_PACKET:
+		return lttng_stream_ring_buffer_get_next_packet(filp, buf, arg);
 	default:
 		return lib_ring_buffer_file_operations.compat_ioctl(filp,
 				cmd, arg);
@@ -3001,6 +3787,8 @@ static void lttng_stream_override_ring_buffer_fops(void)
 		lib_ring_buffer_file_operations.release;
 	lttng_stream_ring_buffer_file_operations.poll =
 		lib_ring_buffer_file_operations.poll;
+	lttng_stream_ring_buffer_file_operations.read =
+		lib_ring_buffer_file_operations.read;
 	lttng_stream_ring_buffer_file_operations.splice_read =
 		lib_ring_buffer_file_operations.splice_read;
 	lttng_stream_ring_buffer_file_operations.mmap =
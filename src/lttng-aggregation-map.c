@@ -0,0 +1,231 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-aggregation-map.c
+ *
+ * LTTng keyed aggregation maps.
+ *
+ * An aggregation map counts the hits of the event notifiers attached to
+ * it, per value of their captured fields. The keys are kept in a
+ * lock-free open addressing table shared by all CPUs, and the count of
+ * slot N is counter N of a per-cpu counter, so that hits on a key
+ * already in the table only touch the local CPU counter.
+ */
+
+#include <linux/atomic.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <asm/barrier.h>
+
+#include <lttng/lttng-bytecode.h>
+#include <lttng/events.h>
+#include <lttng/events-internal.h>
+#include <wrapper/compiler_attributes.h>
+#include <wrapper/vmalloc.h>
+
+/* Number of slots probed before a hit is dropped. */
+#define AGGREGATION_MAP_MAX_PROBES	32
+
+struct aggregation_map_key {
+	uint64_t values[LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX];
+	uint32_t nil_mask;
+};
+
+/*
+ * Create an aggregation map of @nr_slots slots in @event_notifier_group.
+ * Should be called with sessions mutex held.
+ */
+struct lttng_aggregation_map *lttng_aggregation_map_create(
+		struct lttng_event_notifier_group *event_notifier_group,
+		const char *counter_transport_name, size_t nr_slots)
+{
+	struct lttng_aggregation_map *aggregation_map;
+
+	if (!is_power_of_2(nr_slots)
+			|| nr_slots > SIZE_MAX / sizeof(struct lttng_aggregation_map_slot))
+		return NULL;
+
+	aggregation_map = lttng_kvzalloc(sizeof(*aggregation_map), GFP_KERNEL);
+	if (!aggregation_map)
+		goto nomem;
+	aggregation_map->slots = lttng_kvzalloc(nr_slots * sizeof(struct lttng_aggregation_map_slot),
+			GFP_KERNEL);
+	if (!aggregation_map->slots)
+		goto nomem_slots;
+	aggregation_map->counter = lttng_kernel_counter_create(counter_transport_name,
+			1, &nr_slots);
+	if (!aggregation_map->counter)
+		goto counter_error;
+
+	aggregation_map->counter->aggregation_map = aggregation_map;
+	aggregation_map->group = event_notifier_group;
+	aggregation_map->nr_slots = nr_slots;
+	atomic_long_set(&aggregation_map->dropped, 0);
+	list_add(&aggregation_map->node, &event_notifier_group->aggregation_maps_head);
+	return aggregation_map;
+
+counter_error:
+	lttng_kvfree(aggregation_map->slots);
+nomem_slots:
+	lttng_kvfree(aggregation_map);
+nomem:
+	return NULL;
+}
+
+/*
+ * Only called when the event notifier group is destroyed, once no event
+ * notifier can use the map anymore.
+ * Should be called with sessions mutex held.
+ */
+void lttng_aggregation_map_destroy(struct lttng_aggregation_map *aggregation_map)
+{
+	struct lttng_counter *counter = aggregation_map->counter;
+
+	list_del(&aggregation_map->node);
+	counter->ops->counter_destroy(counter->counter);
+	module_put(counter->transport->owner);
+	lttng_kvfree(counter);
+	lttng_kvfree(aggregation_map->slots);
+	lttng_kvfree(aggregation_map);
+}
+
+/*
+ * Evaluate the capture bytecodes of @event_notifier into @key. Values
+ * which cannot be used as a key are flagged in the nil mask.
+ */
+static
+void aggregation_map_get_key(struct lttng_kernel_event_notifier *event_notifier,
+		const char *stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		struct lttng_kernel_notification_ctx *notif_ctx,
+		struct aggregation_map_key *key)
+{
+	struct lttng_kernel_bytecode_runtime *capture_bc_runtime;
+	unsigned int i = 0;
+
+	/* Clear the padding, which is hashed with the key. */
+	memset(key, 0, sizeof(*key));
+	if (!notif_ctx->eval_capture)
+		return;
+
+	list_for_each_entry_rcu(capture_bc_runtime,
+			&event_notifier->priv->capture_bytecode_runtime_head, node) {
+		struct lttng_interpreter_output output;
+
+		if (i >= LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX)
+			break;
+		if (capture_bc_runtime->interpreter_func(capture_bc_runtime,
+				stack_data, probe_ctx, &output) != LTTNG_KERNEL_BYTECODE_INTERPRETER_OK) {
+			key->nil_mask |= 1U << i++;
+			continue;
+		}
+		switch (output.type) {
+		case LTTNG_INTERPRETER_TYPE_S64:
+		case LTTNG_INTERPRETER_TYPE_SIGNED_ENUM:
+			key->values[i] = (uint64_t) output.u.s;
+			break;
+		case LTTNG_INTERPRETER_TYPE_U64:
+		case LTTNG_INTERPRETER_TYPE_UNSIGNED_ENUM:
+			key->values[i] = output.u.u;
+			break;
+		case LTTNG_INTERPRETER_TYPE_STRING:
+			/* User-space strings cannot be read from every probe context. */
+			if (!output.u.str.user) {
+				key->values[i] = jhash(output.u.str.str,
+						strnlen(output.u.str.str, output.u.str.len), 0);
+				break;
+			}
+			lttng_fallthrough;
+		default:
+			key->nil_mask |= 1U << i;
+			break;
+		}
+		i++;
+	}
+}
+
+/*
+ * Find the slot holding @key, claiming a free slot for it if it is not
+ * in the map yet. A slot claimed concurrently whose key is not published
+ * yet is skipped, so the same key may end up in more than one slot.
+ */
+static
+bool aggregation_map_find_slot(struct lttng_aggregation_map *aggregation_map,
+		const struct aggregation_map_key *key, size_t *index)
+{
+	size_t mask = aggregation_map->nr_slots - 1;
+	unsigned int probe, nr_probes;
+	uint32_t hash;
+
+	hash = jhash2((const u32 *) key, sizeof(*key) / sizeof(u32), 0);
+	/* A zero hash marks free slots. */
+	if (!hash)
+		hash = 1;
+	nr_probes = min_t(size_t, AGGREGATION_MAP_MAX_PROBES, aggregation_map->nr_slots);
+	for (probe = 0; probe < nr_probes; probe++) {
+		size_t i = (hash + probe) & mask;
+		struct lttng_aggregation_map_slot *slot = &aggregation_map->slots[i];
+		uint32_t slot_hash = READ_ONCE(slot->hash);
+
+		if (!slot_hash) {
+			slot_hash = cmpxchg(&slot->hash, 0, hash);
+			if (!slot_hash) {
+				memcpy(slot->values, key->values, sizeof(slot->values));
+				slot->nil_mask = key->nil_mask;
+				/* Publish the key, matches load-acquire below and in read_key. */
+				smp_store_release(&slot->ready, 1);
+				*index = i;
+				return true;
+			}
+		}
+		if (slot_hash != hash || !smp_load_acquire(&slot->ready))
+			continue;
+		if (slot->nil_mask == key->nil_mask
+				&& !memcmp(slot->values, key->values, sizeof(slot->values))) {
+			*index = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Count a hit of @event_notifier in @aggregation_map, keyed by the
+ * values of its captures.
+ */
+void lttng_aggregation_map_update(struct lttng_aggregation_map *aggregation_map,
+		struct lttng_kernel_event_notifier *event_notifier,
+		const char *stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		struct lttng_kernel_notification_ctx *notif_ctx)
+{
+	struct lttng_counter *counter = aggregation_map->counter;
+	struct aggregation_map_key key;
+	size_t index;
+	int ret;
+
+	aggregation_map_get_key(event_notifier, stack_data, probe_ctx, notif_ctx, &key);
+	if (!aggregation_map_find_slot(aggregation_map, &key, &index)) {
+		atomic_long_inc(&aggregation_map->dropped);
+		return;
+	}
+	ret = counter->ops->counter_add(counter->counter, &index, 1);
+	WARN_ON_ONCE(ret);
+}
+
+/*
+ * Read the key of slot @index, which must be below the number of slots.
+ */
+void lttng_aggregation_map_read_key(struct lttng_aggregation_map *aggregation_map,
+		size_t index, struct lttng_kernel_abi_aggregation_map_key *key)
+{
+	struct lttng_aggregation_map_slot *slot = &aggregation_map->slots[index];
+
+	memset(key, 0, sizeof(*key));
+	if (!smp_load_acquire(&slot->ready))
+		return;
+	key->used = 1;
+	key->nil_mask = slot->nil_mask;
+	memcpy(key->values, slot->values, sizeof(key->values));
+}
@@ -0,0 +1,797 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * lttng-bytecode-compiler.c
+ *
+ * LTTng modules bytecode compiler.
+ *
+ * Translates specialized filter bytecode made of integer comparisons
+ * combined with logical operators into a flat predicate program. The
+ * predicate program is evaluated without the interpreter execution
+ * stack: each instruction compares two operands loaded directly from the
+ * immediate, the event payload or the context, and updates a single
+ * boolean result. Bytecode using any other instruction is left to the
+ * interpreter.
+ *
+ * The filter runtimes of an event are also merged into a single
+ * program, turning equality tests of a field against immediate values
+ * into a lookup in a sorted set.
+ *
+ * Copyright (C) 2010-2016 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
+ */
+
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/rcupdate.h>
+
+#include <lttng/lttng-bytecode.h>
+#include <lttng/events-internal.h>
+
+#define COMPILED_MAP_INVALID	U16_MAX
+
+struct compiler_state {
+	struct bytecode_runtime *runtime;
+	struct bytecode_compiled *compiled;
+	struct bytecode_compiled_operand operands[2];
+	unsigned int nr_operands;
+	bool has_result;		/* A boolean result is available. */
+};
+
+static
+int compiler_emit(struct compiler_state *state, enum bytecode_compiled_op op)
+{
+	struct bytecode_compiled *compiled = state->compiled;
+	struct bytecode_compiled_insn *insn;
+
+	if (compiled->len >= state->runtime->len)
+		return -EINVAL;
+	insn = &compiled->insn[compiled->len++];
+	insn->op = op;
+	insn->target = 0;
+	switch (op) {
+	case BYTECODE_COMPILED_OP_TEST:
+		insn->a = state->operands[0];
+		break;
+	case BYTECODE_COMPILED_OP_EQ:
+	case BYTECODE_COMPILED_OP_NE:
+	case BYTECODE_COMPILED_OP_GT:
+	case BYTECODE_COMPILED_OP_LT:
+	case BYTECODE_COMPILED_OP_GE:
+	case BYTECODE_COMPILED_OP_LE:
+		insn->a = state->operands[0];
+		insn->b = state->operands[1];
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
+static
+int compiler_push_operand(struct compiler_state *state,
+		enum bytecode_compiled_operand_type type, int64_t value)
+{
+	struct bytecode_compiled_operand *operand;
+
+	/* Only comparisons of two leaf operands are compiled. */
+	if (state->has_result || state->nr_operands >= 2)
+		return -EOPNOTSUPP;
+	operand = &state->operands[state->nr_operands++];
+	operand->type = type;
+	switch (type) {
+	case BYTECODE_COMPILED_OPERAND_IMM:
+		operand->u.imm = value;
+		break;
+	case BYTECODE_COMPILED_OPERAND_PAYLOAD:
+		operand->u.offset = value;
+		break;
+	case BYTECODE_COMPILED_OPERAND_CONTEXT:
+		operand->u.ctx_index = value;
+		break;
+	}
+	return 0;
+}
+
+/*
+ * Turn a pending operand used as a truth value into a test, so a boolean
+ * result is available for logical operators and return.
+ */
+static
+int compiler_get_result(struct compiler_state *state)
+{
+	int ret;
+
+	if (state->nr_operands == 1 && !state->has_result) {
+		ret = compiler_emit(state, BYTECODE_COMPILED_OP_TEST);
+		if (ret)
+			return ret;
+		state->nr_operands = 0;
+		state->has_result = true;
+	}
+	if (state->nr_operands || !state->has_result)
+		return -EOPNOTSUPP;
+	return 0;
+}
+
+/*
+ * Parse the GET_*_ROOT, GET_INDEX_U16, LOAD_FIELD_{S,U}64 sequence
+ * emitted for payload and context field accesses. Returns the length of
+ * the sequence, or a negative error.
+ */
+static
+int compiler_parse_get_root(struct compiler_state *state, char *pc, char *end)
+{
+	struct bytecode_runtime *runtime = state->runtime;
+	const struct bytecode_get_index_data *gid;
+	struct load_op *insn = (struct load_op *) pc;
+	struct load_op *index_insn, *load_insn;
+	int len = sizeof(struct load_op) + sizeof(struct get_index_u16)
+			+ sizeof(struct load_op);
+	int ret;
+
+	if (end - pc < len)
+		return -EOPNOTSUPP;
+	index_insn = (struct load_op *) (pc + sizeof(struct load_op));
+	load_insn = (struct load_op *) (pc + sizeof(struct load_op)
+			+ sizeof(struct load_op) + sizeof(struct get_index_u16));
+	if (index_insn->op != BYTECODE_OP_GET_INDEX_U16)
+		return -EOPNOTSUPP;
+	if (load_insn->op != BYTECODE_OP_LOAD_FIELD_S64
+			&& load_insn->op != BYTECODE_OP_LOAD_FIELD_U64)
+		return -EOPNOTSUPP;
+	gid = (const struct bytecode_get_index_data *)
+		&runtime->data[((struct get_index_u16 *) index_insn->data)->index];
+	switch (insn->op) {
+	case BYTECODE_OP_GET_PAYLOAD_ROOT:
+		ret = compiler_push_operand(state,
+				BYTECODE_COMPILED_OPERAND_PAYLOAD, gid->offset);
+		break;
+	case BYTECODE_OP_GET_CONTEXT_ROOT:
+		ret = compiler_push_operand(state,
+				BYTECODE_COMPILED_OPERAND_CONTEXT, gid->ctx_index);
+		break;
+	default:
+		ret = -EOPNOTSUPP;
+		break;
+	}
+	if (ret)
+		return ret;
+	return len;
+}
+
+/*
+ * Resolve logical operator jump targets, from bytecode offsets to
+ * predicate program instruction indexes. Jumps only move forward, onto
+ * an instruction consuming the boolean result.
+ */
+static
+int compiler_resolve_targets(struct bytecode_compiled *compiled,
+		const uint16_t *map, uint16_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < compiled->len; i++) {
+		struct bytecode_compiled_insn *insn = &compiled->insn[i];
+		uint16_t target;
+
+		if (insn->op != BYTECODE_COMPILED_OP_AND
+				&& insn->op != BYTECODE_COMPILED_OP_OR)
+			continue;
+		if (insn->target > len)
+			return -EINVAL;
+		target = map[insn->target];
+		if (target == COMPILED_MAP_INVALID || target <= i
+				|| target >= compiled->len)
+			return -EOPNOTSUPP;
+		switch (compiled->insn[target].op) {
+		case BYTECODE_COMPILED_OP_NOT:
+		case BYTECODE_COMPILED_OP_AND:
+		case BYTECODE_COMPILED_OP_OR:
+		case BYTECODE_COMPILED_OP_RETURN:
+			break;
+		default:
+			return -EOPNOTSUPP;
+		}
+		insn->target = target;
+	}
+	return 0;
+}
+
+/*
+ * Compile validated and specialized filter bytecode. Returns 0 on
+ * success, -EOPNOTSUPP if the bytecode cannot be compiled, in which case
+ * the interpreter should be used, or another negative error.
+ */
+int lttng_bytecode_compile(struct bytecode_runtime *runtime)
+{
+	struct compiler_state state = {
+		.runtime = runtime,
+	};
+	struct bytecode_compiled *compiled;
+	char *start_pc = runtime->code, *end_pc = runtime->code + runtime->len;
+	char *pc, *next_pc;
+	uint16_t *map;
+	int ret;
+
+	if (runtime->p.type != LTTNG_KERNEL_BYTECODE_TYPE_FILTER)
+		return -EOPNOTSUPP;
+	/* Each instruction produces at most one program instruction. */
+	compiled = kzalloc(sizeof(*compiled)
+			+ runtime->len * sizeof(struct bytecode_compiled_insn),
+			GFP_KERNEL);
+	if (!compiled)
+		return -ENOMEM;
+	map = kmalloc_array(runtime->len + 1, sizeof(*map), GFP_KERNEL);
+	if (!map) {
+		ret = -ENOMEM;
+		goto free_compiled;
+	}
+	memset(map, 0xFF, (runtime->len + 1) * sizeof(*map));
+	state.compiled = compiled;
+
+	for (pc = next_pc = start_pc; pc < end_pc; pc = next_pc) {
+		map[pc - start_pc] = compiled->len;
+		switch (*(bytecode_opcode_t *) pc) {
+		case BYTECODE_OP_LOAD_S64:
+		{
+			struct load_op *insn = (struct load_op *) pc;
+
+			ret = compiler_push_operand(&state,
+					BYTECODE_COMPILED_OPERAND_IMM,
+					((struct literal_numeric *) insn->data)->v);
+			next_pc += sizeof(struct load_op)
+					+ sizeof(struct literal_numeric);
+			break;
+		}
+		case BYTECODE_OP_LOAD_FIELD_REF_S64:
+		{
+			struct load_op *insn = (struct load_op *) pc;
+
+			ret = compiler_push_operand(&state,
+					BYTECODE_COMPILED_OPERAND_PAYLOAD,
+					((struct field_ref *) insn->data)->offset);
+			next_pc += sizeof(struct load_op) + sizeof(struct field_ref);
+			break;
+		}
+		case BYTECODE_OP_GET_CONTEXT_REF_S64:
+		{
+			struct load_op *insn = (struct load_op *) pc;
+
+			ret = compiler_push_operand(&state,
+					BYTECODE_COMPILED_OPERAND_CONTEXT,
+					((struct field_ref *) insn->data)->offset);
+			next_pc += sizeof(struct load_op) + sizeof(struct field_ref);
+			break;
+		}
+		case BYTECODE_OP_GET_PAYLOAD_ROOT:
+		case BYTECODE_OP_GET_CONTEXT_ROOT:
+			ret = compiler_parse_get_root(&state, pc, end_pc);
+			if (ret > 0) {
+				next_pc += ret;
+				ret = 0;
+			}
+			break;
+		case BYTECODE_OP_CAST_NOP:
+			ret = 0;
+			next_pc += sizeof(struct cast_op);
+			break;
+		case BYTECODE_OP_EQ_S64:
+		case BYTECODE_OP_NE_S64:
+		case BYTECODE_OP_GT_S64:
+		case BYTECODE_OP_LT_S64:
+		case BYTECODE_OP_GE_S64:
+		case BYTECODE_OP_LE_S64:
+			if (state.nr_operands != 2) {
+				ret = -EOPNOTSUPP;
+				break;
+			}
+			ret = compiler_emit(&state, BYTECODE_COMPILED_OP_EQ
+					+ (*(bytecode_opcode_t *) pc - BYTECODE_OP_EQ_S64));
+			state.nr_operands = 0;
+			state.has_result = true;
+			next_pc += sizeof(struct binary_op);
+			break;
+		case BYTECODE_OP_LOAD_PAYLOAD_CMP_S64:
+		case BYTECODE_OP_LOAD_CONTEXT_CMP_S64:
+		{
+			struct load_cmp_s64_op *insn = (struct load_cmp_s64_op *) pc;
+
+			ret = compiler_push_operand(&state,
+					insn->op == BYTECODE_OP_LOAD_CONTEXT_CMP_S64 ?
+						BYTECODE_COMPILED_OPERAND_CONTEXT :
+						BYTECODE_COMPILED_OPERAND_PAYLOAD,
+					insn->index);
+			if (!ret)
+				ret = compiler_push_operand(&state,
+						BYTECODE_COMPILED_OPERAND_IMM, insn->v);
+			if (ret)
+				break;
+			ret = compiler_emit(&state, BYTECODE_COMPILED_OP_EQ
+					+ (insn->cmp - BYTECODE_OP_EQ_S64));
+			state.nr_operands = 0;
+			state.has_result = true;
+			next_pc += insn->len;
+			break;
+		}
+		case BYTECODE_OP_UNARY_NOT_S64:
+			ret = compiler_get_result(&state);
+			if (!ret)
+				ret = compiler_emit(&state, BYTECODE_COMPILED_OP_NOT);
+			next_pc += sizeof(struct unary_op);
+			break;
+		case BYTECODE_OP_AND:
+		case BYTECODE_OP_OR:
+		{
+			struct logical_op *insn = (struct logical_op *) pc;
+
+			ret = compiler_get_result(&state);
+			if (ret)
+				break;
+			ret = compiler_emit(&state,
+					insn->op == BYTECODE_OP_AND ?
+						BYTECODE_COMPILED_OP_AND :
+						BYTECODE_COMPILED_OP_OR);
+			if (ret)
+				break;
+			/* Resolved once all instructions are mapped. */
+			compiled->insn[compiled->len - 1].target = insn->skip_offset;
+			/* The result is popped when the jump is not taken. */
+			state.has_result = false;
+			next_pc += sizeof(struct logical_op);
+			break;
+		}
+		case BYTECODE_OP_RETURN:
+		case BYTECODE_OP_RETURN_S64:
+			ret = compiler_get_result(&state);
+			if (!ret)
+				ret = compiler_emit(&state, BYTECODE_COMPILED_OP_RETURN);
+			state.has_result = false;
+			next_pc += sizeof(struct return_op);
+			break;
+		default:
+			ret = -EOPNOTSUPP;
+			break;
+		}
+		if (ret)
+			goto free_map;
+	}
+	map[runtime->len] = compiled->len;
+	if (!compiled->len
+			|| compiled->insn[compiled->len - 1].op != BYTECODE_COMPILED_OP_RETURN) {
+		ret = -EOPNOTSUPP;
+		goto free_map;
+	}
+	ret = compiler_resolve_targets(compiled, map, runtime->len);
+	if (ret)
+		goto free_map;
+	kfree(map);
+	runtime->compiled = compiled;
+	dbg_printk("Bytecode compiled into %u instructions.\n", compiled->len);
+	return 0;
+
+free_map:
+	kfree(map);
+free_compiled:
+	kfree(compiled);
+	return ret;
+}
+
+static inline
+int64_t compiled_load(const struct bytecode_compiled_operand *operand,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *lttng_probe_ctx)
+{
+	switch (operand->type) {
+	case BYTECODE_COMPILED_OPERAND_IMM:
+		return operand->u.imm;
+	case BYTECODE_COMPILED_OPERAND_PAYLOAD:
+		return ((struct literal_numeric *) &interpreter_stack_data[operand->u.offset])->v;
+	case BYTECODE_COMPILED_OPERAND_CONTEXT:
+	{
+		struct lttng_kernel_ctx_field *ctx_field;
+		struct lttng_ctx_value v;
+
+		ctx_field = &lttng_static_ctx->fields[operand->u.ctx_index];
+		ctx_field->get_value(ctx_field->priv, lttng_probe_ctx, &v);
+		return v.u.s64;
+	}
+	}
+	return 0;
+}
+
+/*
+ * Evaluate a compiled filter. Same contract as lttng_bytecode_interpret()
+ * for FILTER bytecode.
+ */
+int lttng_bytecode_interpret_compiled(struct lttng_kernel_bytecode_runtime *kernel_bytecode,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *lttng_probe_ctx,
+		void *caller_ctx)
+{
+	struct bytecode_runtime *bytecode = container_of(kernel_bytecode, struct bytecode_runtime, p);
+	const struct bytecode_compiled_insn *start = bytecode->compiled->insn;
+	const struct bytecode_compiled_insn *insn = start;
+	struct lttng_kernel_bytecode_filter_ctx *filter_ctx =
+		(struct lttng_kernel_bytecode_filter_ctx *) caller_ctx;
+	bool result = false;
+
+	for (;;) {
+		switch (insn->op) {
+		case BYTECODE_COMPILED_OP_TEST:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx) != 0;
+			break;
+		case BYTECODE_COMPILED_OP_EQ:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				== compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_NE:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				!= compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_GT:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				> compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_LT:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				< compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_GE:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				>= compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_LE:
+			result = compiled_load(&insn->a, interpreter_stack_data, lttng_probe_ctx)
+				<= compiled_load(&insn->b, interpreter_stack_data, lttng_probe_ctx);
+			break;
+		case BYTECODE_COMPILED_OP_NOT:
+			result = !result;
+			break;
+		case BYTECODE_COMPILED_OP_AND:
+			/* If false, skip and evaluate to false. */
+			if (!result) {
+				insn = start + insn->target;
+				continue;
+			}
+			break;
+		case BYTECODE_COMPILED_OP_OR:
+			/* If true, skip and evaluate to true. */
+			if (result) {
+				insn = start + insn->target;
+				continue;
+			}
+			break;
+		case BYTECODE_COMPILED_OP_RETURN:
+			if (result)
+				filter_ctx->result = LTTNG_KERNEL_BYTECODE_FILTER_ACCEPT;
+			else
+				filter_ctx->result = LTTNG_KERNEL_BYTECODE_FILTER_REJECT;
+			return LTTNG_KERNEL_BYTECODE_INTERPRETER_OK;
+		default:
+			return LTTNG_KERNEL_BYTECODE_INTERPRETER_ERROR;
+		}
+		insn++;
+	}
+}
+
+static
+bool compiled_operand_equal(const struct bytecode_compiled_operand *a,
+		const struct bytecode_compiled_operand *b)
+{
+	if (a->type != b->type)
+		return false;
+	switch (a->type) {
+	case BYTECODE_COMPILED_OPERAND_IMM:
+		return a->u.imm == b->u.imm;
+	case BYTECODE_COMPILED_OPERAND_PAYLOAD:
+		return a->u.offset == b->u.offset;
+	case BYTECODE_COMPILED_OPERAND_CONTEXT:
+		return a->u.ctx_index == b->u.ctx_index;
+	}
+	return false;
+}
+
+/*
+ * Check whether a compiled program only tests a single field for
+ * equality against immediate values, e.g. "pid == 1 || pid == 2". Its
+ * instructions are then equality tests, OR operators jumping to another
+ * OR or to the final RETURN, and the RETURN: the program accepts the
+ * event if any of the equality tests is true. On success, the field is
+ * returned in @field and the number of tests in @nr_values.
+ */
+static
+bool compiled_is_eq_set(const struct bytecode_compiled *compiled,
+		struct bytecode_compiled_operand *field, unsigned int *nr_values)
+{
+	unsigned int i, nr = 0;
+
+	if (!compiled->len
+			|| compiled->insn[compiled->len - 1].op != BYTECODE_COMPILED_OP_RETURN)
+		return false;
+	for (i = 0; i < compiled->len - 1; i++) {
+		const struct bytecode_compiled_insn *insn = &compiled->insn[i];
+		const struct bytecode_compiled_operand *f;
+
+		switch (insn->op) {
+		case BYTECODE_COMPILED_OP_EQ:
+			/* Alternate tests and OR operators. */
+			if (i & 1)
+				return false;
+			if (insn->a.type != BYTECODE_COMPILED_OPERAND_IMM
+					&& insn->b.type == BYTECODE_COMPILED_OPERAND_IMM)
+				f = &insn->a;
+			else if (insn->a.type == BYTECODE_COMPILED_OPERAND_IMM
+					&& insn->b.type != BYTECODE_COMPILED_OPERAND_IMM)
+				f = &insn->b;
+			else
+				return false;
+			if (!nr)
+				*field = *f;
+			else if (!compiled_operand_equal(field, f))
+				return false;
+			nr++;
+			break;
+		case BYTECODE_COMPILED_OP_OR:
+		{
+			enum bytecode_compiled_op target_op;
+
+			if (!(i & 1) || insn->target >= compiled->len)
+				return false;
+			target_op = compiled->insn[insn->target].op;
+			if (target_op != BYTECODE_COMPILED_OP_OR
+					&& target_op != BYTECODE_COMPILED_OP_RETURN)
+				return false;
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+	/*
+	 * Tests sit at even indexes, so the program ends with a test
+	 * followed by the RETURN, e.g. EQ, OR, EQ, RETURN: its length is
+	 * even.
+	 */
+	if (compiled->len & 1)
+		return false;
+	*nr_values = nr;
+	return true;
+}
+
+/* Append the immediate values of a program accepted by compiled_is_eq_set(). */
+static
+unsigned int compiled_eq_set_values(const struct bytecode_compiled *compiled,
+		int64_t *values)
+{
+	unsigned int i, nr = 0;
+
+	for (i = 0; i < compiled->len; i++) {
+		const struct bytecode_compiled_insn *insn = &compiled->insn[i];
+
+		if (insn->op != BYTECODE_COMPILED_OP_EQ)
+			continue;
+		if (insn->a.type == BYTECODE_COMPILED_OPERAND_IMM)
+			values[nr++] = insn->a.u.imm;
+		else
+			values[nr++] = insn->b.u.imm;
+	}
+	return nr;
+}
+
+static
+int merged_value_cmp(const void *a, const void *b)
+{
+	int64_t va = *(const int64_t *) a, vb = *(const int64_t *) b;
+
+	if (va < vb)
+		return -1;
+	if (va > vb)
+		return 1;
+	return 0;
+}
+
+void lttng_bytecode_merged_free(struct bytecode_merged *merged)
+{
+	if (!merged)
+		return;
+	kfree(merged->values);
+	kfree(merged->inputs);
+	kfree(merged->runtimes);
+	kfree(merged->sets);
+	kfree(merged);
+}
+
+/*
+ * Build the merged program of the enabled runtimes in @inputs. Returns
+ * NULL if merging brings nothing over evaluating the runtimes in turn,
+ * or on allocation failure.
+ */
+static
+struct bytecode_merged *merge_runtimes(struct lttng_kernel_bytecode_runtime **inputs,
+		unsigned int nr_inputs)
+{
+	struct bytecode_merged *merged;
+	unsigned int i, j, nr_values = 0, nr_merged = 0;
+
+	merged = kzalloc(sizeof(*merged), GFP_KERNEL);
+	if (!merged)
+		goto error;
+	merged->inputs = inputs;
+	merged->nr_inputs = nr_inputs;
+	merged->sets = kcalloc(nr_inputs, sizeof(*merged->sets), GFP_KERNEL);
+	merged->runtimes = kcalloc(nr_inputs, sizeof(*merged->runtimes), GFP_KERNEL);
+	if (!merged->sets || !merged->runtimes)
+		goto error;
+
+	/* Group the equality sets by field. */
+	for (i = 0; i < nr_inputs; i++) {
+		struct bytecode_runtime *runtime =
+			container_of(inputs[i], struct bytecode_runtime, p);
+		struct bytecode_compiled_operand field;
+		unsigned int nr;
+
+		if (!runtime->compiled
+				|| !compiled_is_eq_set(runtime->compiled, &field, &nr)) {
+			merged->runtimes[merged->nr_runtimes++] = inputs[i];
+			continue;
+		}
+		for (j = 0; j < merged->nr_sets; j++) {
+			if (compiled_operand_equal(&merged->sets[j].field, &field))
+				break;
+		}
+		if (j == merged->nr_sets) {
+			merged->sets[j].field = field;
+			merged->nr_sets++;
+		}
+		merged->sets[j].nr_values += nr;
+		nr_values += nr;
+		nr_merged++;
+	}
+	/* Nothing to share: a single test per merged runtime, one per field. */
+	if (nr_values == merged->nr_sets && nr_merged <= 1)
+		goto error;
+
+	merged->values = kcalloc(nr_values, sizeof(*merged->values), GFP_KERNEL);
+	if (!merged->values)
+		goto error;
+	nr_values = 0;
+	for (j = 0; j < merged->nr_sets; j++) {
+		struct bytecode_merged_set *set = &merged->sets[j];
+		unsigned int nr = 0, k;
+
+		set->values = &merged->values[nr_values];
+		for (i = 0; i < nr_inputs; i++) {
+			struct bytecode_runtime *runtime =
+				container_of(inputs[i], struct bytecode_runtime, p);
+			struct bytecode_compiled_operand field;
+			unsigned int nr_runtime;
+
+			if (!runtime->compiled
+					|| !compiled_is_eq_set(runtime->compiled, &field, &nr_runtime)
+					|| !compiled_operand_equal(&set->field, &field))
+				continue;
+			nr += compiled_eq_set_values(runtime->compiled, &set->values[nr]);
+		}
+		sort(set->values, nr, sizeof(set->values[0]), merged_value_cmp, NULL);
+		/* Remove duplicates. */
+		set->nr_values = nr ? 1 : 0;
+		for (k = 1; k < nr; k++) {
+			if (set->values[k] != set->values[set->nr_values - 1])
+				set->values[set->nr_values++] = set->values[k];
+		}
+		nr_values += nr;
+	}
+	dbg_printk("Merged %u filter runtimes into %u sets, %u runtimes left.\n",
+		nr_inputs, merged->nr_sets, merged->nr_runtimes);
+	return merged;
+
+error:
+	if (merged) {
+		/* The inputs are owned by the caller on error. */
+		merged->inputs = NULL;
+		lttng_bytecode_merged_free(merged);
+	}
+	return NULL;
+}
+
+/*
+ * Free the merged programs replaced by lttng_bytecode_merge_event_filter()
+ * once in-flight filters are done with them, with a single grace period
+ * for all of them.
+ */
+void lttng_bytecode_merged_free_retired(struct list_head *retired)
+{
+	struct bytecode_merged *merged, *tmp;
+
+	if (list_empty(retired))
+		return;
+	synchronize_trace();	/* Wait for in-flight filters to complete */
+	list_for_each_entry_safe(merged, tmp, retired, retired_node)
+		lttng_bytecode_merged_free(merged);
+	INIT_LIST_HEAD(retired);
+}
+
+/*
+ * Merge the enabled filter runtimes of an event into a single program,
+ * after their state was synchronized. The event keeps evaluating the
+ * runtimes in turn when no merged program is available. The replaced
+ * program is added to @retired, to be freed by
+ * lttng_bytecode_merged_free_retired(). Should be called with sessions
+ * mutex held.
+ */
+void lttng_bytecode_merge_event_filter(struct lttng_kernel_event_common *event,
+		struct list_head *retired)
+{
+	struct bytecode_merged *old_merged = event->priv->filter_merged, *merged = NULL;
+	struct lttng_kernel_bytecode_runtime **inputs = NULL, *runtime;
+	unsigned int nr_inputs = 0, nr_runtimes = 0;
+
+	list_for_each_entry(runtime, &event->priv->filter_bytecode_runtime_head, node)
+		nr_runtimes++;
+	if (nr_runtimes) {
+		inputs = kcalloc(nr_runtimes, sizeof(*inputs), GFP_KERNEL);
+		if (!inputs)
+			goto update;
+	}
+	list_for_each_entry(runtime, &event->priv->filter_bytecode_runtime_head, node) {
+		if (runtime->interpreter_func == lttng_bytecode_interpret_error)
+			continue;
+		inputs[nr_inputs++] = runtime;
+	}
+	/* Same enabled runtimes: keep the current program. */
+	if (old_merged && old_merged->nr_inputs == nr_inputs
+			&& !memcmp(old_merged->inputs, inputs, nr_inputs * sizeof(*inputs))) {
+		kfree(inputs);
+		return;
+	}
+	if (nr_inputs)
+		merged = merge_runtimes(inputs, nr_inputs);
+	if (!merged)
+		kfree(inputs);
+update:
+	if (!merged && !old_merged)
+		return;
+	rcu_assign_pointer(event->priv->filter_merged, merged);
+	if (old_merged)
+		list_add(&old_merged->retired_node, retired);
+}
+
+/*
+ * Evaluate the merged filter program of an event. Returns
+ * LTTNG_KERNEL_EVENT_FILTER_ACCEPT if any of the merged runtimes
+ * accepts the event.
+ */
+int lttng_bytecode_interpret_merged(const struct bytecode_merged *merged,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *lttng_probe_ctx)
+{
+	struct lttng_kernel_bytecode_filter_ctx bytecode_filter_ctx;
+	unsigned int i;
+
+	for (i = 0; i < merged->nr_sets; i++) {
+		const struct bytecode_merged_set *set = &merged->sets[i];
+		int64_t v = compiled_load(&set->field, interpreter_stack_data, lttng_probe_ctx);
+		unsigned int low = 0, high = set->nr_values;
+
+		/* Binary search in the sorted values. */
+		while (low < high) {
+			unsigned int mid = low + (high - low) / 2;
+
+			if (set->values[mid] == v)
+				return LTTNG_KERNEL_EVENT_FILTER_ACCEPT;
+			if (set->values[mid] < v)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+	}
+	for (i = 0; i < merged->nr_runtimes; i++) {
+		struct lttng_kernel_bytecode_runtime *runtime = merged->runtimes[i];
+
+		if (likely(runtime->interpreter_func(runtime, interpreter_stack_data,
+				lttng_probe_ctx, &bytecode_filter_ctx) == LTTNG_KERNEL_BYTECODE_INTERPRETER_OK)) {
+			if (unlikely(bytecode_filter_ctx.result == LTTNG_KERNEL_BYTECODE_FILTER_ACCEPT))
+				return LTTNG_KERNEL_EVENT_FILTER_ACCEPT;
+		}
+	}
+	return LTTNG_KERNEL_EVENT_FILTER_REJECT;
+}
@@ -11,7 +11,11 @@
 #include <wrapper/uaccess.h>
 #include <wrapper/objtool.h>
 #include <wrapper/types.h>
+#include <wrapper/rcu.h>
+#include <wrapper/unaligned.h>
 #include <linux/swab.h>
+#include <linux/timex.h>
+#include <linux/percpu.h>
 
 #include <lttng/lttng-bytecode.h>
 #include <lttng/string-utils.h>
@@ -86,13 +90,6 @@ int stack_star_glob_match(struct estack *stack, int top, const char *cmp_type)
 	struct estack_entry *pattern_reg;
 	struct estack_entry *candidate_reg;
 
-	/* Disable the page fault handler when reading from userspace. */
-	if (estack_bx(stack, top)->u.s.user
-			|| estack_ax(stack, top)->u.s.user) {
-		has_user = true;
-		pagefault_disable();
-	}
-
 	/* Find out which side is the pattern vs. the candidate. */
 	if (estack_ax(stack, top)->u.s.literal_type == ESTACK_STRING_LITERAL_TYPE_STAR_GLOB) {
 		pattern_reg = estack_ax(stack, top);
@@ -102,6 +99,18 @@ int stack_star_glob_match(struct estack *stack, int top, const char *cmp_type)
 		candidate_reg = estack_ax(stack, top);
 	}
 
+	/* Patterns compiled by the specializer, on kernel strings. */
+	if (pattern_reg->u.s.glob && !candidate_reg->u.s.user)
+		return !strutils_star_glob_compiled_match(pattern_reg->u.s.glob,
+			candidate_reg->u.s.str, candidate_reg->u.s.seq_len);
+
+	/* Disable the page fault handler when reading from userspace. */
+	if (estack_bx(stack, top)->u.s.user
+			|| estack_ax(stack, top)->u.s.user) {
+		has_user = true;
+		pagefault_disable();
+	}
+
 	/* Perform the match operation. */
 	result = !strutils_star_glob_match_char_cb(get_char_at_cb,
 		pattern_reg, get_char_at_cb, candidate_reg);
@@ -268,6 +277,119 @@ LABEL_##name
 #define IS_INTEGER_REGISTER(reg_type) \
 		(reg_type == REG_S64 || reg_type == REG_U64)
 
+/* Binary search in the sorted values of an integer set. */
+static
+bool set_s64_lookup(const struct set_op *insn, int64_t v)
+{
+	unsigned int low = 0, high = insn->nr_elem;
+
+	while (low < high) {
+		unsigned int mid = low + (high - low) / 2;
+		int64_t elem = get_unaligned((const int64_t *) insn->data + mid);
+
+		if (elem == v)
+			return true;
+		if (elem < v)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return false;
+}
+
+/*
+ * Compare a string register with a set element, without wildcard or
+ * escape handling. Should be called with page fault handler disabled
+ * if the register holds a user-space string.
+ */
+static
+int set_string_cmp(const struct estack_entry *reg, const char *str)
+{
+	size_t offset;
+
+	for (offset = 0; ; offset++) {
+		unsigned char c = get_char(reg, offset);
+		unsigned char elem = str[offset];
+
+		if (c != elem)
+			return c < elem ? -1 : 1;
+		if (!c)
+			return 0;
+	}
+}
+
+/* Binary search in the sorted elements of a string set. */
+static
+bool set_string_lookup(const struct bytecode_string_set *set,
+		const struct estack_entry *reg)
+{
+	unsigned int low = 0, high = set->nr_elem;
+	bool found = false;
+
+	if (reg->u.s.user)
+		pagefault_disable();
+	while (low < high) {
+		unsigned int mid = low + (high - low) / 2;
+		int diff = set_string_cmp(reg, set->elem[mid]);
+
+		if (!diff) {
+			found = true;
+			break;
+		}
+		if (diff > 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (reg->u.s.user)
+		pagefault_enable();
+	return found;
+}
+
+static inline
+int superinsn_cmp_s64(bytecode_opcode_t cmp, int64_t a, int64_t b)
+{
+	switch (cmp) {
+	case BYTECODE_OP_EQ_S64:
+		return a == b;
+	case BYTECODE_OP_NE_S64:
+		return a != b;
+	case BYTECODE_OP_GT_S64:
+		return a > b;
+	case BYTECODE_OP_LT_S64:
+		return a < b;
+	case BYTECODE_OP_GE_S64:
+		return a >= b;
+	case BYTECODE_OP_LE_S64:
+		return a <= b;
+	default:
+		WARN_ON_ONCE(1);
+		return 0;
+	}
+}
+
+static inline
+int64_t superinsn_get_context_s64(struct lttng_kernel_probe_ctx *lttng_probe_ctx,
+		uint16_t idx)
+{
+	struct lttng_kernel_ctx_field *ctx_field = &lttng_static_ctx->fields[idx];
+	struct lttng_ctx_value v;
+
+	ctx_field->get_value(ctx_field->priv, lttng_probe_ctx, &v);
+	return v.u.s64;
+}
+
+static inline
+const char *superinsn_get_context_string(struct lttng_kernel_probe_ctx *lttng_probe_ctx,
+		uint16_t idx)
+{
+	struct lttng_kernel_ctx_field *ctx_field = &lttng_static_ctx->fields[idx];
+	struct lttng_ctx_value v;
+
+	ctx_field->get_value(ctx_field->priv, lttng_probe_ctx, &v);
+	return v.u.str;
+}
+
 static int context_get_index(struct lttng_kernel_probe_ctx *lttng_probe_ctx,
 		struct load_ptr *ptr,
 		uint32_t idx)
@@ -1009,6 +1131,20 @@ int lttng_bytecode_interpret(struct lttng_kernel_bytecode_runtime *kernel_byteco
 		[ BYTECODE_OP_UNARY_BIT_NOT ] = &&LABEL_BYTECODE_OP_UNARY_BIT_NOT,
 
 		[ BYTECODE_OP_RETURN_S64 ] = &&LABEL_BYTECODE_OP_RETURN_S64,
+
+		/* set membership */
+		[ BYTECODE_OP_IN_SET_S64 ] = &&LABEL_BYTECODE_OP_IN_SET_S64,
+		[ BYTECODE_OP_IN_SET_STRING ] = &&LABEL_BYTECODE_OP_IN_SET_STRING,
+		[ BYTECODE_OP_IN_SET_STRING_INDEX ] = &&LABEL_BYTECODE_OP_IN_SET_STRING_INDEX,
+		[ BYTECODE_OP_LOAD_STAR_GLOB_COMPILED ] = &&LABEL_BYTECODE_OP_LOAD_STAR_GLOB_COMPILED,
+
+		/* Superinstructions. */
+		[ BYTECODE_OP_LOAD_PAYLOAD_CMP_S64 ] = &&LABEL_BYTECODE_OP_LOAD_PAYLOAD_CMP_S64,
+		[ BYTECODE_OP_LOAD_CONTEXT_CMP_S64 ] = &&LABEL_BYTECODE_OP_LOAD_CONTEXT_CMP_S64,
+		[ BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING ] = &&LABEL_BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING,
+		[ BYTECODE_OP_LOAD_CONTEXT_EQ_STRING ] = &&LABEL_BYTECODE_OP_LOAD_CONTEXT_EQ_STRING,
+		[ BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING ] = &&LABEL_BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING,
+		[ BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING ] = &&LABEL_BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING,
 	};
 #endif /* #ifndef INTERPRETER_USE_SWITCH */
 
@@ -1540,10 +1676,28 @@ int lttng_bytecode_interpret(struct lttng_kernel_bytecode_runtime *kernel_byteco
 			estack_ax(stack, top)->u.s.literal_type =
 				ESTACK_STRING_LITERAL_TYPE_STAR_GLOB;
 			estack_ax(stack, top)->u.s.user = 0;
+			estack_ax(stack, top)->u.s.glob = NULL;
 			next_pc += sizeof(struct load_op) + strlen(insn->data) + 1;
 			PO;
 		}
 
+		OP(BYTECODE_OP_LOAD_STAR_GLOB_COMPILED):
+		{
+			struct load_star_glob_op *insn = (struct load_star_glob_op *) pc;
+			const struct strutils_star_glob *glob =
+				(const struct strutils_star_glob *) &bytecode->data[insn->index];
+
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax(stack, top)->u.s.str = &glob->data[glob->pattern_offset];
+			estack_ax(stack, top)->u.s.seq_len = LTTNG_SIZE_MAX;
+			estack_ax(stack, top)->u.s.literal_type =
+				ESTACK_STRING_LITERAL_TYPE_STAR_GLOB;
+			estack_ax(stack, top)->u.s.user = 0;
+			estack_ax(stack, top)->u.s.glob = glob;
+			next_pc += insn->len;
+			PO;
+		}
+
 		OP(BYTECODE_OP_LOAD_S64):
 		{
 			struct load_op *insn = (struct load_op *) pc;
@@ -1914,6 +2068,129 @@ int lttng_bytecode_interpret(struct lttng_kernel_bytecode_runtime *kernel_byteco
 			PO;
 		}
 
+		/* set membership */
+		OP(BYTECODE_OP_IN_SET_S64):
+		{
+			struct set_op *insn = (struct set_op *) pc;
+
+			estack_ax_v = set_s64_lookup(insn, estack_ax_v);
+			estack_ax_t = REG_S64;
+			next_pc += sizeof(struct set_op) + insn->len;
+			PO;
+		}
+
+		OP(BYTECODE_OP_IN_SET_STRING):
+			printk(KERN_WARNING "LTTng: bytecode: unsupported non-specialized bytecode op %u\n",
+				(unsigned int) *(bytecode_opcode_t *) pc);
+			ret = -EINVAL;
+			goto end;
+
+		OP(BYTECODE_OP_IN_SET_STRING_INDEX):
+		{
+			struct set_index_op *insn = (struct set_index_op *) pc;
+			const struct bytecode_string_set *set =
+				(const struct bytecode_string_set *) &bytecode->data[insn->index];
+
+			estack_ax_v = set_string_lookup(set, estack_ax(stack, top));
+			estack_ax_t = REG_S64;
+			next_pc += sizeof(struct set_index_op) + insn->len;
+			PO;
+		}
+
+		/*
+		 * Superinstructions: the load of a field followed by the
+		 * load of an immediate operand and a comparison.
+		 */
+		OP(BYTECODE_OP_LOAD_PAYLOAD_CMP_S64):
+		{
+			struct load_cmp_s64_op *insn = (struct load_cmp_s64_op *) pc;
+			int64_t v;
+
+			v = ((struct literal_numeric *) &interpreter_stack_data[insn->index])->v;
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax_v = superinsn_cmp_s64(insn->cmp, v, insn->v);
+			estack_ax_t = REG_S64;
+			next_pc += insn->len;
+			PO;
+		}
+
+		OP(BYTECODE_OP_LOAD_CONTEXT_CMP_S64):
+		{
+			struct load_cmp_s64_op *insn = (struct load_cmp_s64_op *) pc;
+			int64_t v;
+
+			v = superinsn_get_context_s64(lttng_probe_ctx, insn->index);
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax_v = superinsn_cmp_s64(insn->cmp, v, insn->v);
+			estack_ax_t = REG_S64;
+			next_pc += insn->len;
+			PO;
+		}
+
+		OP(BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING):
+		OP(BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING):
+		{
+			struct load_cmp_glob_op *insn = (struct load_cmp_glob_op *) pc;
+			const char *str;
+
+			if (insn->op == BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING)
+				str = *(const char * const *) &interpreter_stack_data[insn->index];
+			else
+				str = superinsn_get_context_string(lttng_probe_ctx, insn->index);
+			if (unlikely(!str)) {
+				dbg_printk("Bytecode warning: loading a NULL string.\n");
+				ret = -EINVAL;
+				goto end;
+			}
+			/* Fused fields are kernel strings. */
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax_v = strutils_star_glob_compiled_match(
+				(const struct strutils_star_glob *) &bytecode->data[insn->glob],
+				str, LTTNG_SIZE_MAX);
+			estack_ax_t = REG_S64;
+			next_pc += insn->len;
+			PO;
+		}
+
+		OP(BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING):
+		OP(BYTECODE_OP_LOAD_CONTEXT_EQ_STRING):
+		{
+			struct load_cmp_string_op *insn = (struct load_cmp_string_op *) pc;
+			const char *str;
+			int res;
+
+			if (insn->op == BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING)
+				str = *(const char * const *) &interpreter_stack_data[insn->index];
+			else
+				str = superinsn_get_context_string(lttng_probe_ctx, insn->index);
+			if (unlikely(!str)) {
+				dbg_printk("Bytecode warning: loading a NULL string.\n");
+				ret = -EINVAL;
+				goto end;
+			}
+			/* Field, in bx. */
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax(stack, top)->u.s.str = str;
+			estack_ax(stack, top)->u.s.seq_len = LTTNG_SIZE_MAX;
+			estack_ax(stack, top)->u.s.literal_type =
+				ESTACK_STRING_LITERAL_TYPE_NONE;
+			estack_ax(stack, top)->u.s.user = 0;
+			estack_ax(stack, top)->type = REG_STRING;
+			/* Literal, in ax. */
+			estack_push(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax(stack, top)->u.s.str = insn->data;
+			estack_ax(stack, top)->u.s.seq_len = LTTNG_SIZE_MAX;
+			estack_ax(stack, top)->u.s.literal_type =
+				ESTACK_STRING_LITERAL_TYPE_PLAIN;
+			estack_ax(stack, top)->u.s.user = 0;
+			res = (stack_strcmp(stack, top, "==") == 0);
+			estack_pop(stack, top, ax, bx, ax_t, bx_t);
+			estack_ax_v = res;
+			estack_ax_t = REG_S64;
+			next_pc += insn->len;
+			PO;
+		}
+
 	END_OP
 end:
 	/* No need to prepare output if an error occurred. */
@@ -1950,16 +2227,20 @@ LTTNG_STACK_FRAME_NON_STANDARD(lttng_bytecode_interpret);
 /*
  * Return LTTNG_KERNEL_EVENT_FILTER_ACCEPT or LTTNG_KERNEL_EVENT_FILTER_REJECT.
  */
-int lttng_kernel_interpret_event_filter(const struct lttng_kernel_event_common *event,
+static
+int __lttng_kernel_interpret_event_filter(const struct lttng_kernel_event_common *event,
 		const char *interpreter_stack_data,
-		struct lttng_kernel_probe_ctx *probe_ctx,
-		void *event_filter_ctx __attribute__((unused)))
+		struct lttng_kernel_probe_ctx *probe_ctx)
 {
 	struct lttng_kernel_bytecode_runtime *filter_bc_runtime;
 	struct list_head *filter_bytecode_runtime_head = &event->priv->filter_bytecode_runtime_head;
 	struct lttng_kernel_bytecode_filter_ctx bytecode_filter_ctx;
+	struct bytecode_merged *merged;
 	bool filter_record = false;
 
+	merged = lttng_rcu_dereference(event->priv->filter_merged);
+	if (merged)
+		return lttng_bytecode_interpret_merged(merged, interpreter_stack_data, probe_ctx);
 	list_for_each_entry_rcu(filter_bc_runtime, filter_bytecode_runtime_head, node) {
 		if (likely(filter_bc_runtime->interpreter_func(filter_bc_runtime,
 				interpreter_stack_data, probe_ctx, &bytecode_filter_ctx) == LTTNG_KERNEL_BYTECODE_INTERPRETER_OK)) {
@@ -1975,6 +2256,36 @@ int lttng_kernel_interpret_event_filter(const struct lttng_kernel_event_common *
 		return LTTNG_KERNEL_EVENT_FILTER_REJECT;
 }
 
+/*
+ * Evaluate the filters of an event recorder or event notifier, keeping
+ * per-CPU statistics of the evaluations. The evaluation cost is only
+ * measured once every LTTNG_KERNEL_FILTER_STATS_SAMPLE_PERIOD
+ * evaluations to keep the cycle counter reads off the common path.
+ */
+int lttng_kernel_interpret_event_filter(const struct lttng_kernel_event_common *event,
+		const char *interpreter_stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		void *event_filter_ctx __attribute__((unused)))
+{
+	struct lttng_kernel_event_filter_stats __percpu *stats = event->priv->filter_stats;
+	cycles_t start = 0;
+	bool sample;
+	int ret;
+
+	sample = !(this_cpu_inc_return(stats->evaluations)
+			& (LTTNG_KERNEL_FILTER_STATS_SAMPLE_PERIOD - 1));
+	if (unlikely(sample))
+		start = get_cycles();
+	ret = __lttng_kernel_interpret_event_filter(event, interpreter_stack_data, probe_ctx);
+	if (unlikely(sample)) {
+		this_cpu_add(stats->sampled_cycles, get_cycles() - start);
+		this_cpu_inc(stats->sampled_evaluations);
+	}
+	if (ret == LTTNG_KERNEL_EVENT_FILTER_ACCEPT)
+		this_cpu_inc(stats->accepts);
+	return ret;
+}
+
 #undef START_OP
 #undef OP
 #undef PO
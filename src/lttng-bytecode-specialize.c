@@ -8,7 +8,9 @@
  */
 
 #include <linux/slab.h>
+#include <linux/sort.h>
 #include <wrapper/compiler_attributes.h>
+#include <wrapper/unaligned.h>
 
 #include <lttng/lttng-bytecode.h>
 #include <lttng/align.h>
@@ -57,6 +59,105 @@ static ssize_t bytecode_push_data(struct bytecode_runtime *runtime,
 	return offset;
 }
 
+static int set_s64_cmp(const void *a, const void *b)
+{
+	int64_t va = get_unaligned((const int64_t *) a);
+	int64_t vb = get_unaligned((const int64_t *) b);
+
+	if (va < vb)
+		return -1;
+	if (va > vb)
+		return 1;
+	return 0;
+}
+
+static void set_s64_swap(void *a, void *b, int size)
+{
+	int64_t tmp = get_unaligned((int64_t *) a);
+
+	put_unaligned(get_unaligned((int64_t *) b), (int64_t *) a);
+	put_unaligned(tmp, (int64_t *) b);
+}
+
+static int set_string_cmp(const void *a, const void *b)
+{
+	return strcmp(*(const char * const *) a, *(const char * const *) b);
+}
+
+/*
+ * Sort the elements of a set for lookups with a binary search. Integer
+ * sets are sorted in place. String sets are indexed by an array of
+ * sorted strings in the runtime data, and turned into
+ * IN_SET_STRING_INDEX.
+ */
+static int specialize_set(struct bytecode_runtime *runtime,
+		struct set_op *insn)
+{
+	struct bytecode_string_set *set;
+	ssize_t data_offset;
+	const char *str;
+	unsigned int i;
+
+	switch (insn->op) {
+	case BYTECODE_OP_IN_SET_S64:
+		sort(insn->data, insn->nr_elem, sizeof(int64_t),
+			set_s64_cmp, set_s64_swap);
+		return 0;
+	case BYTECODE_OP_IN_SET_STRING:
+		break;
+	default:
+		return -EINVAL;
+	}
+	data_offset = bytecode_reserve_data(runtime, __alignof__(*set),
+		sizeof(*set) + insn->nr_elem * sizeof(set->elem[0]));
+	if (data_offset < 0)
+		return -EINVAL;
+	if (data_offset > U16_MAX)
+		return -EINVAL;
+	set = (struct bytecode_string_set *) &runtime->data[data_offset];
+	set->nr_elem = insn->nr_elem;
+	/* The validator checked the strings are within the op data. */
+	for (i = 0, str = insn->data; i < insn->nr_elem; i++) {
+		set->elem[i] = str;
+		str += strlen(str) + 1;
+	}
+	sort(set->elem, set->nr_elem, sizeof(set->elem[0]),
+		set_string_cmp, NULL);
+	insn->op = BYTECODE_OP_IN_SET_STRING_INDEX;
+	((struct set_index_op *) insn)->index = data_offset;
+	return 0;
+}
+
+/*
+ * Compile a star globbing pattern into the runtime data, and turn its
+ * load into LOAD_STAR_GLOB_COMPILED. Patterns whose load is too short
+ * to be replaced in place, or which cannot be compiled, are left to the
+ * generic matching function.
+ */
+static int specialize_star_glob(struct bytecode_runtime *runtime,
+		struct load_op *insn, size_t insn_len)
+{
+	struct load_star_glob_op *glob_insn = (struct load_star_glob_op *) insn;
+	struct strutils_star_glob *glob;
+	ssize_t data_offset;
+
+	if (insn_len < sizeof(*glob_insn) || insn_len > U16_MAX)
+		return 0;
+	data_offset = bytecode_reserve_data(runtime, __alignof__(*glob),
+		strutils_star_glob_compiled_len(insn->data));
+	if (data_offset == -ENOMEM)
+		return -ENOMEM;
+	if (data_offset < 0 || data_offset > U16_MAX)
+		return 0;
+	glob = (struct strutils_star_glob *) &runtime->data[data_offset];
+	if (strutils_star_glob_compile(insn->data, glob))
+		return 0;
+	glob_insn->op = BYTECODE_OP_LOAD_STAR_GLOB_COMPILED;
+	glob_insn->index = data_offset;
+	glob_insn->len = insn_len;
+	return 0;
+}
+
 static int specialize_load_field(struct vstack_entry *stack_top,
 		struct load_op *insn)
 {
@@ -480,7 +581,7 @@ static int specialize_payload_lookup(const struct lttng_kernel_event_desc *event
 {
 	const char *name;
 	uint16_t offset;
-	unsigned int i, nr_fields;
+	unsigned int i, nr_fields, field_idx = 0;
 	bool found = false;
 	uint32_t field_offset = 0;
 	const struct lttng_kernel_event_field *field;
@@ -500,6 +601,7 @@ static int specialize_payload_lookup(const struct lttng_kernel_event_desc *event
 			found = true;
 			break;
 		}
+		field_idx++;
 		/* compute field offset on stack */
 		switch (field->type->type) {
 		case lttng_kernel_type_integer:
@@ -543,11 +645,173 @@ static int specialize_payload_lookup(const struct lttng_kernel_event_desc *event
 		goto end;
 	}
 	((struct get_index_u16 *) insn->data)->index = data_offset;
+	runtime->p.filter_fields |= LTTNG_KERNEL_EVENT_FILTER_FIELD_BIT(field_idx);
 	ret = 0;
 end:
 	return ret;
 }
 
+/*
+ * Longest sequence fused into a superinstruction: get root, get index,
+ * load field, load immediate, compare.
+ */
+#define FUSE_HISTORY_LEN	5
+
+/*
+ * Peephole fusion of the load of a field, followed by the load of an
+ * immediate operand and a comparison, into a single superinstruction.
+ * @insn_pc holds the start of the last specialized instructions, the
+ * last one being the comparison. @targets holds the logical operator
+ * jump targets seen so far: jumps only go forward, so no other jump can
+ * land within the fused instructions. Returns whether the instructions
+ * were fused.
+ */
+static
+bool specialize_fuse(struct bytecode_runtime *runtime, char **insn_pc,
+		const unsigned long *targets)
+{
+	char *start_pc = runtime->code;
+	char *cmp_pc = insn_pc[FUSE_HISTORY_LEN - 1];
+	char *imm_pc = insn_pc[FUSE_HISTORY_LEN - 2];
+	char *field_pc = insn_pc[FUSE_HISTORY_LEN - 3];
+	char *fuse_pc;
+	bytecode_opcode_t cmp, imm_op, op;
+	bool is_s64, context;
+	uint64_t index;
+	size_t len;
+
+	if (!cmp_pc || !imm_pc || !field_pc)
+		return false;
+	cmp = *(bytecode_opcode_t *) cmp_pc;
+	switch (cmp) {
+	case BYTECODE_OP_EQ_S64:
+	case BYTECODE_OP_NE_S64:
+	case BYTECODE_OP_GT_S64:
+	case BYTECODE_OP_LT_S64:
+	case BYTECODE_OP_GE_S64:
+	case BYTECODE_OP_LE_S64:
+		imm_op = BYTECODE_OP_LOAD_S64;
+		is_s64 = true;
+		break;
+	case BYTECODE_OP_EQ_STRING:
+		imm_op = BYTECODE_OP_LOAD_STRING;
+		is_s64 = false;
+		break;
+	case BYTECODE_OP_EQ_STAR_GLOB_STRING:
+		/* Only compiled patterns are fused. */
+		imm_op = BYTECODE_OP_LOAD_STAR_GLOB_COMPILED;
+		is_s64 = false;
+		break;
+	default:
+		return false;
+	}
+	if (*(bytecode_opcode_t *) imm_pc != imm_op)
+		return false;
+
+	switch (*(bytecode_opcode_t *) field_pc) {
+	case BYTECODE_OP_LOAD_FIELD_REF_S64:
+	case BYTECODE_OP_LOAD_FIELD_REF_STRING:
+	case BYTECODE_OP_GET_CONTEXT_REF_S64:
+	case BYTECODE_OP_GET_CONTEXT_REF_STRING:
+	{
+		struct load_op *insn = (struct load_op *) field_pc;
+
+		if (is_s64 != (insn->op == BYTECODE_OP_LOAD_FIELD_REF_S64
+				|| insn->op == BYTECODE_OP_GET_CONTEXT_REF_S64))
+			return false;
+		context = insn->op == BYTECODE_OP_GET_CONTEXT_REF_S64
+			|| insn->op == BYTECODE_OP_GET_CONTEXT_REF_STRING;
+		index = ((struct field_ref *) insn->data)->offset;
+		fuse_pc = field_pc;
+		break;
+	}
+	case BYTECODE_OP_LOAD_FIELD_S64:
+	case BYTECODE_OP_LOAD_FIELD_U64:
+	case BYTECODE_OP_LOAD_FIELD_STRING:
+	{
+		char *index_pc = insn_pc[FUSE_HISTORY_LEN - 4];
+		char *root_pc = insn_pc[FUSE_HISTORY_LEN - 5];
+		const struct bytecode_get_index_data *gid;
+		struct load_op *insn;
+
+		if (is_s64 == (*(bytecode_opcode_t *) field_pc == BYTECODE_OP_LOAD_FIELD_STRING))
+			return false;
+		if (!index_pc || !root_pc
+				|| *(bytecode_opcode_t *) index_pc != BYTECODE_OP_GET_INDEX_U16)
+			return false;
+		insn = (struct load_op *) index_pc;
+		gid = (const struct bytecode_get_index_data *)
+			&runtime->data[((struct get_index_u16 *) insn->data)->index];
+		/* User-space strings and byte-swapped integers are not fused. */
+		if (gid->elem.user || gid->elem.rev_bo)
+			return false;
+		switch (*(bytecode_opcode_t *) root_pc) {
+		case BYTECODE_OP_GET_PAYLOAD_ROOT:
+			context = false;
+			index = gid->offset;
+			break;
+		case BYTECODE_OP_GET_CONTEXT_ROOT:
+			context = true;
+			index = gid->ctx_index;
+			break;
+		default:
+			return false;
+		}
+		fuse_pc = root_pc;
+		break;
+	}
+	default:
+		return false;
+	}
+	if (index > U16_MAX)
+		return false;
+	/* No jump may land within the fused instructions. */
+	if (find_next_bit(targets, cmp_pc - start_pc + 1, fuse_pc - start_pc + 1)
+			<= cmp_pc - start_pc)
+		return false;
+	len = cmp_pc + sizeof(struct binary_op) - fuse_pc;
+
+	if (is_s64) {
+		struct load_cmp_s64_op insn;
+
+		op = context ? BYTECODE_OP_LOAD_CONTEXT_CMP_S64 :
+			BYTECODE_OP_LOAD_PAYLOAD_CMP_S64;
+		insn.op = op;
+		insn.cmp = cmp;
+		insn.len = len;
+		insn.index = index;
+		insn.v = ((struct literal_numeric *) ((struct load_op *) imm_pc)->data)->v;
+		memcpy(fuse_pc, &insn, sizeof(insn));
+	} else if (cmp == BYTECODE_OP_EQ_STAR_GLOB_STRING) {
+		struct load_cmp_glob_op insn;
+
+		if (len > U16_MAX)
+			return false;
+		op = context ? BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING :
+			BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING;
+		insn.op = op;
+		insn.index = index;
+		insn.len = len;
+		insn.glob = ((struct load_star_glob_op *) imm_pc)->index;
+		memcpy(fuse_pc, &insn, sizeof(insn));
+	} else {
+		struct load_cmp_string_op *insn = (struct load_cmp_string_op *) fuse_pc;
+		const char *str = ((struct load_op *) imm_pc)->data;
+
+		if (len > U16_MAX)
+			return false;
+		op = context ? BYTECODE_OP_LOAD_CONTEXT_EQ_STRING :
+			BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING;
+		/* The literal may overlap the superinstruction header. */
+		memmove(insn->data, str, strlen(str) + 1);
+		insn->op = op;
+		insn->index = index;
+		insn->len = len;
+	}
+	dbg_printk("Fused %zu bytes into %s\n", len, lttng_bytecode_print_op(op));
+	return true;
+}
+
 int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 		struct bytecode_runtime *bytecode)
 {
@@ -556,12 +820,23 @@ int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 	struct vstack _stack;
 	struct vstack *stack = &_stack;
 	struct lttng_kernel_ctx *ctx = bytecode->p.ctx;
+	char *insn_pc[FUSE_HISTORY_LEN] = { NULL };
+	unsigned long *targets;
 
 	vstack_init(stack);
 
+	targets = kcalloc(BITS_TO_LONGS(bytecode->len + 1),
+			sizeof(unsigned long), GFP_KERNEL);
+	if (!targets)
+		return -ENOMEM;
+
 	start_pc = &bytecode->code[0];
 	for (pc = next_pc = start_pc; pc - start_pc < bytecode->len;
 			pc = next_pc) {
+		memmove(insn_pc, insn_pc + 1,
+			(FUSE_HISTORY_LEN - 1) * sizeof(insn_pc[0]));
+		insn_pc[FUSE_HISTORY_LEN - 1] = pc;
+
 		switch (*(bytecode_opcode_t *) pc) {
 		case BYTECODE_OP_UNKNOWN:
 		default:
@@ -946,6 +1221,40 @@ int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 			break;
 		}
 
+		/* set membership */
+		case BYTECODE_OP_IN_SET_S64:
+		case BYTECODE_OP_IN_SET_STRING:
+		{
+			struct set_op *insn = (struct set_op *) pc;
+			bool type_ok;
+
+			switch (vstack_ax(stack)->type) {
+			case REG_S64:
+			case REG_U64:
+				type_ok = insn->op == BYTECODE_OP_IN_SET_S64;
+				break;
+			case REG_STRING:
+				type_ok = insn->op == BYTECODE_OP_IN_SET_STRING;
+				break;
+			default:
+				type_ok = false;
+				break;
+			}
+			if (!type_ok) {
+				printk(KERN_WARNING "LTTng: bytecode: Set element type does not match register type %d\n",
+					(int) vstack_ax(stack)->type);
+				ret = -EINVAL;
+				goto end;
+			}
+			next_pc += sizeof(struct set_op) + insn->len;
+			ret = specialize_set(bytecode, insn);
+			if (ret)
+				goto end;
+			/* Pop 1, push 1 */
+			vstack_ax(stack)->type = REG_S64;
+			break;
+		}
+
 		case BYTECODE_OP_UNARY_PLUS_S64:
 		case BYTECODE_OP_UNARY_MINUS_S64:
 		case BYTECODE_OP_UNARY_NOT_S64:
@@ -962,6 +1271,11 @@ int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 		case BYTECODE_OP_AND:
 		case BYTECODE_OP_OR:
 		{
+			struct logical_op *insn = (struct logical_op *) pc;
+
+			/* Keep track of jump targets for superinstructions. */
+			if (insn->skip_offset <= bytecode->len)
+				set_bit(insn->skip_offset, targets);
 			/* Continue to next instruction */
 			/* Pop 1 when jump not taken */
 			if (vstack_pop(stack)) {
@@ -1040,13 +1354,17 @@ int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 		case BYTECODE_OP_LOAD_STAR_GLOB_STRING:
 		{
 			struct load_op *insn = (struct load_op *) pc;
+			size_t insn_len = sizeof(struct load_op) + strlen(insn->data) + 1;
 
 			if (vstack_push(stack)) {
 				ret = -EINVAL;
 				goto end;
 			}
 			vstack_ax(stack)->type = REG_STAR_GLOB_STRING;
-			next_pc += sizeof(struct load_op) + strlen(insn->data) + 1;
+			ret = specialize_star_glob(bytecode, insn, insn_len);
+			if (ret)
+				goto end;
+			next_pc += insn_len;
 			break;
 		}
 
@@ -1269,7 +1587,11 @@ int lttng_bytecode_specialize(const struct lttng_kernel_event_desc *event_desc,
 		}
 
 		}
+		/* The fused instructions are not part of the history anymore. */
+		if (specialize_fuse(bytecode, insn_pc, targets))
+			memset(insn_pc, 0, sizeof(insn_pc));
 	}
 end:
+	kfree(targets);
 	return ret;
 }
@@ -7,15 +7,24 @@
  * Copyright (C) 2010-2016 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
  */
 
+#include <linux/module.h>
 #include <linux/types.h>
 #include <linux/jhash.h>
 #include <linux/slab.h>
+#include <linux/log2.h>
 
 #include <wrapper/list.h>
+#include <wrapper/vmalloc.h>
 #include <lttng/lttng-bytecode.h>
 
-#define MERGE_POINT_TABLE_BITS		7
-#define MERGE_POINT_TABLE_SIZE		(1U << MERGE_POINT_TABLE_BITS)
+#define MERGE_POINT_TABLE_MIN_BITS	7
+/*
+ * The merge point table is sized to the bytecode: each merge point is
+ * the target of a logical operator, which follows at least the load of
+ * an operand. This bounds the average number of merge points per bucket
+ * so validation stays linear in the bytecode length.
+ */
+#define MERGE_POINT_BYTES_PER_BUCKET	16
 
 /* merge point table node */
 struct mp_node {
@@ -27,9 +36,36 @@ struct mp_node {
 };
 
 struct mp_table {
-	struct hlist_head mp_head[MERGE_POINT_TABLE_SIZE];
+	unsigned int bits;
+	unsigned long nr_nodes;		/* Pending merge points */
+	struct hlist_head mp_head[];
 };
 
+static
+struct mp_table *mp_table_create(size_t bytecode_len)
+{
+	struct mp_table *mp_table;
+	unsigned int bits;
+
+	bits = max_t(unsigned int, MERGE_POINT_TABLE_MIN_BITS,
+		order_base_2(bytecode_len / MERGE_POINT_BYTES_PER_BUCKET + 1));
+	mp_table = lttng_kvzalloc(sizeof(*mp_table)
+			+ (sizeof(struct hlist_head) << bits), GFP_KERNEL);
+	if (!mp_table)
+		return NULL;
+	mp_table->bits = bits;
+	return mp_table;
+}
+
+static
+struct hlist_head *mp_table_head(struct mp_table *mp_table,
+		unsigned long target_pc)
+{
+	unsigned long hash = jhash_1word(target_pc, 0);
+
+	return &mp_table->mp_head[hash & ((1UL << mp_table->bits) - 1)];
+}
+
 static
 int lttng_hash_match(struct mp_node *mp_node, unsigned long key_pc)
 {
@@ -61,39 +97,31 @@ int merge_point_add_check(struct mp_table *mp_table, unsigned long target_pc,
 		const struct vstack *stack)
 {
 	struct mp_node *mp_node;
-	unsigned long hash = jhash_1word(target_pc, 0);
 	struct hlist_head *head;
 	struct mp_node *lookup_node;
-	int found = 0;
 
-	dbg_printk("Bytecode: adding merge point at offset %lu, hash %lu\n",
-			target_pc, hash);
-	mp_node = kzalloc(sizeof(struct mp_node), GFP_KERNEL);
-	if (!mp_node)
-		return -ENOMEM;
-	mp_node->target_pc = target_pc;
-	memcpy(&mp_node->stack, stack, sizeof(mp_node->stack));
-
-	head = &mp_table->mp_head[hash & (MERGE_POINT_TABLE_SIZE - 1)];
+	dbg_printk("Bytecode: adding merge point at offset %lu\n", target_pc);
+	head = mp_table_head(mp_table, target_pc);
 	lttng_hlist_for_each_entry(lookup_node, head, node) {
 		if (lttng_hash_match(lookup_node, target_pc)) {
-			found = 1;
-			break;
-		}
-	}
-	if (found) {
-		/* Key already present */
-		dbg_printk("Bytecode: compare merge points for offset %lu, hash %lu\n",
-				target_pc, hash);
-		kfree(mp_node);
-		if (merge_points_compare(stack, &lookup_node->stack)) {
-			printk(KERN_WARNING "LTTng: bytecode: Merge points differ for offset %lu\n",
-				target_pc);
-			return -EINVAL;
+			/* Key already present */
+			dbg_printk("Bytecode: compare merge points for offset %lu\n",
+					target_pc);
+			if (merge_points_compare(stack, &lookup_node->stack)) {
+				printk(KERN_WARNING "LTTng: bytecode: Merge points differ for offset %lu\n",
+					target_pc);
+				return -EINVAL;
+			}
+			return 0;
 		}
-	} else {
-		hlist_add_head(&mp_node->node, head);
 	}
+	mp_node = kmalloc(sizeof(struct mp_node), GFP_KERNEL);
+	if (!mp_node)
+		return -ENOMEM;
+	mp_node->target_pc = target_pc;
+	memcpy(&mp_node->stack, stack, sizeof(mp_node->stack));
+	hlist_add_head(&mp_node->node, head);
+	mp_table->nr_nodes++;
 	return 0;
 }
 
@@ -271,6 +299,52 @@ int validate_get_symbol(struct bytecode_runtime *bytecode,
 	return 0;
 }
 
+/*
+ * Validate the bounds of a set membership instruction and the layout of
+ * its elements.
+ */
+static
+int validate_set_op(struct bytecode_runtime *bytecode,
+		char *start_pc, char *pc)
+{
+	struct set_op *insn = (struct set_op *) pc;
+	const char *str, *end;
+	unsigned int i;
+
+	if (unlikely(pc + sizeof(struct set_op) > start_pc + bytecode->len))
+		return -ERANGE;
+	if (unlikely(pc + sizeof(struct set_op) + insn->len
+			> start_pc + bytecode->len))
+		return -ERANGE;
+	switch (insn->op) {
+	case BYTECODE_OP_IN_SET_S64:
+		if (insn->len != insn->nr_elem * sizeof(int64_t)) {
+			printk(KERN_WARNING "LTTng: bytecode: invalid integer set length\n");
+			return -EINVAL;
+		}
+		break;
+	case BYTECODE_OP_IN_SET_STRING:
+		str = insn->data;
+		end = insn->data + insn->len;
+		for (i = 0; i < insn->nr_elem; i++) {
+			size_t len = strnlen(str, end - str);
+
+			/* Final '\0' not found within range */
+			if (unlikely(len == end - str))
+				return -ERANGE;
+			str += len + 1;
+		}
+		if (str != end) {
+			printk(KERN_WARNING "LTTng: bytecode: invalid string set length\n");
+			return -EINVAL;
+		}
+		break;
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
 /*
  * Validate bytecode range overflow within the validation pass.
  * Called for each instruction encountered.
@@ -291,6 +365,22 @@ int bytecode_validate_overflow(struct bytecode_runtime *bytecode,
 		break;
 	}
 
+	/* Superinstructions are only generated by the specializer. */
+	case BYTECODE_OP_LOAD_PAYLOAD_CMP_S64:
+	case BYTECODE_OP_LOAD_CONTEXT_CMP_S64:
+	case BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING:
+	case BYTECODE_OP_LOAD_CONTEXT_EQ_STRING:
+	case BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING:
+	case BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING:
+	case BYTECODE_OP_IN_SET_STRING_INDEX:
+	case BYTECODE_OP_LOAD_STAR_GLOB_COMPILED:
+	{
+		printk(KERN_WARNING "LTTng: bytecode: specializer-only op %u\n",
+			(unsigned int) *(bytecode_opcode_t *) pc);
+		ret = -EINVAL;
+		break;
+	}
+
 	case BYTECODE_OP_RETURN:
 	case BYTECODE_OP_RETURN_S64:
 	{
@@ -400,6 +490,14 @@ int bytecode_validate_overflow(struct bytecode_runtime *bytecode,
 		break;
 	}
 
+	/* set membership */
+	case BYTECODE_OP_IN_SET_S64:
+	case BYTECODE_OP_IN_SET_STRING:
+	{
+		ret = validate_set_op(bytecode, start_pc, pc);
+		break;
+	}
+
 	/* load field and get context ref */
 	case BYTECODE_OP_LOAD_FIELD_REF:
 	case BYTECODE_OP_GET_CONTEXT_REF:
@@ -526,9 +624,9 @@ unsigned long delete_all_nodes(struct mp_table *mp_table)
 	struct mp_node *mp_node;
 	struct hlist_node *tmp;
 	unsigned long nr_nodes = 0;
-	int i;
+	unsigned int i;
 
-	for (i = 0; i < MERGE_POINT_TABLE_SIZE; i++) {
+	for (i = 0; i < (1U << mp_table->bits); i++) {
 		struct hlist_head *head;
 
 		head = &mp_table->mp_head[i];
@@ -779,6 +877,36 @@ int validate_instruction_context(struct bytecode_runtime *bytecode,
 		}
 		break;
 	}
+	/* set membership */
+	case BYTECODE_OP_IN_SET_S64:
+	case BYTECODE_OP_IN_SET_STRING:
+	{
+		if (!vstack_ax(stack)) {
+			printk(KERN_WARNING "LTTng: bytecode: Empty stack\n");
+			ret = -EINVAL;
+			goto end;
+		}
+		switch (vstack_ax(stack)->type) {
+		case REG_S64:
+		case REG_U64:
+			if (opcode == BYTECODE_OP_IN_SET_S64)
+				goto end;
+			break;
+		case REG_STRING:
+			if (opcode == BYTECODE_OP_IN_SET_STRING)
+				goto end;
+			break;
+		case REG_TYPE_UNKNOWN:
+			goto end;
+		default:
+			break;
+		}
+		printk(KERN_WARNING "LTTng: bytecode: Set element type does not match register type %d\n",
+			(int) vstack_ax(stack)->type);
+		ret = -EINVAL;
+		goto end;
+	}
+
 	case BYTECODE_OP_UNARY_BIT_NOT:
 	{
 		if (!vstack_ax(stack)) {
@@ -1066,7 +1194,6 @@ int validate_instruction_all_contexts(struct bytecode_runtime *bytecode,
 {
 	int ret, found = 0;
 	unsigned long target_pc = pc - start_pc;
-	unsigned long hash;
 	struct hlist_head *head;
 	struct mp_node *mp_node;
 
@@ -1076,8 +1203,9 @@ int validate_instruction_all_contexts(struct bytecode_runtime *bytecode,
 		return ret;
 
 	/* Validate merge points */
-	hash = jhash_1word(target_pc, 0);
-	head = &mp_table->mp_head[hash & (MERGE_POINT_TABLE_SIZE - 1)];
+	if (!mp_table->nr_nodes)
+		return 0;
+	head = mp_table_head(mp_table, target_pc);
 	lttng_hlist_for_each_entry(mp_node, head, node) {
 		if (lttng_hash_match(mp_node, target_pc)) {
 			found = 1;
@@ -1096,6 +1224,8 @@ int validate_instruction_all_contexts(struct bytecode_runtime *bytecode,
 		dbg_printk("Bytecode: remove merge point at offset %lu\n",
 				target_pc);
 		hlist_del(&mp_node->node);
+		kfree(mp_node);
+		mp_table->nr_nodes--;
 	}
 	return 0;
 }
@@ -1125,6 +1255,22 @@ int validate_load(char **_next_pc,
 		goto end;
 	}
 
+	/* Superinstructions are only generated by the specializer. */
+	case BYTECODE_OP_LOAD_PAYLOAD_CMP_S64:
+	case BYTECODE_OP_LOAD_CONTEXT_CMP_S64:
+	case BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING:
+	case BYTECODE_OP_LOAD_CONTEXT_EQ_STRING:
+	case BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING:
+	case BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING:
+	case BYTECODE_OP_IN_SET_STRING_INDEX:
+	case BYTECODE_OP_LOAD_STAR_GLOB_COMPILED:
+	{
+		printk(KERN_WARNING "LTTng: bytecode: specializer-only op %u\n",
+			(unsigned int) *(bytecode_opcode_t *) pc);
+		ret = -EINVAL;
+		goto end;
+	}
+
 	case BYTECODE_OP_RETURN:
 	{
 		next_pc += sizeof(struct return_op);
@@ -1227,6 +1373,16 @@ int validate_load(char **_next_pc,
 		break;
 	}
 
+	/* set membership */
+	case BYTECODE_OP_IN_SET_S64:
+	case BYTECODE_OP_IN_SET_STRING:
+	{
+		struct set_op *insn = (struct set_op *) pc;
+
+		next_pc += sizeof(struct set_op) + insn->len;
+		break;
+	}
+
 	/* load field ref */
 	case BYTECODE_OP_LOAD_FIELD_REF:
 	/* get context ref */
@@ -1605,6 +1761,23 @@ int exec_insn(struct bytecode_runtime *bytecode,
 		break;
 	}
 
+	/* set membership */
+	case BYTECODE_OP_IN_SET_S64:
+	case BYTECODE_OP_IN_SET_STRING:
+	{
+		struct set_op *insn = (struct set_op *) pc;
+
+		/* Pop 1, push 1 */
+		if (!vstack_ax(stack)) {
+			printk(KERN_WARNING "LTTng: bytecode: Empty stack\n");
+			ret = -EINVAL;
+			goto end;
+		}
+		vstack_ax(stack)->type = REG_S64;
+		next_pc += sizeof(struct set_op) + insn->len;
+		break;
+	}
+
 	case BYTECODE_OP_UNARY_BIT_NOT:
 	{
 		/* Pop 1, push 1 */
@@ -1989,7 +2162,7 @@ int lttng_bytecode_validate(struct bytecode_runtime *bytecode)
 
 	vstack_init(&stack);
 
-	mp_table = kzalloc(sizeof(*mp_table), GFP_KERNEL);
+	mp_table = mp_table_create(bytecode->len);
 	if (!mp_table) {
 		printk(KERN_WARNING "LTTng: bytecode: Error allocating hash table for bytecode validation\n");
 		return -ENOMEM;
@@ -2027,6 +2200,7 @@ end:
 			ret = -EINVAL;
 		}
 	}
-	kfree(mp_table);
+	lttng_kvfree(mp_table);
 	return ret;
 }
+EXPORT_SYMBOL_GPL(lttng_bytecode_validate);
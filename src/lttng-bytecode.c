@@ -157,6 +157,20 @@ static const char *opnames[] = {
 	[ BYTECODE_OP_UNARY_BIT_NOT ] = "UNARY_BIT_NOT",
 
 	[ BYTECODE_OP_RETURN_S64 ] = "RETURN_S64",
+
+	/* set membership */
+	[ BYTECODE_OP_IN_SET_S64 ] = "IN_SET_S64",
+	[ BYTECODE_OP_IN_SET_STRING ] = "IN_SET_STRING",
+
+	/* Superinstructions generated by the specializer. */
+	[ BYTECODE_OP_LOAD_PAYLOAD_CMP_S64 ] = "LOAD_PAYLOAD_CMP_S64",
+	[ BYTECODE_OP_LOAD_CONTEXT_CMP_S64 ] = "LOAD_CONTEXT_CMP_S64",
+	[ BYTECODE_OP_LOAD_PAYLOAD_EQ_STRING ] = "LOAD_PAYLOAD_EQ_STRING",
+	[ BYTECODE_OP_LOAD_CONTEXT_EQ_STRING ] = "LOAD_CONTEXT_EQ_STRING",
+	[ BYTECODE_OP_LOAD_PAYLOAD_EQ_STAR_GLOB_STRING ] = "LOAD_PAYLOAD_EQ_STAR_GLOB_STRING",
+	[ BYTECODE_OP_LOAD_CONTEXT_EQ_STAR_GLOB_STRING ] = "LOAD_CONTEXT_EQ_STAR_GLOB_STRING",
+	[ BYTECODE_OP_IN_SET_STRING_INDEX ] = "IN_SET_STRING_INDEX",
+	[ BYTECODE_OP_LOAD_STAR_GLOB_COMPILED ] = "LOAD_STAR_GLOB_COMPILED",
 };
 
 const char *lttng_bytecode_print_op(enum bytecode_op op)
@@ -176,7 +190,7 @@ int apply_field_reloc(const struct lttng_kernel_event_desc *event_desc,
 		enum bytecode_op bytecode_op)
 {
 	const struct lttng_kernel_event_field * const *fields, *field = NULL;
-	unsigned int nr_fields, i;
+	unsigned int nr_fields, i, field_idx = 0;
 	struct load_op *op;
 	uint32_t field_offset = 0;
 
@@ -196,6 +210,7 @@ int apply_field_reloc(const struct lttng_kernel_event_desc *event_desc,
 			field = fields[i];
 			break;
 		}
+		field_idx++;
 		/* compute field offset */
 		switch (fields[i]->type->type) {
 		case lttng_kernel_type_integer:
@@ -291,6 +306,7 @@ int apply_field_reloc(const struct lttng_kernel_event_desc *event_desc,
 		}
 		/* set offset */
 		field_ref->offset = (uint16_t) field_offset;
+		runtime->p.filter_fields |= LTTNG_KERNEL_EVENT_FILTER_FIELD_BIT(field_idx);
 		break;
 	}
 	default:
@@ -436,6 +452,15 @@ int bytecode_is_linked(struct lttng_kernel_bytecode_node *bytecode,
 	return 0;
 }
 
+static
+void bytecode_runtime_set_interpreter(struct bytecode_runtime *runtime)
+{
+	if (runtime->compiled)
+		runtime->p.interpreter_func = lttng_bytecode_interpret_compiled;
+	else
+		runtime->p.interpreter_func = lttng_bytecode_interpret;
+}
+
 /*
  * Take a bytecode with reloc table and link it to an event to create a
  * bytecode runtime.
@@ -444,6 +469,7 @@ static
 int link_bytecode(const struct lttng_kernel_event_desc *event_desc,
 		struct lttng_kernel_ctx *ctx,
 		struct lttng_kernel_bytecode_node *bytecode,
+		unsigned long *instance_filter_fields,
 		struct list_head *bytecode_runtime_head,
 		struct list_head *insert_loc)
 {
@@ -505,8 +531,23 @@ int link_bytecode(const struct lttng_kernel_event_desc *event_desc,
 	if (ret) {
 		goto link_error;
 	}
-	runtime->p.interpreter_func = lttng_bytecode_interpret;
+	/* Compile bytecode, falling back on the interpreter. */
+	ret = lttng_bytecode_compile(runtime);
+	if (ret == -EOPNOTSUPP)
+		dbg_printk("Bytecode not compiled, using interpreter.\n");
+	else if (ret)
+		goto link_error;
+	bytecode_runtime_set_interpreter(runtime);
 	runtime->p.link_failed = 0;
+	/*
+	 * The instance probe only prepares the fields loaded by its
+	 * bytecode programs: publish the new fields before the program.
+	 */
+	if ((*instance_filter_fields | runtime->p.filter_fields) != *instance_filter_fields) {
+		WRITE_ONCE(*instance_filter_fields,
+			*instance_filter_fields | runtime->p.filter_fields);
+		smp_wmb();
+	}
 	list_add_rcu(&runtime->p.node, insert_loc);
 	dbg_printk("Linking successful.\n");
 	return 0;
@@ -528,7 +569,8 @@ void lttng_bytecode_sync_state(struct lttng_kernel_bytecode_runtime *runtime)
 	if (!bc->enabler->enabled || runtime->link_failed)
 		runtime->interpreter_func = lttng_bytecode_interpret_error;
 	else
-		runtime->interpreter_func = lttng_bytecode_interpret;
+		bytecode_runtime_set_interpreter(
+			container_of(runtime, struct bytecode_runtime, p));
 }
 
 /*
@@ -541,6 +583,7 @@ void lttng_bytecode_sync_state(struct lttng_kernel_bytecode_runtime *runtime)
  */
 void lttng_enabler_link_bytecode(const struct lttng_kernel_event_desc *event_desc,
 		struct lttng_kernel_ctx *ctx,
+		unsigned long *instance_filter_fields,
 		struct list_head *instance_bytecode_head,
 		struct list_head *enabler_bytecode_head)
 {
@@ -589,7 +632,8 @@ void lttng_enabler_link_bytecode(const struct lttng_kernel_event_desc *event_des
 		insert_loc = instance_bytecode_head;
 	add_within:
 		dbg_printk("linking bytecode\n");
-		ret = link_bytecode(event_desc, ctx, enabler_bc, instance_bytecode_head, insert_loc);
+		ret = link_bytecode(event_desc, ctx, enabler_bc, instance_filter_fields,
+				instance_bytecode_head, insert_loc);
 		if (ret) {
 			dbg_printk("[lttng filter] warning: cannot link event bytecode\n");
 		}
@@ -602,7 +646,10 @@ void lttng_free_event_filter_runtime(struct lttng_kernel_event_common *event)
 
 	list_for_each_entry_safe(runtime, tmp,
 			&event->priv->filter_bytecode_runtime_head, p.node) {
+		kfree(runtime->compiled);
 		kfree(runtime->data);
 		kfree(runtime);
 	}
+	lttng_bytecode_merged_free(event->priv->filter_merged);
+	event->priv->filter_merged = NULL;
 }
@@ -59,6 +59,38 @@ static int counter_clear(struct lib_counter *counter, const size_t *dimension_in
 	return lttng_counter_clear(&client_config, counter, dimension_indexes);
 }
 
+static int counter_read_range(struct lib_counter *counter, size_t index, size_t nr_elem,
+			      int cpu, int64_t *values, bool *overflow, bool *underflow)
+{
+	return lttng_counter_read_range(&client_config, counter, index, nr_elem, cpu,
+					values, overflow, underflow);
+}
+
+static int counter_aggregate_range(struct lib_counter *counter, size_t index, size_t nr_elem,
+				   int64_t *values, bool *overflow, bool *underflow)
+{
+	return lttng_counter_aggregate_range(&client_config, counter, index, nr_elem,
+					     values, overflow, underflow);
+}
+
+static int counter_exchange_range(struct lib_counter *counter, size_t index, size_t nr_elem,
+				  int64_t *values, bool *overflow, bool *underflow)
+{
+	return lttng_counter_exchange_range(&client_config, counter, index, nr_elem,
+					    values, overflow, underflow);
+}
+
+static int counter_get_map_layout(struct lib_counter *counter,
+				  struct lib_counter_map_layout *map_layout)
+{
+	return lttng_counter_get_map_layout(&client_config, counter, map_layout);
+}
+
+static int counter_map(struct lib_counter *counter, struct vm_area_struct *vma)
+{
+	return lttng_counter_map(&client_config, counter, vma);
+}
+
 static struct lttng_counter_transport lttng_counter_transport = {
 	.name = "counter-per-cpu-64-modular",
 	.owner = THIS_MODULE,
@@ -69,6 +101,11 @@ static struct lttng_counter_transport lttng_counter_transport = {
 		.counter_read = counter_read,
 		.counter_aggregate = counter_aggregate,
 		.counter_clear = counter_clear,
+		.counter_read_range = counter_read_range,
+		.counter_aggregate_range = counter_aggregate_range,
+		.counter_exchange_range = counter_exchange_range,
+		.counter_get_map_layout = counter_get_map_layout,
+		.counter_map = counter_map,
 	},
 };
 
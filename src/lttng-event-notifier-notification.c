@@ -480,8 +480,28 @@ void lttng_event_notifier_notification_send(struct lttng_kernel_event_notifier *
 		struct lttng_kernel_notification_ctx *notif_ctx)
 {
 	struct lttng_event_notifier_notification notif = { 0 };
+	struct lttng_aggregation_map *aggregation_map;
+	struct lttng_histogram *histogram;
 	size_t captures_left;
 
+	/*
+	 * smp_load_acquire paired with smp_store_release orders linking
+	 * the capture bytecodes before the aggregation map or histogram
+	 * is used.
+	 */
+	aggregation_map = smp_load_acquire(&event_notifier->priv->aggregation_map);
+	if (aggregation_map) {
+		lttng_aggregation_map_update(aggregation_map, event_notifier,
+				stack_data, probe_ctx, notif_ctx);
+		return;
+	}
+	histogram = smp_load_acquire(&event_notifier->priv->histogram);
+	if (histogram) {
+		lttng_histogram_update(histogram, event_notifier,
+				stack_data, probe_ctx, notif_ctx);
+		return;
+	}
+
 	if (notification_init(&notif, event_notifier))
 		goto error;
 
@@ -163,10 +163,15 @@ struct lttng_kernel_session *lttng_session_create(void)
 	INIT_LIST_HEAD(&session_priv->events);
 	lttng_guid_gen(&session_priv->uuid);
 
+	session_priv->tracker_verdict_cache =
+		alloc_percpu(struct lttng_tracker_verdict_cache);
+	if (!session_priv->tracker_verdict_cache)
+		goto err_free_session_private;
+
 	metadata_cache = kzalloc(sizeof(struct lttng_metadata_cache),
 			GFP_KERNEL);
 	if (!metadata_cache)
-		goto err_free_session_private;
+		goto err_free_verdict_cache;
 	metadata_cache->data = vzalloc(METADATA_CACHE_DEFAULT_SIZE);
 	if (!metadata_cache->data)
 		goto err_free_cache;
@@ -208,6 +213,8 @@ tracker_alloc_error:
 	lttng_id_tracker_fini(&session->vgid_tracker);
 err_free_cache:
 	kfree(metadata_cache);
+err_free_verdict_cache:
+	free_percpu(session_priv->tracker_verdict_cache);
 err_free_session_private:
 	lttng_kvfree(session_priv);
 err_free_session:
@@ -318,6 +325,8 @@ struct lttng_event_notifier_group *lttng_event_notifier_group_create(void)
 
 	INIT_LIST_HEAD(&event_notifier_group->enablers_head);
 	INIT_LIST_HEAD(&event_notifier_group->event_notifiers_head);
+	INIT_LIST_HEAD(&event_notifier_group->aggregation_maps_head);
+	INIT_LIST_HEAD(&event_notifier_group->histograms_head);
 	for (i = 0; i < LTTNG_EVENT_HT_SIZE; i++)
 		INIT_HLIST_HEAD(&event_notifier_group->events_ht.table[i]);
 
@@ -384,6 +393,7 @@ void lttng_session_destroy(struct lttng_kernel_session *session)
 	lttng_id_tracker_fini(&session->vuid_tracker);
 	lttng_id_tracker_fini(&session->gid_tracker);
 	lttng_id_tracker_fini(&session->vgid_tracker);
+	free_percpu(session->priv->tracker_verdict_cache);
 	kref_put(&session->priv->metadata_cache->refcount, metadata_cache_destroy);
 	list_del(&session->priv->list);
 	mutex_unlock(&sessions_mutex);
@@ -396,6 +406,8 @@ void lttng_event_notifier_group_destroy(
 {
 	struct lttng_event_enabler_common *event_enabler, *tmp_event_enabler;
 	struct lttng_kernel_event_notifier_private *event_notifier_priv, *tmpevent_notifier_priv;
+	struct lttng_aggregation_map *aggregation_map, *tmp_aggregation_map;
+	struct lttng_histogram *histogram, *tmp_histogram;
 	int ret;
 
 	if (!event_notifier_group)
@@ -426,6 +438,14 @@ void lttng_event_notifier_group_destroy(
 			&event_notifier_group->event_notifiers_head, parent.node)
 		_lttng_event_destroy(&event_notifier_priv->pub->parent);
 
+	list_for_each_entry_safe(aggregation_map, tmp_aggregation_map,
+			&event_notifier_group->aggregation_maps_head, node)
+		lttng_aggregation_map_destroy(aggregation_map);
+
+	list_for_each_entry_safe(histogram, tmp_histogram,
+			&event_notifier_group->histograms_head, node)
+		lttng_histogram_destroy(histogram);
+
 	if (event_notifier_group->error_counter) {
 		struct lttng_counter *error_counter = event_notifier_group->error_counter;
 
@@ -924,6 +944,12 @@ struct lttng_kernel_event_common *lttng_kernel_event_alloc(struct lttng_event_en
 			kmem_cache_free(event_recorder_private_cache, event_recorder);
 			return NULL;
 		}
+		event_recorder_priv->parent.filter_stats = alloc_percpu(struct lttng_kernel_event_filter_stats);
+		if (!event_recorder_priv->parent.filter_stats) {
+			kmem_cache_free(event_recorder_private_cache, event_recorder_priv);
+			kmem_cache_free(event_recorder_cache, event_recorder);
+			return NULL;
+		}
 		event_recorder_priv->pub = event_recorder;
 		event_recorder_priv->parent.pub = &event_recorder->parent;
 		event_recorder->priv = event_recorder_priv;
@@ -954,6 +980,12 @@ struct lttng_kernel_event_common *lttng_kernel_event_alloc(struct lttng_event_en
 			kmem_cache_free(event_notifier_private_cache, event_notifier);
 			return NULL;
 		}
+		event_notifier_priv->parent.filter_stats = alloc_percpu(struct lttng_kernel_event_filter_stats);
+		if (!event_notifier_priv->parent.filter_stats) {
+			kmem_cache_free(event_notifier_private_cache, event_notifier_priv);
+			kmem_cache_free(event_notifier_cache, event_notifier);
+			return NULL;
+		}
 		event_notifier_priv->pub = event_notifier;
 		event_notifier_priv->parent.pub = &event_notifier->parent;
 		event_notifier->priv = event_notifier_priv;
@@ -981,6 +1013,7 @@ struct lttng_kernel_event_common *lttng_kernel_event_alloc(struct lttng_event_en
 static
 void lttng_kernel_event_free(struct lttng_kernel_event_common *event)
 {
+	free_percpu(event->priv->filter_stats);
 	switch (event->type) {
 	case LTTNG_KERNEL_EVENT_TYPE_RECORDER:
 	{
@@ -1328,6 +1361,42 @@ int lttng_kernel_counter_clear(struct lttng_counter *counter,
 	return counter->ops->counter_clear(counter->counter, dim_indexes);
 }
 
+int lttng_kernel_counter_read_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem, int32_t cpu,
+		int64_t *values, bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_read_range(counter->counter, index, nr_elem,
+			cpu, values, overflow, underflow);
+}
+
+int lttng_kernel_counter_aggregate_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem,
+		int64_t *values, bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_aggregate_range(counter->counter, index, nr_elem,
+			values, overflow, underflow);
+}
+
+int lttng_kernel_counter_exchange_range(struct lttng_counter *counter,
+		size_t index, size_t nr_elem,
+		int64_t *values, bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_exchange_range(counter->counter, index, nr_elem,
+			values, overflow, underflow);
+}
+
+int lttng_kernel_counter_get_map_layout(struct lttng_counter *counter,
+		struct lib_counter_map_layout *map_layout)
+{
+	return counter->ops->counter_get_map_layout(counter->counter, map_layout);
+}
+
+int lttng_kernel_counter_map(struct lttng_counter *counter,
+		struct vm_area_struct *vma)
+{
+	return counter->ops->counter_map(counter->counter, vma);
+}
+
 /* Only used for tracepoints and system calls for now. */
 static
 void register_event(struct lttng_kernel_event_common *event)
@@ -1501,8 +1570,6 @@ void _lttng_event_destroy(struct lttng_kernel_event_common *event)
 			WARN_ON_ONCE(1);
 		}
 		list_del(&event_recorder->priv->parent.node);
-		kmem_cache_free(event_recorder_private_cache, event_recorder->priv);
-		kmem_cache_free(event_recorder_cache, event_recorder);
 		break;
 	}
 	case LTTNG_KERNEL_EVENT_TYPE_NOTIFIER:
@@ -1538,13 +1605,12 @@ void _lttng_event_destroy(struct lttng_kernel_event_common *event)
 			WARN_ON_ONCE(1);
 		}
 		list_del(&event_notifier->priv->parent.node);
-		kmem_cache_free(event_notifier_private_cache, event_notifier->priv);
-		kmem_cache_free(event_notifier_cache, event_notifier);
 		break;
 	}
 	default:
 		WARN_ON_ONCE(1);
 	}
+	lttng_kernel_event_free(event);
 }
 
 static
@@ -1901,7 +1967,8 @@ int lttng_desc_match_enabler_check(const struct lttng_kernel_event_desc *desc,
 			}
 			break;
 		case LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR:
-			return -EINVAL;	/* Not implemented. */
+			return lttng_syscall_desc_match_nr(desc, compat, entry,
+					enabler->event_param.u.syscall.nr);
 		default:
 			return -EINVAL;
 		}
@@ -1931,6 +1998,9 @@ bool lttng_event_enabler_match_event(struct lttng_event_enabler_common *event_en
 {
 	if (event_enabler->event_param.instrumentation != event->priv->instrumentation)
 		return false;
+	if (event->priv->instrumentation == LTTNG_KERNEL_ABI_SYSCALL
+			&& !lttng_syscall_event_enabler_match_nr(event_enabler, event))
+		return false;
 
 	switch (event_enabler->enabler_type) {
 	case LTTNG_EVENT_ENABLER_TYPE_RECORDER:
@@ -2142,7 +2212,7 @@ void lttng_event_enabler_init_event_filter(struct lttng_event_enabler_common *ev
 		struct lttng_kernel_event_common *event)
 {
 	/* Link filter bytecodes if not linked yet. */
-	lttng_enabler_link_bytecode(event->priv->desc, lttng_static_ctx,
+	lttng_enabler_link_bytecode(event->priv->desc, lttng_static_ctx, &event->filter_fields,
 		&event->priv->filter_bytecode_runtime_head, &event_enabler->filter_bytecode_head);
 }
 
@@ -2162,9 +2232,23 @@ void lttng_event_enabler_init_event_capture(struct lttng_event_enabler_common *e
 
 		/* Link capture bytecodes if not linked yet. */
 		lttng_enabler_link_bytecode(event->priv->desc,
-			lttng_static_ctx, &event_notifier->priv->capture_bytecode_runtime_head,
+			lttng_static_ctx, &event->filter_fields,
+			&event_notifier->priv->capture_bytecode_runtime_head,
 			&event_notifier_enabler->capture_bytecode_head);
 		event_notifier->priv->num_captures = event_notifier_enabler->num_captures;
+		/*
+		 * store-release to publish the aggregation map and the
+		 * histogram matches load-acquire in
+		 * lttng_event_notifier_notification_send. Ensures the
+		 * capture bytecodes are linked before they are used as key
+		 * or value.
+		 */
+		if (event_notifier_enabler->aggregation_map && !event_notifier->priv->aggregation_map)
+			smp_store_release(&event_notifier->priv->aggregation_map,
+					event_notifier_enabler->aggregation_map);
+		if (event_notifier_enabler->histogram && !event_notifier->priv->histogram)
+			smp_store_release(&event_notifier->priv->histogram,
+					event_notifier_enabler->histogram);
 		break;
 	}
 	default:
@@ -2311,6 +2395,55 @@ int lttng_event_enabler_disable(struct lttng_event_enabler_common *event_enabler
 	return 0;
 }
 
+static
+void lttng_event_filter_stats_add(struct lttng_kernel_event_common *event,
+		struct lttng_kernel_abi_event_filter_stats *stats)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct lttng_kernel_event_filter_stats *cpu_stats =
+			per_cpu_ptr(event->priv->filter_stats, cpu);
+		u64 evaluations = READ_ONCE(cpu_stats->evaluations);
+		u64 accepts = READ_ONCE(cpu_stats->accepts);
+
+		stats->evaluations += evaluations;
+		stats->accepts += accepts;
+		/* Accepts are counted after the evaluation. */
+		stats->rejects += evaluations > accepts ? evaluations - accepts : 0;
+		stats->sampled_evaluations += READ_ONCE(cpu_stats->sampled_evaluations);
+		stats->sampled_cycles += READ_ONCE(cpu_stats->sampled_cycles);
+	}
+}
+
+void lttng_event_filter_stats(struct lttng_kernel_event_common *event,
+		struct lttng_kernel_abi_event_filter_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	lttng_event_filter_stats_add(event, stats);
+}
+
+/*
+ * Sum the filter statistics of the events matched by an enabler.
+ */
+int lttng_event_enabler_filter_stats(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_abi_event_filter_stats *stats)
+{
+	struct list_head *event_list_head;
+	struct lttng_kernel_event_common_private *event_priv;
+
+	memset(stats, 0, sizeof(*stats));
+	mutex_lock(&sessions_mutex);
+	event_list_head = lttng_get_event_list_head_from_enabler(event_enabler);
+	list_for_each_entry(event_priv, event_list_head, node) {
+		if (!lttng_enabler_ref(&event_priv->enablers_ref_head, event_enabler))
+			continue;
+		lttng_event_filter_stats_add(event_priv->pub, stats);
+	}
+	mutex_unlock(&sessions_mutex);
+	return 0;
+}
+
 static
 int lttng_enabler_attach_filter_bytecode(struct lttng_event_enabler_common *enabler,
 		struct lttng_kernel_abi_filter_bytecode __user *bytecode)
@@ -2462,6 +2595,14 @@ int lttng_event_notifier_enabler_attach_capture_bytecode(
 	if (ret)
 		return ret;
 
+	/* Captures of an aggregated event notifier form its key. */
+	if (event_notifier_enabler->aggregation_map
+			&& event_notifier_enabler->num_captures >= LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX)
+		return -E2BIG;
+	/* The single capture of a histogram event notifier is its value. */
+	if (event_notifier_enabler->histogram && event_notifier_enabler->num_captures >= 1)
+		return -E2BIG;
+
 	bytecode_node = lttng_kvzalloc(sizeof(*bytecode_node) + bytecode_len,
 			GFP_KERNEL);
 	if (!bytecode_node)
@@ -2490,8 +2631,71 @@ end:
 	return ret;
 }
 
+/*
+ * Count the hits of the event notifiers of @event_notifier_enabler in
+ * @aggregation_map, keyed by their captures, instead of sending
+ * notifications.
+ */
+int lttng_event_notifier_enabler_attach_aggregation_map(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_aggregation_map *aggregation_map)
+{
+	int ret = 0;
+
+	mutex_lock(&sessions_mutex);
+	if (aggregation_map->group != event_notifier_enabler->group) {
+		ret = -EINVAL;
+		goto end;
+	}
+	if (event_notifier_enabler->aggregation_map || event_notifier_enabler->histogram) {
+		ret = -EBUSY;
+		goto end;
+	}
+	if (event_notifier_enabler->num_captures > LTTNG_KERNEL_ABI_AGGREGATION_MAP_KEY_MAX) {
+		ret = -E2BIG;
+		goto end;
+	}
+	event_notifier_enabler->aggregation_map = aggregation_map;
+	lttng_event_notifier_group_sync_enablers(event_notifier_enabler->group);
+end:
+	mutex_unlock(&sessions_mutex);
+	return ret;
+}
+
+/*
+ * Count the hits of the event notifiers of @event_notifier_enabler in
+ * @histogram, bucketed by the value of their capture, instead of
+ * sending notifications.
+ */
+int lttng_event_notifier_enabler_attach_histogram(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_histogram *histogram)
+{
+	int ret = 0;
+
+	mutex_lock(&sessions_mutex);
+	if (histogram->group != event_notifier_enabler->group) {
+		ret = -EINVAL;
+		goto end;
+	}
+	if (event_notifier_enabler->aggregation_map || event_notifier_enabler->histogram) {
+		ret = -EBUSY;
+		goto end;
+	}
+	if (event_notifier_enabler->num_captures > 1) {
+		ret = -E2BIG;
+		goto end;
+	}
+	event_notifier_enabler->histogram = histogram;
+	lttng_event_notifier_group_sync_enablers(event_notifier_enabler->group);
+end:
+	mutex_unlock(&sessions_mutex);
+	return ret;
+}
+
 static
-void lttng_event_sync_filter_state(struct lttng_kernel_event_common *event)
+void lttng_event_sync_filter_state(struct lttng_kernel_event_common *event,
+		struct list_head *retired_filters)
 {
 	int has_enablers_without_filter_bytecode = 0, nr_filters = 0;
 	struct lttng_kernel_bytecode_runtime *runtime;
@@ -2512,6 +2716,7 @@ void lttng_event_sync_filter_state(struct lttng_kernel_event_common *event)
 		lttng_bytecode_sync_state(runtime);
 		nr_filters++;
 	}
+	lttng_bytecode_merge_event_filter(event, retired_filters);
 	WRITE_ONCE(event->eval_filter, !(has_enablers_without_filter_bytecode || !nr_filters));
 }
 
@@ -2609,6 +2814,7 @@ void lttng_sync_event_list(struct list_head *event_enabler_list,
 {
 	struct lttng_kernel_event_common_private *event_priv;
 	struct lttng_event_enabler_common *event_enabler;
+	LIST_HEAD(retired_filters);
 
 	list_for_each_entry(event_enabler, event_enabler_list, node)
 		lttng_event_enabler_ref_events(event_enabler);
@@ -2638,9 +2844,11 @@ void lttng_sync_event_list(struct list_head *event_enabler_list,
 				unregister_event(event);
 		}
 
-		lttng_event_sync_filter_state(event);
+		lttng_event_sync_filter_state(event, &retired_filters);
 		lttng_event_sync_capture_state(event);
 	}
+	/* A single grace period for the merged filters replaced above. */
+	lttng_bytecode_merged_free_retired(&retired_filters);
 }
 
 /*
@@ -3488,14 +3696,28 @@ int _lttng_event_recorder_metadata_statedump(struct lttng_kernel_event_common *e
 
 	lttng_metadata_begin(session);
 
-	ret = lttng_metadata_printf(session,
-		"event {\n"
-		"	name = \"%s\";\n"
-		"	id = %u;\n"
-		"	stream_id = %u;\n",
-		event_recorder->priv->parent.desc->event_name,
-		event_recorder->priv->id,
-		event_recorder->chan->priv->id);
+	if (event->priv->instrumentation == LTTNG_KERNEL_ABI_SYSCALL
+			&& lttng_syscall_event_is_unknown_nr(event)) {
+		/* Unknown syscall event of a number enabler, e.g. "syscall_entry_unknown_451". */
+		ret = lttng_metadata_printf(session,
+			"event {\n"
+			"	name = \"%s_%u\";\n"
+			"	id = %u;\n"
+			"	stream_id = %u;\n",
+			event_recorder->priv->parent.desc->event_name,
+			event->priv->u.syscall.syscall_id,
+			event_recorder->priv->id,
+			event_recorder->chan->priv->id);
+	} else {
+		ret = lttng_metadata_printf(session,
+			"event {\n"
+			"	name = \"%s\";\n"
+			"	id = %u;\n"
+			"	stream_id = %u;\n",
+			event_recorder->priv->parent.desc->event_name,
+			event_recorder->priv->id,
+			event_recorder->chan->priv->id);
+	}
 	if (ret)
 		goto end;
 
@@ -4161,6 +4383,9 @@ static int __init lttng_events_init(void)
 		ret = -ENOMEM;
 		goto error_kmem_event_notifier_private;
 	}
+	ret = lttng_static_region_init();
+	if (ret)
+		goto error_static_region;
 	ret = lttng_abi_init();
 	if (ret)
 		goto error_abi;
@@ -4196,6 +4421,8 @@ error_hotplug:
 error_logger:
 	lttng_abi_exit();
 error_abi:
+	lttng_static_region_exit();
+error_static_region:
 	kmem_cache_destroy(event_notifier_private_cache);
 error_kmem_event_notifier_private:
 	kmem_cache_destroy(event_notifier_cache);
@@ -4237,6 +4464,7 @@ static void __exit lttng_events_exit(void)
 	lttng_abi_exit();
 	list_for_each_entry_safe(session_priv, tmpsession_priv, &sessions, list)
 		lttng_session_destroy(session_priv->pub);
+	lttng_static_region_exit();
 	kmem_cache_destroy(event_recorder_cache);
 	kmem_cache_destroy(event_recorder_private_cache);
 	kmem_cache_destroy(event_notifier_cache);
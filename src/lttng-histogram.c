@@ -0,0 +1,157 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-histogram.c
+ *
+ * LTTng histograms.
+ *
+ * A histogram counts the hits of the event notifiers attached to it per
+ * bucket of the value of their capture, so that distributions such as
+ * latencies can be gathered without tracing every event. Bucket N is
+ * counter N of a per-cpu counter.
+ */
+
+#include <linux/bitops.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+
+#include <lttng/lttng-bytecode.h>
+#include <lttng/events.h>
+#include <lttng/events-internal.h>
+#include <wrapper/limits.h>
+#include <wrapper/vmalloc.h>
+
+/*
+ * Create a histogram in @event_notifier_group. @histogram_conf is
+ * validated by the caller.
+ * Should be called with sessions mutex held.
+ */
+struct lttng_histogram *lttng_histogram_create(
+		struct lttng_event_notifier_group *event_notifier_group,
+		const char *counter_transport_name,
+		const struct lttng_kernel_abi_histogram_conf *histogram_conf)
+{
+	struct lttng_histogram *histogram;
+	size_t nr_buckets = histogram_conf->nr_buckets;
+
+	histogram = lttng_kvzalloc(sizeof(*histogram), GFP_KERNEL);
+	if (!histogram)
+		return NULL;
+	histogram->counter = lttng_kernel_counter_create(counter_transport_name,
+			1, &nr_buckets);
+	if (!histogram->counter) {
+		lttng_kvfree(histogram);
+		return NULL;
+	}
+
+	histogram->counter->histogram = histogram;
+	histogram->group = event_notifier_group;
+	histogram->type = histogram_conf->type;
+	histogram->nr_buckets = nr_buckets;
+	histogram->min = histogram_conf->min;
+	histogram->width = histogram_conf->width;
+	list_add(&histogram->node, &event_notifier_group->histograms_head);
+	return histogram;
+}
+
+/*
+ * Only called when the event notifier group is destroyed, once no event
+ * notifier can use the histogram anymore.
+ * Should be called with sessions mutex held.
+ */
+void lttng_histogram_destroy(struct lttng_histogram *histogram)
+{
+	struct lttng_counter *counter = histogram->counter;
+
+	list_del(&histogram->node);
+	counter->ops->counter_destroy(counter->counter);
+	module_put(counter->transport->owner);
+	lttng_kvfree(counter);
+	lttng_kvfree(histogram);
+}
+
+static
+size_t histogram_log2_bucket(const struct lttng_histogram *histogram,
+		bool negative, uint64_t v)
+{
+	size_t bucket;
+
+	if (negative || !v)
+		return 0;
+	bucket = fls64(v);
+	return min_t(size_t, bucket, histogram->nr_buckets - 1);
+}
+
+static
+size_t histogram_linear_bucket(const struct lttng_histogram *histogram,
+		bool negative, uint64_t v)
+{
+	uint64_t offset;
+
+	/* Unsigned values above S64_MAX are above any linear range. */
+	if (!negative && v > S64_MAX)
+		return histogram->nr_buckets - 1;
+	if ((int64_t) v < histogram->min)
+		return 0;
+	/* Two's complement difference, cannot overflow as v >= min. */
+	offset = div64_u64(v - (uint64_t) histogram->min, histogram->width);
+	if (offset >= histogram->nr_buckets - 1)
+		return histogram->nr_buckets - 1;
+	return offset + 1;
+}
+
+/*
+ * Count a hit of @event_notifier in @histogram, in the bucket of the
+ * value of its capture.
+ */
+void lttng_histogram_update(struct lttng_histogram *histogram,
+		struct lttng_kernel_event_notifier *event_notifier,
+		const char *stack_data,
+		struct lttng_kernel_probe_ctx *probe_ctx,
+		struct lttng_kernel_notification_ctx *notif_ctx)
+{
+	struct lttng_counter *counter = histogram->counter;
+	struct lttng_kernel_bytecode_runtime *capture_bc_runtime;
+	struct lttng_interpreter_output output;
+	bool negative;
+	size_t bucket;
+	uint64_t v;
+	int ret;
+
+	if (!notif_ctx->eval_capture)
+		return;
+	capture_bc_runtime = list_first_or_null_rcu(&event_notifier->priv->capture_bytecode_runtime_head,
+			struct lttng_kernel_bytecode_runtime, node);
+	if (!capture_bc_runtime)
+		return;
+	if (capture_bc_runtime->interpreter_func(capture_bc_runtime,
+			stack_data, probe_ctx, &output) != LTTNG_KERNEL_BYTECODE_INTERPRETER_OK)
+		return;
+	switch (output.type) {
+	case LTTNG_INTERPRETER_TYPE_S64:
+	case LTTNG_INTERPRETER_TYPE_SIGNED_ENUM:
+		negative = output.u.s < 0;
+		v = (uint64_t) output.u.s;
+		break;
+	case LTTNG_INTERPRETER_TYPE_U64:
+	case LTTNG_INTERPRETER_TYPE_UNSIGNED_ENUM:
+		negative = false;
+		v = output.u.u;
+		break;
+	default:
+		return;
+	}
+
+	switch (histogram->type) {
+	case LTTNG_KERNEL_ABI_HISTOGRAM_LOG2:
+		bucket = histogram_log2_bucket(histogram, negative, v);
+		break;
+	case LTTNG_KERNEL_ABI_HISTOGRAM_LINEAR:
+		bucket = histogram_linear_bucket(histogram, negative, v);
+		break;
+	default:
+		WARN_ON_ONCE(1);
+		return;
+	}
+	ret = counter->ops->counter_add(counter->counter, &bucket, 1);
+	WARN_ON_ONCE(ret);
+}
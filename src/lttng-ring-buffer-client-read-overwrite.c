@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-ring-buffer-client-read-overwrite.c
+ *
+ * LTTng lib ring buffer client (overwrite mode, read output).
+ *
+ * Copyright (C) 2010-2012 Mathieu Desnoyers <mathieu.desnoyers@efficios.com>
+ */
+
+#include <linux/module.h>
+#include <lttng/tracer.h>
+
+#define RING_BUFFER_MODE_TEMPLATE		RING_BUFFER_OVERWRITE
+#define RING_BUFFER_MODE_TEMPLATE_STRING	"overwrite-read"
+#define RING_BUFFER_OUTPUT_TEMPLATE		RING_BUFFER_READ
+#include "lttng-ring-buffer-client.h"
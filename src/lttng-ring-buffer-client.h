@@ -20,6 +20,10 @@
 #define LTTNG_COMPACT_EVENT_BITS	5
 #define LTTNG_COMPACT_TIMESTAMP_BITS	27
 
+#ifndef RING_BUFFER_BACKEND_TEMPLATE
+#define RING_BUFFER_BACKEND_TEMPLATE	RING_BUFFER_PAGE
+#endif
+
 static struct lttng_transport lttng_relay_transport;
 
 /*
@@ -519,16 +523,30 @@ static const struct lttng_kernel_ring_buffer_config client_config = {
 	.alloc = RING_BUFFER_ALLOC_PER_CPU,
 	.sync = RING_BUFFER_SYNC_PER_CPU,
 	.mode = RING_BUFFER_MODE_TEMPLATE,
-	.backend = RING_BUFFER_PAGE,
+	.backend = RING_BUFFER_BACKEND_TEMPLATE,
 	.output = RING_BUFFER_OUTPUT_TEMPLATE,
 	.oops = RING_BUFFER_OOPS_CONSISTENCY,
 	.ipi = RING_BUFFER_IPI_BARRIER,
 	.wakeup = RING_BUFFER_WAKEUP_BY_TIMER,
 };
 
+/*
+ * Number of sub-buffers of each buffer in the static region, including
+ * the reader sub-buffer.
+ */
+static
+size_t client_static_region_num_subbuf(size_t num_subbuf)
+{
+	if (client_config.mode == RING_BUFFER_OVERWRITE)
+		return num_subbuf + 1;
+	return num_subbuf;
+}
+
 static
 void release_priv_ops(void *priv_ops)
 {
+	if (client_config.backend == RING_BUFFER_STATIC)
+		lttng_static_region_put();
 	module_put(THIS_MODULE);
 }
 
@@ -548,25 +566,36 @@ struct lttng_kernel_ring_buffer_channel *_channel_create(const char *name,
 	struct lttng_kernel_channel_buffer *lttng_chan = priv;
 	struct lttng_kernel_ring_buffer_channel *chan;
 
+	if (client_config.backend == RING_BUFFER_STATIC) {
+		buf_addr = lttng_static_region_get(subbuf_size,
+			client_static_region_num_subbuf(num_subbuf));
+		if (!buf_addr) {
+			printk(KERN_WARNING "LTTng: Static buffer region unavailable.\n");
+			return NULL;
+		}
+	}
 	chan = channel_create(&client_config, name, lttng_chan, buf_addr,
 			      subbuf_size, num_subbuf, switch_timer_interval,
 			      read_timer_interval);
-	if (chan) {
-		/*
-		 * Ensure this module is not unloaded before we finish
-		 * using lttng_relay_transport.ops.
-		 */
-		if (!try_module_get(THIS_MODULE)) {
-			printk(KERN_WARNING "LTTng: Can't lock transport module.\n");
-			goto error;
-		}
-		chan->backend.priv_ops = &lttng_relay_transport.ops;
-		chan->backend.release_priv_ops = release_priv_ops;
+	if (!chan)
+		goto create_error;
+	/*
+	 * Ensure this module is not unloaded before we finish
+	 * using lttng_relay_transport.ops.
+	 */
+	if (!try_module_get(THIS_MODULE)) {
+		printk(KERN_WARNING "LTTng: Can't lock transport module.\n");
+		goto error;
 	}
+	chan->backend.priv_ops = &lttng_relay_transport.ops;
+	chan->backend.release_priv_ops = release_priv_ops;
 	return chan;
 
 error:
 	lttng_channel_destroy(chan);
+create_error:
+	if (client_config.backend == RING_BUFFER_STATIC)
+		lttng_static_region_put();
 	return NULL;
 }
 
@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-static-region.c
+ *
+ * LTTng preallocated memory region for the static ring buffer backend.
+ *
+ * The region is a physical memory range reserved at boot (e.g. with
+ * memmap= or a reserved-memory node), handed to the tracer through the
+ * static_region_phys and static_region_size module parameters. Channels
+ * created with the static backend use it instead of allocating pages, so
+ * their buffers live at a known physical location which can be recovered
+ * from a crash dump or across kexec.
+ *
+ * The first page of the region holds a struct
+ * lttng_kernel_abi_static_region_header describing the buffers. When the
+ * tracer is loaded over a region still owned by a channel of a previous
+ * kernel, that trace is kept: it can be read from /proc/lttng-static-region,
+ * and no channel can claim the region until a write to that file
+ * releases it.
+ */
+
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/proc_fs.h>
+#include <linux/string.h>
+
+#include <lttng/abi.h>
+#include <lttng/events-internal.h>
+#include <lttng/kernel-version.h>
+
+static unsigned long long static_region_phys;
+module_param(static_region_phys, ullong, 0444);
+MODULE_PARM_DESC(static_region_phys, "Physical address of the static ring buffer region");
+
+static unsigned long static_region_size;
+module_param(static_region_size, ulong, 0444);
+MODULE_PARM_DESC(static_region_size, "Size of the static ring buffer region, in bytes");
+
+#define LTTNG_STATIC_REGION_FILE	"lttng-static-region"
+
+static DEFINE_MUTEX(static_region_mutex);
+static void *static_region_addr;
+static int static_region_used;
+/* The region holds a trace of a previous kernel, not released yet. */
+static int static_region_pending;
+static struct proc_dir_entry *static_region_dentry;
+
+static
+bool static_region_header_valid(const struct lttng_kernel_abi_static_region_header *header)
+{
+	return header->magic == LTTNG_KERNEL_ABI_STATIC_REGION_MAGIC
+		&& header->buf_offset == PAGE_SIZE
+		&& header->buf_len <= static_region_size - PAGE_SIZE;
+}
+
+/*
+ * Claim the static region for a channel with @num_subbuf sub-buffers of
+ * @subbuf_size bytes per cpu. The region is used by a single channel at
+ * a time, and is unavailable while it holds a trace of a previous
+ * kernel. The claimed buffers are cleared, like freshly allocated
+ * buffer pages, so that padding between records never exposes older
+ * data to the trace reader, and the region header is updated to
+ * describe them. Returns the buffers address, or NULL if the region is
+ * unavailable.
+ */
+void *lttng_static_region_get(size_t subbuf_size, size_t num_subbuf)
+{
+	struct lttng_kernel_abi_static_region_header *header;
+	void *addr = NULL;
+	size_t len;
+
+	if (!subbuf_size || num_subbuf > SIZE_MAX / subbuf_size / nr_cpu_ids)
+		return NULL;
+	len = subbuf_size * num_subbuf * nr_cpu_ids;
+
+	mutex_lock(&static_region_mutex);
+	if (!static_region_addr || static_region_used)
+		goto end;
+	if (static_region_pending) {
+		printk(KERN_WARNING "LTTng: static region holds a trace of a previous kernel, release it through /proc/"
+			LTTNG_STATIC_REGION_FILE "\n");
+		goto end;
+	}
+	if (len > static_region_size - PAGE_SIZE)
+		goto end;
+	static_region_used = 1;
+	addr = static_region_addr + PAGE_SIZE;
+	memset(addr, 0, len);
+
+	header = static_region_addr;
+	if (static_region_header_valid(header))
+		header->seq++;
+	else
+		header->seq = 1;
+	header->magic = LTTNG_KERNEL_ABI_STATIC_REGION_MAGIC;
+	header->buf_offset = PAGE_SIZE;
+	header->buf_len = len;
+	header->subbuf_size = subbuf_size;
+	header->num_subbuf = num_subbuf;
+	header->nr_cpus = nr_cpu_ids;
+	header->in_use = 1;
+end:
+	mutex_unlock(&static_region_mutex);
+	return addr;
+}
+EXPORT_SYMBOL_GPL(lttng_static_region_get);
+
+/*
+ * Release the region once its channel is freed. The trace it holds is
+ * left in place, but is not reported as a previous kernel trace anymore.
+ */
+void lttng_static_region_put(void)
+{
+	struct lttng_kernel_abi_static_region_header *header = static_region_addr;
+
+	mutex_lock(&static_region_mutex);
+	WARN_ON_ONCE(!static_region_used);
+	header->in_use = 0;
+	static_region_used = 0;
+	mutex_unlock(&static_region_mutex);
+}
+EXPORT_SYMBOL_GPL(lttng_static_region_put);
+
+/*
+ * Read the header and buffers of the trace of a previous kernel. Reads
+ * nothing once it is released.
+ */
+static
+ssize_t lttng_static_region_read(struct file *file, char __user *user_buf,
+		size_t count, loff_t *ppos)
+{
+	struct lttng_kernel_abi_static_region_header *header = static_region_addr;
+	ssize_t ret = 0;
+
+	mutex_lock(&static_region_mutex);
+	if (static_region_pending)
+		ret = simple_read_from_buffer(user_buf, count, ppos,
+				static_region_addr,
+				header->buf_offset + header->buf_len);
+	mutex_unlock(&static_region_mutex);
+	return ret;
+}
+
+/*
+ * Any write releases the trace of a previous kernel, so that a channel
+ * can claim the region.
+ */
+static
+ssize_t lttng_static_region_write(struct file *file, const char __user *user_buf,
+		size_t count, loff_t *ppos)
+{
+	struct lttng_kernel_abi_static_region_header *header = static_region_addr;
+
+	mutex_lock(&static_region_mutex);
+	if (static_region_pending) {
+		header->in_use = 0;
+		static_region_pending = 0;
+	}
+	mutex_unlock(&static_region_mutex);
+	*ppos += count;
+	return count;
+}
+
+#if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(5,6,0))
+static const struct proc_ops lttng_static_region_proc_ops = {
+	.proc_read = lttng_static_region_read,
+	.proc_write = lttng_static_region_write,
+};
+#else
+static const struct file_operations lttng_static_region_proc_ops = {
+	.owner = THIS_MODULE,
+	.read = lttng_static_region_read,
+	.write = lttng_static_region_write,
+};
+#endif
+
+int lttng_static_region_init(void)
+{
+	struct lttng_kernel_abi_static_region_header *header;
+	phys_addr_t phys = static_region_phys;
+	unsigned long pfn;
+
+	if (!static_region_size)
+		return 0;
+	if (!PAGE_ALIGNED(phys) || !PAGE_ALIGNED(static_region_size)) {
+		printk(KERN_WARNING "LTTng: static region must be page aligned\n");
+		return -EINVAL;
+	}
+	if (static_region_size <= PAGE_SIZE) {
+		printk(KERN_WARNING "LTTng: static region must hold a header page and buffers\n");
+		return -EINVAL;
+	}
+	/*
+	 * The buffer pages are handed to splice and mmap, which need them
+	 * to be covered by the kernel memory map.
+	 */
+	for (pfn = phys >> PAGE_SHIFT;
+			pfn < (phys + static_region_size) >> PAGE_SHIFT; pfn++) {
+		if (!pfn_valid(pfn)) {
+			printk(KERN_WARNING "LTTng: static region is not backed by struct pages\n");
+			return -EINVAL;
+		}
+	}
+	static_region_addr = memremap(phys, static_region_size, MEMREMAP_WB);
+	if (!static_region_addr) {
+		printk(KERN_WARNING "LTTng: unable to map static region\n");
+		return -ENOMEM;
+	}
+	header = static_region_addr;
+	if (static_region_header_valid(header) && header->in_use) {
+		static_region_pending = 1;
+		printk(KERN_NOTICE "LTTng: static region holds trace %llu of a previous kernel\n",
+			(unsigned long long) header->seq);
+	}
+	static_region_dentry = proc_create_data(LTTNG_STATIC_REGION_FILE,
+				S_IRUSR | S_IWUSR, NULL,
+				&lttng_static_region_proc_ops, NULL);
+	if (!static_region_dentry) {
+		printk(KERN_WARNING "LTTng: unable to create static region file\n");
+		memunmap(static_region_addr);
+		static_region_addr = NULL;
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+void lttng_static_region_exit(void)
+{
+	if (!static_region_addr)
+		return;
+	WARN_ON_ONCE(static_region_used);
+	remove_proc_entry(LTTNG_STATIC_REGION_FILE, NULL);
+	memunmap(static_region_addr);
+	static_region_addr = NULL;
+}
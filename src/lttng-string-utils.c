@@ -4,7 +4,10 @@
  */
 
 #include <linux/types.h>
+#include <linux/errno.h>
+#include <linux/string.h>
 #include <wrapper/compiler_attributes.h>
+#include <wrapper/limits.h>
 
 #include <lttng/string-utils.h>
 
@@ -355,3 +358,115 @@ end_of_pattern:
 	p = pattern_get_char_at_cb(p_at, pattern_get_char_at_cb_data);
 	return prev_p == '*' && p == '\0';
 }
+
+/*
+ * Returns the size of the compiled form of the star globbing pattern
+ * `pattern`.
+ */
+size_t strutils_star_glob_compiled_len(const char *pattern)
+{
+	/* Unescaped pieces are at most as long as the pattern. */
+	return sizeof(struct strutils_star_glob) + 2 * (strlen(pattern) + 1);
+}
+
+/*
+ * Compiles the star globbing pattern `pattern` into `glob`, which must
+ * hold strutils_star_glob_compiled_len(pattern) bytes.
+ *
+ * Returns -EINVAL if the pattern cannot be compiled, in which case it
+ * must be matched with strutils_star_glob_match().
+ */
+int strutils_star_glob_compile(const char *pattern,
+		struct strutils_star_glob *glob)
+{
+	size_t len = strutils_star_glob_compiled_len(pattern);
+	char *q = glob->data, *piece = glob->data;
+	const char *p;
+
+	if (len > U16_MAX)
+		return -EINVAL;
+	glob->nr_pieces = 1;
+	for (p = pattern; *p != '\0'; p++) {
+		switch (*p) {
+		case '*':
+			if (glob->nr_pieces == 1)
+				glob->prefix_len = q - glob->data;
+			*q++ = '\0';
+			glob->nr_pieces++;
+			piece = q;
+			break;
+		case '\\':
+			p++;
+			/*
+			 * A trailing escape character never matches:
+			 * leave it to the generic matching function.
+			 */
+			if (*p == '\0')
+				return -EINVAL;
+			lttng_fallthrough;
+		default:
+			*q++ = *p;
+			break;
+		}
+	}
+	if (glob->nr_pieces == 1)
+		glob->prefix_len = q - glob->data;
+	glob->suffix_offset = piece - glob->data;
+	glob->suffix_len = q - piece;
+	*q++ = '\0';
+	glob->pattern_offset = q - glob->data;
+	memcpy(q, pattern, strlen(pattern) + 1);
+	glob->len = len;
+	return 0;
+}
+
+/*
+ * Matches `candidate` (plain string) against the compiled star globbing
+ * pattern `glob`. `candidate_len` can be greater than the actual string
+ * length of `candidate` if the string is null-terminated.
+ *
+ * With star-only patterns, the first piece must be a prefix of the
+ * candidate, the last piece a suffix, and the pieces in between match
+ * at their leftmost position, so each character of the candidate is
+ * compared a bounded number of times with memcmp() rather than through
+ * per-character callbacks.
+ */
+bool strutils_star_glob_compiled_match(const struct strutils_star_glob *glob,
+		const char *candidate, size_t candidate_len)
+{
+	size_t len = strnlen(candidate, candidate_len);
+	const char *piece, *end;
+	unsigned int i;
+
+	if (glob->nr_pieces == 1) {
+		return len == glob->prefix_len &&
+			!memcmp(candidate, glob->data, len);
+	}
+
+	if (len < glob->prefix_len + glob->suffix_len ||
+			memcmp(candidate, glob->data, glob->prefix_len)) {
+		return false;
+	}
+
+	end = candidate + len - glob->suffix_len;
+	if (memcmp(end, &glob->data[glob->suffix_offset], glob->suffix_len)) {
+		return false;
+	}
+
+	candidate += glob->prefix_len;
+	piece = &glob->data[glob->prefix_len + 1];
+	for (i = 1; i < glob->nr_pieces - 1; i++) {
+		size_t piece_len = strlen(piece);
+		const char *match;
+
+		match = strnstr(candidate, piece, end - candidate);
+		if (!match) {
+			return false;
+		}
+
+		candidate = match + piece_len;
+		piece += piece_len + 1;
+	}
+
+	return true;
+}
@@ -125,45 +125,55 @@ struct lttng_syscall_filter {
 	u32 sc_compat_exit_refcount_map[NR_compat_syscalls];
 };
 
-static void syscall_entry_event_unknown(struct hlist_head *unknown_action_list_head,
-	struct pt_regs *regs, long id)
+static void syscall_entry_event_unknown_call(struct hlist_head *action_list_head,
+	long id, const unsigned long *args, bool compat)
 {
-	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 	struct lttng_kernel_event_common_private *event_priv;
 
-	lttng_syscall_get_arguments(current, regs, args);
-	lttng_hlist_for_each_entry_rcu(event_priv, unknown_action_list_head, u.syscall.node) {
-		if (unlikely(in_compat_syscall()))
+	lttng_hlist_for_each_entry_rcu(event_priv, action_list_head, u.syscall.node) {
+		if (unlikely(compat))
 			__event_probe__compat_syscall_entry_unknown(event_priv->pub, id, args);
 		else
 			__event_probe__syscall_entry_unknown(event_priv->pub, id, args);
 	}
 }
 
-static __always_inline
-void syscall_entry_event_call_func(struct hlist_head *action_list,
-		void *func, unsigned int nrargs,
-		struct pt_regs *regs)
+/*
+ * Unknown system calls are recorded by the "all" syscalls enablers
+ * (@unknown_action_list_head, NULL when none is enabled) and by the
+ * enablers of their number (@nr_action_list_head).
+ */
+static void syscall_entry_event_unknown(struct hlist_head *unknown_action_list_head,
+	struct hlist_head *nr_action_list_head, struct pt_regs *regs, long id, bool compat)
 {
-	struct lttng_kernel_event_common_private *event_priv;
+	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
+	if ((!unknown_action_list_head || hlist_empty(unknown_action_list_head))
+			&& hlist_empty(nr_action_list_head))
+		return;
+	lttng_syscall_get_arguments(current, regs, args);
+	if (unknown_action_list_head)
+		syscall_entry_event_unknown_call(unknown_action_list_head, id, args, compat);
+	syscall_entry_event_unknown_call(nr_action_list_head, id, args, compat);
+}
+
+static __always_inline
+void syscall_entry_event_call(void *func, unsigned int nrargs,
+		struct lttng_kernel_event_common *event, const unsigned long *args)
+{
 	switch (nrargs) {
 	case 0:
 	{
 		void (*fptr)(void *__data) = func;
 
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub);
+		fptr(event);
 		break;
 	}
 	case 1:
 	{
 		void (*fptr)(void *__data, unsigned long arg0) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0]);
+		fptr(event, args[0]);
 		break;
 	}
 	case 2:
@@ -171,11 +181,8 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 		void (*fptr)(void *__data,
 			unsigned long arg0,
 			unsigned long arg1) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0], args[1]);
+		fptr(event, args[0], args[1]);
 		break;
 	}
 	case 3:
@@ -184,11 +191,8 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 			unsigned long arg0,
 			unsigned long arg1,
 			unsigned long arg2) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0], args[1], args[2]);
+		fptr(event, args[0], args[1], args[2]);
 		break;
 	}
 	case 4:
@@ -198,11 +202,8 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 			unsigned long arg1,
 			unsigned long arg2,
 			unsigned long arg3) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0], args[1], args[2], args[3]);
+		fptr(event, args[0], args[1], args[2], args[3]);
 		break;
 	}
 	case 5:
@@ -213,11 +214,8 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 			unsigned long arg2,
 			unsigned long arg3,
 			unsigned long arg4) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0], args[1], args[2], args[3], args[4]);
+		fptr(event, args[0], args[1], args[2], args[3], args[4]);
 		break;
 	}
 	case 6:
@@ -229,12 +227,9 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 			unsigned long arg3,
 			unsigned long arg4,
 			unsigned long arg5) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, args[0], args[1], args[2],
-			     args[3], args[4], args[5]);
+		fptr(event, args[0], args[1], args[2],
+			args[3], args[4], args[5]);
 		break;
 	}
 	default:
@@ -242,12 +237,35 @@ void syscall_entry_event_call_func(struct hlist_head *action_list,
 	}
 }
 
+static __always_inline
+void syscall_entry_event_call_func(const struct lttng_syscall_dispatch *dispatch,
+		struct pt_regs *regs)
+{
+	struct lttng_kernel_event_common_private *event_priv;
+	struct lttng_kernel_event_common *single_event;
+	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
+
+	single_event = lttng_rcu_dereference(dispatch->single_event);
+	if (!single_event && hlist_empty(&dispatch->action_list))
+		return;
+	if (dispatch->nrargs)
+		lttng_syscall_get_arguments(current, regs, args);
+	if (likely(single_event)) {
+		syscall_entry_event_call(dispatch->event_func, dispatch->nrargs,
+			single_event, args);
+		return;
+	}
+	lttng_hlist_for_each_entry_rcu(event_priv, &dispatch->action_list, u.syscall.node)
+		syscall_entry_event_call(dispatch->event_func, dispatch->nrargs,
+			event_priv->pub, args);
+}
+
 void syscall_entry_event_probe(void *__data, struct pt_regs *regs, long id)
 {
 	struct lttng_kernel_syscall_table *syscall_table = __data;
-	struct hlist_head *action_list, *unknown_action_list;
-	const struct trace_syscall_entry *table, *entry;
-	size_t table_len;
+	struct lttng_syscall_dispatch *dispatch;
+	struct hlist_head *unknown_action_list;
+	bool compat;
 
 #ifdef CONFIG_X86_X32_ABI
 	if (in_x32_syscall()) {
@@ -255,60 +273,42 @@ void syscall_entry_event_probe(void *__data, struct pt_regs *regs, long id)
 		return;
 	}
 #endif
-	if (unlikely(in_compat_syscall())) {
-		struct lttng_syscall_filter *filter = syscall_table->sc_filter;
-
-		if (id < 0 || id >= NR_compat_syscalls
-			|| (!READ_ONCE(syscall_table->syscall_all_entry) && !test_bit(id, filter->sc_compat_entry))) {
-			/* System call filtered out. */
+	compat = in_compat_syscall();
+	if (unlikely(compat)) {
+		if (id < 0 || id >= NR_compat_syscalls)
 			return;
-		}
-		table = compat_sc_table.table;
-		table_len = compat_sc_table.len;
+		dispatch = syscall_table->compat_syscall_dispatch;
 		unknown_action_list = &syscall_table->compat_unknown_syscall_dispatch;
 	} else {
-		struct lttng_syscall_filter *filter = syscall_table->sc_filter;
-
-		if (id < 0 || id >= NR_syscalls
-			|| (!READ_ONCE(syscall_table->syscall_all_entry) && !test_bit(id, filter->sc_entry))) {
-			/* System call filtered out. */
+		if (id < 0 || id >= NR_syscalls)
 			return;
-		}
-		table = sc_table.table;
-		table_len = sc_table.len;
+		dispatch = syscall_table->syscall_dispatch;
 		unknown_action_list = &syscall_table->unknown_syscall_dispatch;
 	}
-	if (unlikely(id < 0 || id >= table_len)) {
-		syscall_entry_event_unknown(unknown_action_list, regs, id);
-		return;
-	}
-
-	entry = &table[id];
-	if (!entry->event_func) {
-		syscall_entry_event_unknown(unknown_action_list, regs, id);
+	/*
+	 * The events enabled for a system call are its dispatch entry:
+	 * system calls without events are filtered out by the entry
+	 * itself. The dispatch table covers every system call number, the
+	 * entries of unknown system calls holding the unknown events
+	 * enabled for their number.
+	 */
+	if (unlikely(!dispatch[id].event_func)) {
+		if (!READ_ONCE(syscall_table->syscall_all_entry))
+			unknown_action_list = NULL;
+		syscall_entry_event_unknown(unknown_action_list, &dispatch[id].action_list,
+			regs, id, compat);
 		return;
 	}
-
-	if (unlikely(in_compat_syscall())) {
-		action_list = &syscall_table->compat_syscall_dispatch[id];
-	} else {
-		action_list = &syscall_table->syscall_dispatch[id];
-	}
-	if (unlikely(hlist_empty(action_list)))
-		return;
-
-	syscall_entry_event_call_func(action_list, entry->event_func, entry->nrargs, regs);
+	syscall_entry_event_call_func(&dispatch[id], regs);
 }
 
-static void syscall_exit_event_unknown(struct hlist_head *unknown_action_list_head,
-	struct pt_regs *regs, long id, long ret)
+static void syscall_exit_event_unknown_call(struct hlist_head *action_list_head,
+	long id, long ret, const unsigned long *args, bool compat)
 {
-	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 	struct lttng_kernel_event_common_private *event_priv;
 
-	lttng_syscall_get_arguments(current, regs, args);
-	lttng_hlist_for_each_entry_rcu(event_priv, unknown_action_list_head, u.syscall.node) {
-		if (unlikely(in_compat_syscall()))
+	lttng_hlist_for_each_entry_rcu(event_priv, action_list_head, u.syscall.node) {
+		if (unlikely(compat))
 			__event_probe__compat_syscall_exit_unknown(event_priv->pub, id, ret,
 				args);
 		else
@@ -316,20 +316,32 @@ static void syscall_exit_event_unknown(struct hlist_head *unknown_action_list_he
 	}
 }
 
-static __always_inline
-void syscall_exit_event_call_func(struct hlist_head *action_list,
-		void *func, unsigned int nrargs,
-		struct pt_regs *regs, long ret)
+static void syscall_exit_event_unknown(struct hlist_head *unknown_action_list_head,
+	struct hlist_head *nr_action_list_head, struct pt_regs *regs, long id, long ret,
+	bool compat)
 {
-	struct lttng_kernel_event_common_private *event_priv;
+	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
+	if ((!unknown_action_list_head || hlist_empty(unknown_action_list_head))
+			&& hlist_empty(nr_action_list_head))
+		return;
+	lttng_syscall_get_arguments(current, regs, args);
+	if (unknown_action_list_head)
+		syscall_exit_event_unknown_call(unknown_action_list_head, id, ret, args, compat);
+	syscall_exit_event_unknown_call(nr_action_list_head, id, ret, args, compat);
+}
+
+static __always_inline
+void syscall_exit_event_call(void *func, unsigned int nrargs,
+		struct lttng_kernel_event_common *event, long ret,
+		const unsigned long *args)
+{
 	switch (nrargs) {
 	case 0:
 	{
 		void (*fptr)(void *__data, long ret) = func;
 
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret);
+		fptr(event, ret);
 		break;
 	}
 	case 1:
@@ -337,11 +349,8 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 		void (*fptr)(void *__data,
 			long ret,
 			unsigned long arg0) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0]);
+		fptr(event, ret, args[0]);
 		break;
 	}
 	case 2:
@@ -350,11 +359,8 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 			long ret,
 			unsigned long arg0,
 			unsigned long arg1) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0], args[1]);
+		fptr(event, ret, args[0], args[1]);
 		break;
 	}
 	case 3:
@@ -364,11 +370,8 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 			unsigned long arg0,
 			unsigned long arg1,
 			unsigned long arg2) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0], args[1], args[2]);
+		fptr(event, ret, args[0], args[1], args[2]);
 		break;
 	}
 	case 4:
@@ -379,11 +382,8 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 			unsigned long arg1,
 			unsigned long arg2,
 			unsigned long arg3) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0], args[1], args[2], args[3]);
+		fptr(event, ret, args[0], args[1], args[2], args[3]);
 		break;
 	}
 	case 5:
@@ -395,11 +395,8 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 			unsigned long arg2,
 			unsigned long arg3,
 			unsigned long arg4) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0], args[1], args[2], args[3], args[4]);
+		fptr(event, ret, args[0], args[1], args[2], args[3], args[4]);
 		break;
 	}
 	case 6:
@@ -412,12 +409,9 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 			unsigned long arg3,
 			unsigned long arg4,
 			unsigned long arg5) = func;
-		unsigned long args[LTTNG_SYSCALL_NR_ARGS];
 
-		lttng_syscall_get_arguments(current, regs, args);
-		lttng_hlist_for_each_entry_rcu(event_priv, action_list, u.syscall.node)
-			fptr(event_priv->pub, ret, args[0], args[1], args[2],
-			     args[3], args[4], args[5]);
+		fptr(event, ret, args[0], args[1], args[2],
+			args[3], args[4], args[5]);
 		break;
 	}
 	default:
@@ -425,12 +419,35 @@ void syscall_exit_event_call_func(struct hlist_head *action_list,
 	}
 }
 
+static __always_inline
+void syscall_exit_event_call_func(const struct lttng_syscall_dispatch *dispatch,
+		struct pt_regs *regs, long ret)
+{
+	struct lttng_kernel_event_common_private *event_priv;
+	struct lttng_kernel_event_common *single_event;
+	unsigned long args[LTTNG_SYSCALL_NR_ARGS];
+
+	single_event = lttng_rcu_dereference(dispatch->single_event);
+	if (!single_event && hlist_empty(&dispatch->action_list))
+		return;
+	if (dispatch->nrargs)
+		lttng_syscall_get_arguments(current, regs, args);
+	if (likely(single_event)) {
+		syscall_exit_event_call(dispatch->event_func, dispatch->nrargs,
+			single_event, ret, args);
+		return;
+	}
+	lttng_hlist_for_each_entry_rcu(event_priv, &dispatch->action_list, u.syscall.node)
+		syscall_exit_event_call(dispatch->event_func, dispatch->nrargs,
+			event_priv->pub, ret, args);
+}
+
 void syscall_exit_event_probe(void *__data, struct pt_regs *regs, long ret)
 {
 	struct lttng_kernel_syscall_table *syscall_table = __data;
-	struct hlist_head *action_list, *unknown_action_list;
-	const struct trace_syscall_entry *table, *entry;
-	size_t table_len;
+	struct lttng_syscall_dispatch *dispatch;
+	struct hlist_head *unknown_action_list;
+	bool compat;
 	long id;
 
 #ifdef CONFIG_X86_X32_ABI
@@ -441,50 +458,26 @@ void syscall_exit_event_probe(void *__data, struct pt_regs *regs, long ret)
 #endif
 	id = syscall_get_nr(current, regs);
 
-	if (unlikely(in_compat_syscall())) {
-		struct lttng_syscall_filter *filter = syscall_table->sc_filter;
-
-		if (id < 0 || id >= NR_compat_syscalls
-			|| (!READ_ONCE(syscall_table->syscall_all_exit) && !test_bit(id, filter->sc_compat_exit))) {
-			/* System call filtered out. */
+	compat = in_compat_syscall();
+	if (unlikely(compat)) {
+		if (id < 0 || id >= NR_compat_syscalls)
 			return;
-		}
-		table = compat_sc_exit_table.table;
-		table_len = compat_sc_exit_table.len;
+		dispatch = syscall_table->compat_syscall_exit_dispatch;
 		unknown_action_list = &syscall_table->compat_unknown_syscall_exit_dispatch;
 	} else {
-		struct lttng_syscall_filter *filter = syscall_table->sc_filter;
-
-		if (id < 0 || id >= NR_syscalls
-			|| (!READ_ONCE(syscall_table->syscall_all_exit) && !test_bit(id, filter->sc_exit))) {
-			/* System call filtered out. */
+		if (id < 0 || id >= NR_syscalls)
 			return;
-		}
-		table = sc_exit_table.table;
-		table_len = sc_exit_table.len;
+		dispatch = syscall_table->syscall_exit_dispatch;
 		unknown_action_list = &syscall_table->unknown_syscall_exit_dispatch;
 	}
-	if (unlikely(id < 0 || id >= table_len)) {
-		syscall_exit_event_unknown(unknown_action_list, regs, id, ret);
-		return;
-	}
-
-	entry = &table[id];
-	if (!entry->event_func) {
-		syscall_exit_event_unknown(unknown_action_list, regs, id, ret);
+	if (unlikely(!dispatch[id].event_func)) {
+		if (!READ_ONCE(syscall_table->syscall_all_exit))
+			unknown_action_list = NULL;
+		syscall_exit_event_unknown(unknown_action_list, &dispatch[id].action_list,
+			regs, id, ret, compat);
 		return;
 	}
-
-	if (unlikely(in_compat_syscall())) {
-		action_list = &syscall_table->compat_syscall_exit_dispatch[id];
-	} else {
-		action_list = &syscall_table->syscall_exit_dispatch[id];
-	}
-	if (unlikely(hlist_empty(action_list)))
-		return;
-
-	syscall_exit_event_call_func(action_list, entry->event_func, entry->nrargs,
-			       regs, ret);
+	syscall_exit_event_call_func(&dispatch[id], regs, ret);
 }
 
 static
@@ -531,7 +524,8 @@ struct lttng_kernel_syscall_table *get_syscall_table_from_event(struct lttng_ker
 
 static
 void lttng_syscall_event_enabler_create_event(struct lttng_event_enabler_common *syscall_event_enabler,
-		const struct lttng_kernel_event_desc *desc, enum sc_type type, unsigned int syscall_nr)
+		const struct lttng_kernel_event_desc *desc, const char *event_name,
+		enum sc_type type, unsigned int syscall_nr)
 {
 	struct lttng_kernel_event_common *event;
 
@@ -563,7 +557,7 @@ void lttng_syscall_event_enabler_create_event(struct lttng_event_enabler_common
 			ev.u.syscall.abi = LTTNG_KERNEL_ABI_SYSCALL_ABI_COMPAT;
 			break;
 		}
-		strncpy(ev.name, desc->event_name, LTTNG_KERNEL_ABI_SYM_NAME_LEN - 1);
+		strncpy(ev.name, event_name, LTTNG_KERNEL_ABI_SYM_NAME_LEN - 1);
 		ev.name[LTTNG_KERNEL_ABI_SYM_NAME_LEN - 1] = '\0';
 		ev.instrumentation = LTTNG_KERNEL_ABI_SYSCALL;
 		event_recorder_enabler = lttng_event_recorder_enabler_create(LTTNG_ENABLER_FORMAT_NAME, &ev,
@@ -575,7 +569,7 @@ void lttng_syscall_event_enabler_create_event(struct lttng_event_enabler_common
 		WARN_ON_ONCE(IS_ERR(event));
 		lttng_event_enabler_destroy(&event_recorder_enabler->parent);
 		if (IS_ERR(event)) {
-			printk(KERN_INFO "Unable to create event recorder %s\n", desc->event_name);
+			printk(KERN_INFO "Unable to create event recorder %s\n", event_name);
 			return;
 		}
 		event->priv->u.syscall.syscall_id = syscall_nr;
@@ -609,7 +603,7 @@ void lttng_syscall_event_enabler_create_event(struct lttng_event_enabler_common
 			event_notifier_param.event.u.syscall.abi = LTTNG_KERNEL_ABI_SYSCALL_ABI_COMPAT;
 			break;
 		}
-		strncat(event_notifier_param.event.name, desc->event_name,
+		strncat(event_notifier_param.event.name, event_name,
 			LTTNG_KERNEL_ABI_SYM_NAME_LEN - strlen(event_notifier_param.event.name) - 1);
 		event_notifier_param.event.name[LTTNG_KERNEL_ABI_SYM_NAME_LEN - 1] = '\0';
 		event_notifier_param.event.instrumentation = LTTNG_KERNEL_ABI_SYSCALL;
@@ -623,7 +617,7 @@ void lttng_syscall_event_enabler_create_event(struct lttng_event_enabler_common
 		WARN_ON_ONCE(IS_ERR(event));
 		lttng_event_enabler_destroy(&event_notifier_enabler->parent);
 		if (IS_ERR(event)) {
-			printk(KERN_INFO "Unable to create event notifier %s\n", desc->event_name);
+			printk(KERN_INFO "Unable to create event notifier %s\n", event_name);
 			return;
 		}
 		event->priv->u.syscall.syscall_id = syscall_nr;
@@ -674,7 +668,8 @@ void lttng_syscall_event_enabler_create_matching_syscall_table_events(struct ltt
 		if (found)
 			continue;
 
-		lttng_syscall_event_enabler_create_event(syscall_event_enabler_common, desc, type, i);
+		lttng_syscall_event_enabler_create_event(syscall_event_enabler_common, desc,
+			desc->event_name, type, i);
 	}
 }
 
@@ -692,6 +687,88 @@ bool lttng_syscall_event_enabler_is_wildcard_all(struct lttng_event_enabler_comm
 	return true;
 }
 
+static
+const struct lttng_kernel_event_desc *get_unknown_syscall_desc(enum sc_type type)
+{
+	switch (type) {
+	case SC_TYPE_ENTRY:
+		return &__event_desc___syscall_entry_unknown;
+	case SC_TYPE_EXIT:
+		return &__event_desc___syscall_exit_unknown;
+	case SC_TYPE_COMPAT_ENTRY:
+		return &__event_desc___compat_syscall_entry_unknown;
+	case SC_TYPE_COMPAT_EXIT:
+		return &__event_desc___compat_syscall_exit_unknown;
+	default:
+		WARN_ON_ONCE(1);
+		return NULL;
+	}
+}
+
+static
+bool is_unknown_syscall_desc(const struct lttng_kernel_event_desc *desc)
+{
+	return desc == &__event_desc___syscall_entry_unknown
+		|| desc == &__event_desc___syscall_exit_unknown
+		|| desc == &__event_desc___compat_syscall_entry_unknown
+		|| desc == &__event_desc___compat_syscall_exit_unknown;
+}
+
+/*
+ * Match an event description against a system call number: the
+ * description of the number in the system call table, or the unknown
+ * syscall description for numbers missing from the table.
+ */
+bool lttng_syscall_desc_match_nr(const struct lttng_kernel_event_desc *desc,
+		bool compat, bool entry, unsigned int nr)
+{
+	const struct trace_syscall_table *table;
+	unsigned int nr_syscalls;
+	enum sc_type type;
+
+	if (compat) {
+		if (!IS_ENABLED(CONFIG_COMPAT))
+			return false;
+		table = entry ? &compat_sc_table : &compat_sc_exit_table;
+		type = entry ? SC_TYPE_COMPAT_ENTRY : SC_TYPE_COMPAT_EXIT;
+		nr_syscalls = NR_compat_syscalls;
+	} else {
+		table = entry ? &sc_table : &sc_exit_table;
+		type = entry ? SC_TYPE_ENTRY : SC_TYPE_EXIT;
+		nr_syscalls = NR_syscalls;
+	}
+	if (nr >= nr_syscalls)
+		return false;
+	if (nr < table->len && table->table[nr].desc)
+		return table->table[nr].desc == desc;
+	return desc == get_unknown_syscall_desc(type);
+}
+
+/*
+ * The unknown syscall events of system call numbers share their
+ * description with the unknown event of "all" syscalls enablers: tell
+ * them apart by number.
+ */
+bool lttng_syscall_event_enabler_match_nr(struct lttng_event_enabler_common *event_enabler,
+		struct lttng_kernel_event_common *event)
+{
+	unsigned int syscall_id = event->priv->u.syscall.syscall_id;
+
+	if (event_enabler->event_param.u.syscall.match == LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR)
+		return syscall_id == event_enabler->event_param.u.syscall.nr;
+	return syscall_id == -1U || !is_unknown_syscall_desc(event->priv->desc);
+}
+
+/*
+ * Whether @event is the unknown syscall event of a system call number
+ * enabler, named after its number (see create_unknown_syscall_nr_event).
+ */
+bool lttng_syscall_event_is_unknown_nr(struct lttng_kernel_event_common *event)
+{
+	return event->priv->u.syscall.syscall_id != -1U
+		&& is_unknown_syscall_desc(event->priv->desc);
+}
+
 static
 void create_unknown_syscall_event(struct lttng_event_enabler_common *event_enabler, enum sc_type type)
 {
@@ -706,46 +783,74 @@ void create_unknown_syscall_event(struct lttng_event_enabler_common *event_enabl
 		return;
 #endif
 	/*
-	 * Considering that currently system calls can only be enabled on a per
-	 * name basis (or wildcard based on a name), unknown syscall events are
-	 * only used when matching *all* system calls, because this is the only
-	 * case which can be associated with an unknown system call.
-	 *
-	 * When enabling system call on a per system call number basis will be
-	 * supported, this will need to be revisited.
+	 * The unknown syscall event without number is used when matching
+	 * *all* system calls: name wildcards cannot be associated with an
+	 * unknown system call. Enablers of a system call number get an
+	 * unknown event of their own (see create_unknown_syscall_nr_event).
 	 */
 	if (!lttng_syscall_event_enabler_is_wildcard_all(event_enabler))
 		return;
 
-	switch (type) {
-	case SC_TYPE_ENTRY:
-		desc = &__event_desc___syscall_entry_unknown;
-		break;
-	case SC_TYPE_EXIT:
-		desc = &__event_desc___syscall_exit_unknown;
-		break;
-	case SC_TYPE_COMPAT_ENTRY:
-		desc = &__event_desc___compat_syscall_entry_unknown;
-		break;
-	case SC_TYPE_COMPAT_EXIT:
-		desc = &__event_desc___compat_syscall_exit_unknown;
-		break;
-	default:
-		WARN_ON_ONCE(1);
-	}
+	desc = get_unknown_syscall_desc(type);
+	if (!desc)
+		return;
 
 	/*
 	 * Check if already created.
 	 */
 	head = utils_borrow_hash_table_bucket(events_ht->table, LTTNG_EVENT_HT_SIZE, desc->event_name);
 	lttng_hlist_for_each_entry(event_priv, head, hlist_node) {
-		if (lttng_event_enabler_desc_match_event(event_enabler, desc, event_priv->pub)) {
+		if (lttng_event_enabler_desc_match_event(event_enabler, desc, event_priv->pub)
+				&& event_priv->u.syscall.syscall_id == -1U) {
 			found = true;
 			break;
 		}
 	}
 	if (!found)
-		lttng_syscall_event_enabler_create_event(event_enabler, desc, type, -1U);
+		lttng_syscall_event_enabler_create_event(event_enabler, desc,
+			desc->event_name, type, -1U);
+}
+
+/*
+ * Create the unknown syscall event of a system call number enabler when
+ * the number has no description in the system call tables. It is named
+ * after the unknown event and the number, e.g. "syscall_entry_unknown_451",
+ * and only dispatched for that number.
+ */
+static
+void create_unknown_syscall_nr_event(struct lttng_event_enabler_common *event_enabler, enum sc_type type)
+{
+	struct lttng_event_ht *events_ht = lttng_get_event_ht_from_enabler(event_enabler);
+	unsigned int nr = event_enabler->event_param.u.syscall.nr;
+	struct lttng_kernel_event_common_private *event_priv;
+	char event_name[LTTNG_KERNEL_ABI_SYM_NAME_LEN];
+	const struct lttng_kernel_event_desc *desc;
+	struct hlist_head *head;
+
+#ifndef CONFIG_COMPAT
+	if (type == SC_TYPE_COMPAT_ENTRY || type == SC_TYPE_COMPAT_EXIT)
+		return;
+#endif
+	if (event_enabler->event_param.u.syscall.match != LTTNG_KERNEL_ABI_SYSCALL_MATCH_NR)
+		return;
+	desc = get_unknown_syscall_desc(type);
+	if (!desc)
+		return;
+	/* Known system call, out of range number or other ABI. */
+	if (!lttng_desc_match_enabler(desc, event_enabler))
+		return;
+
+	/*
+	 * Check if already created.
+	 */
+	snprintf(event_name, sizeof(event_name), "%s_%u", desc->event_name, nr);
+	head = utils_borrow_hash_table_bucket(events_ht->table, LTTNG_EVENT_HT_SIZE, event_name);
+	lttng_hlist_for_each_entry(event_priv, head, hlist_node) {
+		if (lttng_event_enabler_desc_match_event(event_enabler, desc, event_priv->pub)
+				&& event_priv->u.syscall.syscall_id == nr)
+			return;
+	}
+	lttng_syscall_event_enabler_create_event(event_enabler, desc, event_name, type, nr);
 }
 
 static
@@ -760,6 +865,8 @@ void lttng_syscall_event_enabler_create_matching_events(struct lttng_event_enabl
 			compat_sc_table.table, compat_sc_table.len, SC_TYPE_COMPAT_ENTRY);
 		create_unknown_syscall_event(event_enabler, SC_TYPE_ENTRY);
 		create_unknown_syscall_event(event_enabler, SC_TYPE_COMPAT_ENTRY);
+		create_unknown_syscall_nr_event(event_enabler, SC_TYPE_ENTRY);
+		create_unknown_syscall_nr_event(event_enabler, SC_TYPE_COMPAT_ENTRY);
 	}
 
 	if (entryexit == LTTNG_KERNEL_ABI_SYSCALL_EXIT || entryexit == LTTNG_KERNEL_ABI_SYSCALL_ENTRYEXIT) {
@@ -769,9 +876,33 @@ void lttng_syscall_event_enabler_create_matching_events(struct lttng_event_enabl
 			compat_sc_exit_table.table, compat_sc_exit_table.len, SC_TYPE_COMPAT_EXIT);
 		create_unknown_syscall_event(event_enabler, SC_TYPE_EXIT);
 		create_unknown_syscall_event(event_enabler, SC_TYPE_COMPAT_EXIT);
+		create_unknown_syscall_nr_event(event_enabler, SC_TYPE_EXIT);
+		create_unknown_syscall_nr_event(event_enabler, SC_TYPE_COMPAT_EXIT);
 	}
 }
 
+/*
+ * The dispatch table has an entry for each of the @nr_syscalls system
+ * call numbers, even past the end of the system call table, so unknown
+ * system calls can be dispatched by number.
+ */
+static
+struct lttng_syscall_dispatch *lttng_syscall_dispatch_create(const struct trace_syscall_table *table,
+		size_t nr_syscalls)
+{
+	struct lttng_syscall_dispatch *dispatch;
+	size_t i;
+
+	dispatch = kcalloc(max_t(size_t, table->len, nr_syscalls), sizeof(*dispatch), GFP_KERNEL);
+	if (!dispatch)
+		return NULL;
+	for (i = 0; i < table->len; i++) {
+		dispatch[i].event_func = table->table[i].event_func;
+		dispatch[i].nrargs = table->table[i].nrargs;
+	}
+	return dispatch;
+}
+
 /*
  * Should be called with sessions lock held.
  */
@@ -782,13 +913,15 @@ int lttng_event_enabler_create_syscall_events_if_missing(struct lttng_event_enab
 
 	if (!syscall_table->syscall_dispatch) {
 		/* create syscall table mapping syscall to events */
-		syscall_table->syscall_dispatch = kzalloc(sizeof(struct hlist_head) * sc_table.len, GFP_KERNEL);
+		syscall_table->syscall_dispatch = lttng_syscall_dispatch_create(&sc_table,
+				NR_syscalls);
 		if (!syscall_table->syscall_dispatch)
 			return -ENOMEM;
 	}
 	if (!syscall_table->syscall_exit_dispatch) {
 		/* create syscall table mapping syscall to events */
-		syscall_table->syscall_exit_dispatch = kzalloc(sizeof(struct hlist_head) * sc_exit_table.len, GFP_KERNEL);
+		syscall_table->syscall_exit_dispatch = lttng_syscall_dispatch_create(&sc_exit_table,
+				NR_syscalls);
 		if (!syscall_table->syscall_exit_dispatch)
 			return -ENOMEM;
 	}
@@ -796,14 +929,16 @@ int lttng_event_enabler_create_syscall_events_if_missing(struct lttng_event_enab
 #ifdef CONFIG_COMPAT
 	if (!syscall_table->compat_syscall_dispatch) {
 		/* create syscall table mapping compat syscall to events */
-		syscall_table->compat_syscall_dispatch = kzalloc(sizeof(struct hlist_head) * compat_sc_table.len, GFP_KERNEL);
+		syscall_table->compat_syscall_dispatch = lttng_syscall_dispatch_create(&compat_sc_table,
+				NR_compat_syscalls);
 		if (!syscall_table->compat_syscall_dispatch)
 			return -ENOMEM;
 	}
 
 	if (!syscall_table->compat_syscall_exit_dispatch) {
 		/* create syscall table mapping compat syscall to events */
-		syscall_table->compat_syscall_exit_dispatch = kzalloc(sizeof(struct hlist_head) * compat_sc_exit_table.len, GFP_KERNEL);
+		syscall_table->compat_syscall_exit_dispatch = lttng_syscall_dispatch_create(&compat_sc_exit_table,
+				NR_compat_syscalls);
 		if (!syscall_table->compat_syscall_exit_dispatch)
 			return -ENOMEM;
 	}
@@ -965,10 +1100,58 @@ int lttng_syscall_filter_enable(
 	return 0;
 }
 
+static
+struct lttng_syscall_dispatch *get_syscall_dispatch(struct lttng_kernel_syscall_table *syscall_table,
+		struct lttng_kernel_event_common *event)
+{
+	unsigned int syscall_id = event->priv->u.syscall.syscall_id;
+
+	switch (event->priv->u.syscall.entryexit) {
+	case LTTNG_SYSCALL_ENTRY:
+		switch (event->priv->u.syscall.abi) {
+		case LTTNG_SYSCALL_ABI_NATIVE:
+			return &syscall_table->syscall_dispatch[syscall_id];
+		case LTTNG_SYSCALL_ABI_COMPAT:
+			return &syscall_table->compat_syscall_dispatch[syscall_id];
+		default:
+			return NULL;
+		}
+	case LTTNG_SYSCALL_EXIT:
+		switch (event->priv->u.syscall.abi) {
+		case LTTNG_SYSCALL_ABI_NATIVE:
+			return &syscall_table->syscall_exit_dispatch[syscall_id];
+		case LTTNG_SYSCALL_ABI_COMPAT:
+			return &syscall_table->compat_syscall_exit_dispatch[syscall_id];
+		default:
+			return NULL;
+		}
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Publish the event enabled for a system call when it is the only one,
+ * so the probe calls it without walking the list.
+ * Should be called with sessions lock held.
+ */
+static
+void lttng_syscall_dispatch_update_single(struct lttng_syscall_dispatch *dispatch)
+{
+	struct hlist_node *first = dispatch->action_list.first;
+	struct lttng_kernel_event_common *single_event = NULL;
+
+	if (first && !first->next)
+		single_event = hlist_entry(first, struct lttng_kernel_event_common_private,
+				u.syscall.node)->pub;
+	rcu_assign_pointer(dispatch->single_event, single_event);
+}
+
 int lttng_syscall_filter_enable_event(struct lttng_kernel_event_common *event)
 {
 	struct lttng_kernel_syscall_table *syscall_table = get_syscall_table_from_event(event);
 	unsigned int syscall_id = event->priv->u.syscall.syscall_id;
+	struct lttng_syscall_dispatch *dispatch = NULL;
 	struct hlist_head *dispatch_list;
 	int ret = 0;
 
@@ -1014,40 +1197,17 @@ int lttng_syscall_filter_enable_event(struct lttng_kernel_event_common *event)
 		if (ret)
 			return ret;
 
-		switch (event->priv->u.syscall.entryexit) {
-		case LTTNG_SYSCALL_ENTRY:
-			switch (event->priv->u.syscall.abi) {
-			case LTTNG_SYSCALL_ABI_NATIVE:
-				dispatch_list = &syscall_table->syscall_dispatch[syscall_id];
-				break;
-			case LTTNG_SYSCALL_ABI_COMPAT:
-				dispatch_list = &syscall_table->compat_syscall_dispatch[syscall_id];
-				break;
-			default:
-				ret = -EINVAL;
-				goto end;
-			}
-			break;
-		case LTTNG_SYSCALL_EXIT:
-			switch (event->priv->u.syscall.abi) {
-			case LTTNG_SYSCALL_ABI_NATIVE:
-				dispatch_list = &syscall_table->syscall_exit_dispatch[syscall_id];
-				break;
-			case LTTNG_SYSCALL_ABI_COMPAT:
-				dispatch_list = &syscall_table->compat_syscall_exit_dispatch[syscall_id];
-				break;
-			default:
-				ret = -EINVAL;
-				goto end;
-			}
-			break;
-		default:
+		dispatch = get_syscall_dispatch(syscall_table, event);
+		if (!dispatch) {
 			ret = -EINVAL;
 			goto end;
 		}
+		dispatch_list = &dispatch->action_list;
 	}
 
 	hlist_add_head_rcu(&event->priv->u.syscall.node, dispatch_list);
+	if (dispatch)
+		lttng_syscall_dispatch_update_single(dispatch);
 end:
 	return ret;
 }
@@ -1111,11 +1271,19 @@ int lttng_syscall_filter_disable_event(struct lttng_kernel_event_common *event)
 
 	/* Except for unknown syscall */
 	if (syscall_id != -1U) {
+		struct lttng_syscall_dispatch *dispatch;
+
 		ret = lttng_syscall_filter_disable(syscall_table->sc_filter,
 			event->priv->desc->event_name, event->priv->u.syscall.abi,
 			event->priv->u.syscall.entryexit, syscall_id);
 		if (ret)
 			return ret;
+		dispatch = get_syscall_dispatch(syscall_table, event);
+		if (!dispatch)
+			return -EINVAL;
+		hlist_del_rcu(&event->priv->u.syscall.node);
+		lttng_syscall_dispatch_update_single(dispatch);
+		return 0;
 	}
 	hlist_del_rcu(&event->priv->u.syscall.node);
 	return 0;
@@ -14,10 +14,16 @@
 #include <linux/stringify.h>
 #include <linux/hash.h>
 #include <linux/rcupdate.h>
+#include <linux/bitops.h>
+#include <linux/sched.h>
+#include <linux/cred.h>
+#include <linux/user_namespace.h>
+#include <linux/pid_namespace.h>
 
 #include <wrapper/tracepoint.h>
 #include <wrapper/rcu.h>
 #include <wrapper/list.h>
+#include <wrapper/compiler.h>
 #include <lttng/events.h>
 #include <lttng/events-internal.h>
 
@@ -45,8 +51,11 @@ bool lttng_id_tracker_lookup(struct lttng_kernel_id_tracker_rcu *p, int id)
 {
 	struct hlist_head *head;
 	struct lttng_id_hash_node *e;
-	uint32_t hash = hash_32(id, 32);
+	uint32_t hash;
 
+	if (likely((unsigned int) id < LTTNG_ID_BITMAP_BITS))
+		return test_bit(id, p->id_bitmap);
+	hash = hash_32(id, 32);
 	head = &p->id_hash[hash & (LTTNG_ID_TABLE_SIZE - 1)];
 	lttng_hlist_for_each_entry_rcu(e, head, hlist) {
 		if (id == e->id)
@@ -56,6 +65,127 @@ bool lttng_id_tracker_lookup(struct lttng_kernel_id_tracker_rcu *p, int id)
 }
 EXPORT_SYMBOL_GPL(lttng_id_tracker_lookup);
 
+/*
+ * Only the trackers present in @tracker_mask are looked up, and only
+ * their credentials are fetched.
+ * Return true if the current task is tracked by all active trackers.
+ */
+static
+bool lttng_session_tracker_lookup(struct lttng_kernel_session *session,
+		unsigned int tracker_mask)
+{
+	struct lttng_kernel_id_tracker_rcu *lf;
+
+	if (tracker_mask & (1U << TRACKER_PID)) {
+		lf = lttng_rcu_dereference(session->pid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf, current->tgid))
+			return false;
+	}
+	if (tracker_mask & (1U << TRACKER_VPID)) {
+		lf = lttng_rcu_dereference(session->vpid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf, task_tgid_vnr(current)))
+			return false;
+	}
+	if (tracker_mask & (1U << TRACKER_UID)) {
+		lf = lttng_rcu_dereference(session->uid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf,
+				from_kuid_munged(&init_user_ns, current_uid())))
+			return false;
+	}
+	if (tracker_mask & (1U << TRACKER_VUID)) {
+		lf = lttng_rcu_dereference(session->vuid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf,
+				from_kuid_munged(current_user_ns(), current_uid())))
+			return false;
+	}
+	if (tracker_mask & (1U << TRACKER_GID)) {
+		lf = lttng_rcu_dereference(session->gid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf,
+				from_kgid_munged(&init_user_ns, current_gid())))
+			return false;
+	}
+	if (tracker_mask & (1U << TRACKER_VGID)) {
+		lf = lttng_rcu_dereference(session->vgid_tracker.p);
+		if (lf && !lttng_id_tracker_lookup(lf,
+				from_kgid_munged(current_user_ns(), current_gid())))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Called from the probe prologue when at least one tracker of the
+ * session filters IDs. The verdict is cached per-cpu for the last task
+ * identity seen, and recomputed when either that identity or the
+ * session tracker generation changes. A probe nested over a cache
+ * update (interrupt, NMI) bypasses the cache.
+ *
+ * The tracker mask is read after the generation, so that a verdict
+ * cached under a generation is never computed from an older mask.
+ */
+bool lttng_session_tracker_admit(struct lttng_kernel_session *session)
+{
+	struct lttng_kernel_session_private *session_priv = session->priv;
+	struct lttng_tracker_verdict_cache *cache;
+	const struct cred *cred = current_cred();
+	struct pid_namespace *pid_ns;
+	unsigned int tracker_mask;
+	unsigned long generation;
+	bool verdict;
+
+	cache = this_cpu_ptr(session_priv->tracker_verdict_cache);
+	if (cache->busy)
+		return lttng_session_tracker_lookup(session,
+				LTTNG_READ_ONCE(session->tracker_mask));
+	cache->busy = true;
+	barrier();	/* Set busy before touching the cache. */
+	generation = LTTNG_READ_ONCE(session_priv->tracker_generation);
+	smp_rmb();	/* Read generation before tracker mask and content. */
+	tracker_mask = LTTNG_READ_ONCE(session->tracker_mask);
+	pid_ns = task_active_pid_ns(current);
+	if (cache->generation == generation
+			&& cache->tgid == current->tgid
+			&& cache->pid_ns == pid_ns
+			&& cache->user_ns == cred->user_ns
+			&& uid_eq(cache->uid, cred->uid)
+			&& gid_eq(cache->gid, cred->gid)) {
+		verdict = cache->verdict;
+	} else {
+		verdict = lttng_session_tracker_lookup(session, tracker_mask);
+		cache->generation = generation;
+		cache->tgid = current->tgid;
+		cache->pid_ns = pid_ns;
+		cache->user_ns = cred->user_ns;
+		cache->uid = cred->uid;
+		cache->gid = cred->gid;
+		cache->verdict = verdict;
+	}
+	barrier();	/* Done with the cache before clearing busy. */
+	cache->busy = false;
+	return verdict;
+}
+EXPORT_SYMBOL_GPL(lttng_session_tracker_admit);
+
+/*
+ * Publish whether this tracker filters IDs in the session tracker mask,
+ * and invalidate the cached tracker verdicts of the session.
+ * Called with sessions_mutex held, after the tracker update.
+ */
+static void lttng_id_tracker_update_session(struct lttng_kernel_id_tracker *lf)
+{
+	struct lttng_kernel_session *session = lf->priv->session;
+	unsigned int mask = session->tracker_mask;
+
+	if (lf->p)
+		mask |= 1U << lf->priv->tracker_type;
+	else
+		mask &= ~(1U << lf->priv->tracker_type);
+	WRITE_ONCE(session->tracker_mask, mask);
+	smp_wmb();	/* Update tracker content and mask before generation. */
+	WRITE_ONCE(session->priv->tracker_generation,
+		session->priv->tracker_generation + 1);
+}
+
 static struct lttng_kernel_id_tracker_rcu *lttng_id_tracker_rcu_create(void)
 {
 	struct lttng_kernel_id_tracker_rcu *tracker;
@@ -98,9 +228,11 @@ int lttng_id_tracker_add(struct lttng_kernel_id_tracker *lf, int id)
 	}
 	e->id = id;
 	hlist_add_head_rcu(&e->hlist, head);
-	if (allocated) {
+	if ((unsigned int) id < LTTNG_ID_BITMAP_BITS)
+		set_bit(id, p->id_bitmap);
+	if (allocated)
 		rcu_assign_pointer(lf->p, p);
-	}
+	lttng_id_tracker_update_session(lf);
 	return 0;
 
 error:
@@ -153,7 +285,10 @@ int lttng_id_tracker_del(struct lttng_kernel_id_tracker *lf, int id)
 	 */
 	lttng_hlist_for_each_entry(e, head, hlist) {
 		if (id == e->id) {
+			if ((unsigned int) id < LTTNG_ID_BITMAP_BITS)
+				clear_bit(id, p->id_bitmap);
 			id_tracker_del_node_rcu(e);
+			lttng_id_tracker_update_session(lf);
 			return 0;
 		}
 	}
@@ -186,6 +321,7 @@ int lttng_id_tracker_empty_set(struct lttng_kernel_id_tracker *lf)
 		return -ENOMEM;
 	oldp = lf->p;
 	rcu_assign_pointer(lf->p, p);
+	lttng_id_tracker_update_session(lf);
 	synchronize_trace();
 	lttng_id_tracker_rcu_destroy(oldp);
 	return 0;
@@ -210,6 +346,7 @@ void lttng_id_tracker_destroy(struct lttng_kernel_id_tracker *lf, bool rcu)
 	if (!p)
 		return;
 	rcu_assign_pointer(lf->p, NULL);
+	lttng_id_tracker_update_session(lf);
 	if (rcu)
 		synchronize_trace();
 	lttng_id_tracker_rcu_destroy(p);
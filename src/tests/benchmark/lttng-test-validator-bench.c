@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-test-validator-bench.c
+ *
+ * LTTng bytecode validator benchmark.
+ *
+ * Writing a number of iterations to /proc/lttng-test-validator-bench
+ * validates synthetic worst-case filter programs of increasing length
+ * that many times, and prints the average validation time of each
+ * program to the kernel log. The cost per KiB of bytecode stays flat
+ * when validation is linear in the bytecode length.
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/timekeeping.h>
+#include <linux/math64.h>
+
+#include <lttng/bytecode.h>
+#include <lttng/lttng-bytecode.h>
+#include <lttng/kernel-version.h>
+#include <lttng/tracer.h>
+#include <wrapper/vmalloc.h>
+
+#define LTTNG_TEST_VALIDATOR_BENCH_FILE	"lttng-test-validator-bench"
+
+/* Size of a "load immediate, logical or, cast" term. */
+#define BENCH_LOAD_LEN	(sizeof(struct load_op) + sizeof(struct literal_numeric))
+#define BENCH_TERM_LEN	(BENCH_LOAD_LEN + sizeof(struct logical_op) + sizeof(struct cast_op))
+
+enum bench_shape {
+	/* (t1 || t2) || t3 ...: one pending merge point at a time. */
+	BENCH_SHAPE_CHAIN,
+	/* t1 || (t2 || (t3 ...)): every merge point pending at once. */
+	BENCH_SHAPE_NESTED,
+};
+
+static const char *bench_shape_name[] = {
+	[BENCH_SHAPE_CHAIN] = "chain",
+	[BENCH_SHAPE_NESTED] = "nested",
+};
+
+/* Bytecode lengths, up to the largest length of a filter program. */
+static const size_t bench_len[] = { 1024, 4096, 16384, 65535 };
+
+static struct proc_dir_entry *lttng_test_validator_bench_dentry;
+
+static
+size_t bench_emit_load(char *pc, int64_t v)
+{
+	struct load_op *insn = (struct load_op *) pc;
+
+	insn->op = BYTECODE_OP_LOAD_S64;
+	((struct literal_numeric *) insn->data)->v = v;
+	return BENCH_LOAD_LEN;
+}
+
+static
+size_t bench_emit_or(char *pc, size_t skip_offset)
+{
+	struct logical_op *insn = (struct logical_op *) pc;
+
+	insn->op = BYTECODE_OP_OR;
+	insn->skip_offset = skip_offset;
+	return sizeof(struct logical_op);
+}
+
+static
+size_t bench_emit_cast(char *pc)
+{
+	((struct cast_op *) pc)->op = BYTECODE_OP_CAST_TO_S64;
+	return sizeof(struct cast_op);
+}
+
+/*
+ * Generate a program of @shape made of as many terms as fit in @len
+ * bytes. Returns the program length.
+ */
+static
+size_t bench_generate(char *code, size_t len, enum bench_shape shape)
+{
+	size_t nr_terms = (len - BENCH_LOAD_LEN - sizeof(struct return_op)) / BENCH_TERM_LEN;
+	size_t i, offset = 0;
+
+	switch (shape) {
+	case BENCH_SHAPE_CHAIN:
+		offset += bench_emit_load(code + offset, 0);
+		for (i = 0; i < nr_terms; i++) {
+			size_t join = offset + sizeof(struct logical_op) + BENCH_LOAD_LEN;
+
+			offset += bench_emit_or(code + offset, join);
+			offset += bench_emit_load(code + offset, i + 1);
+			offset += bench_emit_cast(code + offset);
+		}
+		break;
+	case BENCH_SHAPE_NESTED:
+	{
+		/* The joins follow the innermost term, innermost first. */
+		size_t joins = nr_terms * (BENCH_LOAD_LEN + sizeof(struct logical_op))
+			+ BENCH_LOAD_LEN;
+
+		for (i = 0; i < nr_terms; i++) {
+			offset += bench_emit_load(code + offset, i);
+			offset += bench_emit_or(code + offset, joins + nr_terms - 1 - i);
+		}
+		offset += bench_emit_load(code + offset, nr_terms);
+		for (i = 0; i < nr_terms; i++)
+			offset += bench_emit_cast(code + offset);
+		break;
+	}
+	}
+	((struct return_op *) (code + offset))->op = BYTECODE_OP_RETURN;
+	return offset + sizeof(struct return_op);
+}
+
+static
+int bench_run_program(size_t len, enum bench_shape shape, unsigned int nr_iter)
+{
+	struct bytecode_runtime *bytecode;
+	u64 start_ns, delta_ns;
+	unsigned int i;
+	int ret = 0;
+
+	bytecode = lttng_kvzalloc(sizeof(*bytecode) + len, GFP_KERNEL);
+	if (!bytecode)
+		return -ENOMEM;
+	bytecode->len = bench_generate(bytecode->code, len, shape);
+
+	start_ns = ktime_get_ns();
+	for (i = 0; i < nr_iter; i++) {
+		ret = lttng_bytecode_validate(bytecode);
+		if (ret)
+			break;
+		cond_resched();
+	}
+	delta_ns = ktime_get_ns() - start_ns;
+	if (ret) {
+		printk(KERN_WARNING "LTTng: validator bench: %s program of %u bytes rejected: %d\n",
+			bench_shape_name[shape], (unsigned int) bytecode->len, ret);
+		goto end;
+	}
+	printk(KERN_INFO "LTTng: validator bench: %s (%u bytes): %llu ns/validation, %llu ns/KiB\n",
+		bench_shape_name[shape], (unsigned int) bytecode->len,
+		div_u64(delta_ns, nr_iter),
+		div64_u64(delta_ns * 1024, (u64) nr_iter * bytecode->len));
+end:
+	lttng_kvfree(bytecode);
+	return ret;
+}
+
+/**
+ * lttng_test_validator_bench_write - run the validator benchmark
+ * @file: file pointer
+ * @user_buf: user string
+ * @count: length to copy
+ *
+ * Return -1 on error, with EFAULT, EINVAL or ENOMEM errno. Returns count
+ * on success.
+ */
+static
+ssize_t lttng_test_validator_bench_write(struct file *file, const char __user *user_buf,
+		    size_t count, loff_t *ppos)
+{
+	unsigned int nr_iter, i;
+	int ret;
+
+	/* Get the number of iterations */
+	ret = kstrtouint_from_user(user_buf, count, 10, &nr_iter);
+	if (ret)
+		return ret;
+	if (!nr_iter)
+		return -EINVAL;
+	for (i = 0; i < ARRAY_SIZE(bench_len); i++) {
+		ret = bench_run_program(bench_len[i], BENCH_SHAPE_CHAIN, nr_iter);
+		if (ret)
+			return ret;
+		ret = bench_run_program(bench_len[i], BENCH_SHAPE_NESTED, nr_iter);
+		if (ret)
+			return ret;
+	}
+	*ppos += count;
+	return count;
+}
+
+#if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(5,6,0))
+static const struct proc_ops lttng_test_validator_bench_proc_ops = {
+	.proc_write = lttng_test_validator_bench_write,
+};
+#else
+static const struct file_operations lttng_test_validator_bench_proc_ops = {
+	.write = lttng_test_validator_bench_write,
+};
+#endif
+
+static
+int __init lttng_test_validator_bench_init(void)
+{
+	lttng_test_validator_bench_dentry =
+			proc_create_data(LTTNG_TEST_VALIDATOR_BENCH_FILE,
+				S_IWUSR, NULL,
+				&lttng_test_validator_bench_proc_ops, NULL);
+	if (!lttng_test_validator_bench_dentry) {
+		printk(KERN_ERR "Error creating LTTng validator bench file\n");
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+module_init(lttng_test_validator_bench_init);
+
+static
+void __exit lttng_test_validator_bench_exit(void)
+{
+	if (lttng_test_validator_bench_dentry)
+		remove_proc_entry(LTTNG_TEST_VALIDATOR_BENCH_FILE, NULL);
+}
+
+module_exit(lttng_test_validator_bench_exit);
+
+MODULE_LICENSE("GPL and additional rights");
+MODULE_DESCRIPTION("LTTng bytecode validator benchmark");
+MODULE_VERSION(__stringify(LTTNG_MODULES_MAJOR_VERSION) "."
+	__stringify(LTTNG_MODULES_MINOR_VERSION) "."
+	__stringify(LTTNG_MODULES_PATCHLEVEL_VERSION)
+	LTTNG_MODULES_EXTRAVERSION);
@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: (GPL-2.0-only or LGPL-2.1-only)
+ *
+ * lttng-test-write-bench.c
+ *
+ * LTTng ring buffer write microbenchmark.
+ *
+ * Writing a number of iterations to /proc/lttng-test-write-bench emits
+ * that many events of each lttng_test_write_bench event, and prints the
+ * average cost in ns/event of each fixed and dynamic payload size to
+ * the kernel log. The events must be enabled in a tracing session for
+ * the ring buffer write path to be measured.
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/timekeeping.h>
+#include <linux/math64.h>
+
+#include <lttng/events.h>
+#include <lttng/tracer.h>
+#include <wrapper/tracepoint.h>
+
+#define TP_MODULE_NOAUTOLOAD
+#define LTTNG_PACKAGE_BUILD
+#define CREATE_TRACE_POINTS
+#define TRACE_INCLUDE_PATH instrumentation/events
+#define TRACE_INCLUDE_FILE lttng-test-write-bench
+#define LTTNG_INSTRUMENTATION
+#include <instrumentation/events/lttng-test-write-bench.h>
+
+LTTNG_DEFINE_TRACE(lttng_test_write_bench_u8,
+	PARAMS(uint8_t value),
+	PARAMS(value)
+);
+
+LTTNG_DEFINE_TRACE(lttng_test_write_bench_u64,
+	PARAMS(uint64_t value),
+	PARAMS(value)
+);
+
+LTTNG_DEFINE_TRACE(lttng_test_write_bench_array64,
+	PARAMS(const uint64_t *values),
+	PARAMS(values)
+);
+
+LTTNG_DEFINE_TRACE(lttng_test_write_bench_sequence,
+	PARAMS(const char *buf, size_t len),
+	PARAMS(buf, len)
+);
+
+#define LTTNG_TEST_WRITE_BENCH_FILE	"lttng-test-write-bench"
+
+/* Largest dynamic payload, spans more than one page. */
+#define LTTNG_TEST_WRITE_BENCH_MAX_LEN	8192
+
+/* Iterations between rescheduling points. */
+#define LTTNG_TEST_WRITE_BENCH_BATCH	1024
+
+static struct proc_dir_entry *lttng_test_write_bench_dentry;
+
+static char bench_buf[LTTNG_TEST_WRITE_BENCH_MAX_LEN];
+
+/* Dynamic payload sizes, from a few bytes to page-crossing writes. */
+static const size_t bench_sequence_len[] = {
+	1, 16, 64, 256, 1024, 4096, LTTNG_TEST_WRITE_BENCH_MAX_LEN,
+};
+
+static
+void bench_report(const char *name, size_t len, unsigned int nr_iter,
+		u64 start_ns)
+{
+	u64 delta_ns = ktime_get_ns() - start_ns;
+
+	printk(KERN_INFO "LTTng: write bench: %s (%zu bytes): %llu ns/event\n",
+		name, len, div_u64(delta_ns, nr_iter));
+}
+
+static
+void bench_run(unsigned int nr_iter)
+{
+	uint64_t values[8] = { 0 };
+	unsigned int i, j;
+	u64 start_ns;
+
+	start_ns = ktime_get_ns();
+	for (i = 0; i < nr_iter; i++) {
+		trace_lttng_test_write_bench_u8((uint8_t) i);
+		if (!(i % LTTNG_TEST_WRITE_BENCH_BATCH))
+			cond_resched();
+	}
+	bench_report("fixed u8", sizeof(uint8_t), nr_iter, start_ns);
+
+	start_ns = ktime_get_ns();
+	for (i = 0; i < nr_iter; i++) {
+		trace_lttng_test_write_bench_u64(i);
+		if (!(i % LTTNG_TEST_WRITE_BENCH_BATCH))
+			cond_resched();
+	}
+	bench_report("fixed u64", sizeof(uint64_t), nr_iter, start_ns);
+
+	start_ns = ktime_get_ns();
+	for (i = 0; i < nr_iter; i++) {
+		values[0] = i;
+		trace_lttng_test_write_bench_array64(values);
+		if (!(i % LTTNG_TEST_WRITE_BENCH_BATCH))
+			cond_resched();
+	}
+	bench_report("fixed u64[8]", sizeof(values), nr_iter, start_ns);
+
+	for (j = 0; j < ARRAY_SIZE(bench_sequence_len); j++) {
+		size_t len = bench_sequence_len[j];
+
+		start_ns = ktime_get_ns();
+		for (i = 0; i < nr_iter; i++) {
+			trace_lttng_test_write_bench_sequence(bench_buf, len);
+			if (!(i % LTTNG_TEST_WRITE_BENCH_BATCH))
+				cond_resched();
+		}
+		bench_report("dynamic", len, nr_iter, start_ns);
+	}
+}
+
+/**
+ * lttng_test_write_bench_write - run the write benchmark
+ * @file: file pointer
+ * @user_buf: user string
+ * @count: length to copy
+ *
+ * Return -1 on error, with EFAULT or EINVAL errno. Returns count on success.
+ */
+static
+ssize_t lttng_test_write_bench_write(struct file *file, const char __user *user_buf,
+		    size_t count, loff_t *ppos)
+{
+	unsigned int nr_iter;
+	int ret;
+
+	/* Get the number of iterations */
+	ret = kstrtouint_from_user(user_buf, count, 10, &nr_iter);
+	if (ret)
+		return ret;
+	if (!nr_iter)
+		return -EINVAL;
+	bench_run(nr_iter);
+	*ppos += count;
+	return count;
+}
+
+#if (LTTNG_LINUX_VERSION_CODE >= LTTNG_KERNEL_VERSION(5,6,0))
+static const struct proc_ops lttng_test_write_bench_proc_ops = {
+	.proc_write = lttng_test_write_bench_write,
+};
+#else
+static const struct file_operations lttng_test_write_bench_proc_ops = {
+	.write = lttng_test_write_bench_write,
+};
+#endif
+
+static
+int __init lttng_test_write_bench_init(void)
+{
+	int ret = 0;
+
+	memset(bench_buf, 'x', sizeof(bench_buf));
+	wrapper_vmalloc_sync_mappings();
+	lttng_test_write_bench_dentry =
+			proc_create_data(LTTNG_TEST_WRITE_BENCH_FILE,
+				S_IWUSR, NULL,
+				&lttng_test_write_bench_proc_ops, NULL);
+	if (!lttng_test_write_bench_dentry) {
+		printk(KERN_ERR "Error creating LTTng write bench file\n");
+		ret = -ENOMEM;
+		goto error;
+	}
+	ret = __lttng_events_init__lttng_test_write_bench();
+	if (ret)
+		goto error_events;
+	return ret;
+
+error_events:
+	remove_proc_entry(LTTNG_TEST_WRITE_BENCH_FILE, NULL);
+error:
+	return ret;
+}
+
+module_init(lttng_test_write_bench_init);
+
+static
+void __exit lttng_test_write_bench_exit(void)
+{
+	__lttng_events_exit__lttng_test_write_bench();
+	if (lttng_test_write_bench_dentry)
+		remove_proc_entry(LTTNG_TEST_WRITE_BENCH_FILE, NULL);
+}
+
+module_exit(lttng_test_write_bench_exit);
+
+MODULE_LICENSE("GPL and additional rights");
+MODULE_DESCRIPTION("LTTng ring buffer write benchmark");
+MODULE_VERSION(__stringify(LTTNG_MODULES_MAJOR_VERSION) "."
+	__stringify(LTTNG_MODULES_MINOR_VERSION) "."
+	__stringify(LTTNG_MODULES_PATCHLEVEL_VERSION)
+	LTTNG_MODULES_EXTRAVERSION);